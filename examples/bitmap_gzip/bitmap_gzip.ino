@@ -13,6 +13,17 @@
 
 BB_SPI_LCD lcd;
 zlib_turbo zt;
+zt_rows rows;
+uint8_t ucRow[200]; // one row of 100 RGB565 pixels
+
+//
+// Called with each row of pixels as soon as it's decoded and byte-swapped
+//
+int DrawRow(void *pUser, int iRow, uint8_t *pRow, int iLen)
+{
+  lcd.pushImage(110, 100 + iRow, iLen / 2, 1, (uint16_t *)pRow);
+  return 1; // keep going
+} /* DrawRow() */
 
 void setup()
 {
@@ -32,23 +43,33 @@ void setup()
   iUncompSize = zt.gzip_info((uint8_t *)cogwheel_100x100, sizeof(cogwheel_100x100));
   if (iUncompSize > 0) {
     lcd.printf("uncompressed size = %d\n", iUncompSize);
-    // Allocate a buffer to hold the data; the extra 4 bytes is because of an optimization
-    // in zlib_turbo that writes unaligned longs when possible to speed up decoding
-    pUncompressed = (uint8_t *)malloc(iUncompSize+4);
+    // Allocate a buffer to hold the data
+    pUncompressed = (uint8_t *)malloc(iUncompSize);
     // Measure the decode time in microseconds
     l = micros();
     rc = zt.gunzip((uint8_t *)cogwheel_100x100, sizeof(cogwheel_100x100), pUncompressed);
     l = micros() - l;
     lcd.printf("decoded in %d microsecs\n", (int)l);
     if (rc == ZT_SUCCESS) { 
-        uint16_t *p16 = (uint16_t *)pUncompressed;
-        for (int i=0; i<iUncompSize/sizeof(uint16_t); i++) { // convert to big endian for bb_spi_lcd
-          p16[i] = __builtin_bswap16(p16[i]);
-        }
+        zt_swap16(pUncompressed, iUncompSize); // convert to big endian for bb_spi_lcd
         // Display raw RGB565 pixels (x, y, width, height, source_pointer)
         lcd.pushImage(0, 100, 100, 100,(uint16_t *)pUncompressed);
     } // successful decode
     free(pUncompressed);
+    // Now decode it again, straight to the display one row at a time.
+    // The pixels are byte-swapped as each row completes, so there's no
+    // second pass over the image and only the 32K window + a small chunk
+    // of memory is needed no matter how large the image is
+    uint8_t *pWindow = (uint8_t *)malloc(ZT_MAX_WINDOW + 2000);
+    if (pWindow) {
+      zt_init_rows(&rows, ucRow, sizeof(ucRow), DrawRow, zt_swap16, NULL);
+      l = micros();
+      rc = zt.gunzip((uint8_t *)cogwheel_100x100, sizeof(cogwheel_100x100), pWindow, &pWindow[ZT_MAX_WINDOW], 2000, &rows);
+      l = micros() - l;
+      lcd.setCursor(0, 208);
+      lcd.printf("decoded + drawn by row in %d us\n", (int)l);
+      free(pWindow);
+    }
   } // valid gzip
 } // setup
 
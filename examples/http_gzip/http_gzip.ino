@@ -57,7 +57,7 @@ WiFiClient * stream;
           iPayloadSize = http.getSize();
           Serial.printf("payload size = %d\n", iPayloadSize);
           // Allocate a buffer to receive the compressed (gzip) response
-          pCompressed = (uint8_t *)malloc(iPayloadSize+8); // allow a little extra for reading past the end
+          pCompressed = (uint8_t *)malloc(iPayloadSize);
           l = millis();
           stream = http.getStreamPtr();
           iCount = 0;
@@ -73,12 +73,13 @@ WiFiClient * stream;
           http.end(); // we're done, close the connection
           // I tried parsing the HTTP response headers, but the HTTPClient library
           // seemed to crash when I did that, so we'll just look for the gzip
-          // file signature
-          if (pCompressed[0] == 0x1f && pCompressed[1] == 0x8b) {
+          // file header (a zlib or raw deflate response could be decoded
+          // with zt.inflate_auto() instead)
+          if (zt.detect_format(pCompressed, iPayloadSize) == ZT_FORMAT_GZIP) {
             Serial.println("It's a gzip file!");
             iUncompSize = zt.gzip_info(pCompressed, iPayloadSize);
             if (iUncompSize > 0) {
-               pUncompressed = (uint8_t *)malloc(iUncompSize+8);
+               pUncompressed = (uint8_t *)malloc(iUncompSize);
                int rc = zt.gunzip(pCompressed, iPayloadSize, pUncompressed);
                if (rc == ZT_SUCCESS) {
                   Serial.printf("Uncompressed size = %d bytes\n", iUncompSize);
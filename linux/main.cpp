@@ -0,0 +1,616 @@
+//
+// zlib_turbo benchmark for Linux
+// Decodes a corpus of deflate streams with zlib_turbo, the system zlib and
+// (if they can be loaded at run time) zlib-ng and libdeflate, and reports
+// the speed of each in MB/s of output and CPU cycles per output byte.
+//
+// Copyright (C) 2024 BitBank Software, Inc.
+//
+// The built-in corpus is generated from fixed seeds, so the numbers only
+// change when the code or the machine does. Add the Silesia or Canterbury
+// files (or any others) by naming them or their directories on the
+// command line. Every stream is compressed by the system zlib, so each
+// decoder sees exactly the same data.
+//
+// Build it with "make STATS=1" to see zt_inflate's statistics for each
+// stream (see ZT_STATS) under its line of results.
+//
+// usage: zt_bench [-l levels] [-s sizes] [-t secs] [-c cpu] [-csv] [-nobuiltin] [files/dirs...]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <dlfcn.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <zlib.h>
+#include "../src/zlib_turbo.h"
+#include "../examples/bitmap_gzip/cogwheel_100x100.h"
+
+#define MAX_ITEMS 256
+#define MAX_LEVELS 10
+#define MAX_SIZES 8
+#define REPS 5 // timed runs of each decoder; the fastest one is reported
+
+// One corpus entry (a file or a generated data set)
+typedef struct bench_item_tag {
+    char szName[32];
+    uint8_t *pData;
+    size_t iSize;
+} bench_item;
+
+// A compressed test case; the zlib stream is also wrapped as gzip
+typedef struct bench_stream_tag {
+    uint8_t *pData;     // original data
+    size_t iSize;
+    uint8_t *pZlib;     // zlib stream (Adler-32)
+    size_t iZlibSize;
+    uint8_t *pGzip;     // gzip stream of the same deflate data (CRC-32)
+    size_t iGzipSize;
+} bench_stream;
+
+typedef int (DECODE_FUNC)(bench_stream *pStream, uint8_t *pOut);
+
+typedef struct bench_decoder_tag {
+    const char *szName;
+    DECODE_FUNC *pfnDecode;
+    int bAvailable;
+    double dLogRatio[2]; // sums of log(zt speed / this speed) for the summary
+    int iCompared;
+} bench_decoder;
+
+// libdeflate and zlib-ng are optional and are loaded with dlopen(), so the
+// benchmark builds without their headers
+typedef void * (LIBDEFLATE_ALLOC)(void);
+typedef int (LIBDEFLATE_ZLIB)(void *d, const void *in, size_t in_nbytes, void *out, size_t out_nbytes_avail, size_t *actual_out_nbytes_ret);
+typedef int32_t (ZNG_UNCOMPRESS)(uint8_t *dest, size_t *destLen, const uint8_t *source, size_t sourceLen);
+typedef const char * (ZNG_VERSION)(void);
+
+static void *pLibdeflate;
+static LIBDEFLATE_ZLIB *pfnLibdeflateZlib;
+static ZNG_UNCOMPRESS *pfnZngUncompress;
+static ZNG_VERSION *pfnZngVersion;
+static zt_state ztState;
+static bench_item items[MAX_ITEMS];
+static int iItemCount;
+static int iPerfFD = -1;
+static const char *szCycleSource = "none";
+//
+// Decoders under test. Each one decodes pStream into pOut and returns 0
+// for success. All but zt_gunzip read the zlib stream and verify its
+// Adler-32; zt_gunzip reads the gzip version and verifies the CRC-32.
+//
+static int decode_zt_gunzip(bench_stream *pStream, uint8_t *pOut)
+{
+    return zt_gunzip_verify(pStream->pGzip, (int)pStream->iGzipSize, pOut);
+} /* decode_zt_gunzip() */
+
+static int decode_zt_inflate(bench_stream *pStream, uint8_t *pOut)
+{
+    zt_buffer buffer;
+
+    zt_reset(&ztState);
+    zt_init_check(&ztState, ZT_CHECK_ADLER32);
+    buffer.next_in = pStream->pZlib;
+    buffer.avail_in = (uint32_t)pStream->iZlibSize;
+    buffer.total_in = 0;
+    buffer.next_out = pOut;
+    buffer.avail_out = (uint32_t)pStream->iSize;
+    buffer.total_out = 0;
+    return zt_inflate(&ztState, &buffer, 1);
+} /* decode_zt_inflate() */
+
+static int decode_zlib(bench_stream *pStream, uint8_t *pOut)
+{
+    uLongf ulOutSize = (uLongf)pStream->iSize;
+
+    return uncompress(pOut, &ulOutSize, pStream->pZlib, (uLong)pStream->iZlibSize);
+} /* decode_zlib() */
+
+static int decode_zlib_ng(bench_stream *pStream, uint8_t *pOut)
+{
+    size_t iOutSize = pStream->iSize;
+
+    return (int)(*pfnZngUncompress)(pOut, &iOutSize, pStream->pZlib, pStream->iZlibSize);
+} /* decode_zlib_ng() */
+
+static int decode_libdeflate(bench_stream *pStream, uint8_t *pOut)
+{
+    size_t iOutSize;
+
+    return (*pfnLibdeflateZlib)(pLibdeflate, pStream->pZlib, pStream->iZlibSize, pOut, pStream->iSize, &iOutSize);
+} /* decode_libdeflate() */
+
+static bench_decoder decoders[] = {
+    {"zt_gunzip", decode_zt_gunzip, 1, {0.0, 0.0}, 0},
+    {"zt_inflate", decode_zt_inflate, 1, {0.0, 0.0}, 0},
+    {"zlib", decode_zlib, 1, {0.0, 0.0}, 0},
+    {"zlib-ng", decode_zlib_ng, 0, {0.0, 0.0}, 0},
+    {"libdeflate", decode_libdeflate, 0, {0.0, 0.0}, 0}
+};
+#define DECODER_COUNT (int)(sizeof(decoders) / sizeof(decoders[0]))
+#define ZT_DECODERS 2 // the first 2 are ours; the summary compares them to the rest
+//
+// Load the optional libraries
+//
+static void load_libraries(void)
+{
+    void *pLib;
+    LIBDEFLATE_ALLOC *pfnAlloc;
+
+    pLib = dlopen("libdeflate.so.0", RTLD_NOW);
+    if (pLib == NULL) pLib = dlopen("libdeflate.so", RTLD_NOW);
+    if (pLib) {
+        pfnAlloc = (LIBDEFLATE_ALLOC *)dlsym(pLib, "libdeflate_alloc_decompressor");
+        pfnLibdeflateZlib = (LIBDEFLATE_ZLIB *)dlsym(pLib, "libdeflate_zlib_decompress");
+        if (pfnAlloc && pfnLibdeflateZlib) {
+            pLibdeflate = (*pfnAlloc)();
+            decoders[4].bAvailable = (pLibdeflate != NULL);
+        }
+    }
+    pLib = dlopen("libz-ng.so.2", RTLD_NOW);
+    if (pLib == NULL) pLib = dlopen("libz-ng.so", RTLD_NOW);
+    if (pLib) {
+        pfnZngUncompress = (ZNG_UNCOMPRESS *)dlsym(pLib, "zng_uncompress");
+        pfnZngVersion = (ZNG_VERSION *)dlsym(pLib, "zlibng_version");
+        decoders[3].bAvailable = (pfnZngUncompress != NULL);
+    }
+} /* load_libraries() */
+//
+// Cycle counting; the core's own cycle counter through perf if the kernel
+// allows it, otherwise the x86 time stamp counter (which ticks at a fixed
+// rate, so it's only comparable between runs at the same clock speed)
+//
+static void init_cycles(void)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    iPerfFD = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (iPerfFD >= 0) {
+        szCycleSource = "perf cpu-cycles";
+    } else {
+#if defined(__x86_64__) || defined(__i386__)
+        szCycleSource = "rdtsc";
+#endif
+    }
+} /* init_cycles() */
+
+static uint64_t read_cycles(void)
+{
+    uint64_t u64 = 0;
+
+    if (iPerfFD >= 0) {
+        if (read(iPerfFD, &u64, sizeof(u64)) != sizeof(u64)) u64 = 0;
+        return u64;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    u64 = __rdtsc();
+#endif
+    return u64;
+} /* read_cycles() */
+
+#ifdef ZT_STATS
+//
+// Decode a stream once more and show zt_inflate's statistics for it
+//
+static void print_stats(bench_stream *pStream, uint8_t *pOut)
+{
+    zt_stats *pStats = &ztState.stats;
+    uint64_t u64Pattern;
+    int i;
+
+    memset(pStats, 0, sizeof(zt_stats));
+    decode_zt_inflate(pStream, pOut);
+    u64Pattern = pStats->u64Copies[ZT_COPY_PATTERN];
+    printf("#   blocks %d/%d/%d (stored/fixed/dynamic), %.1f%% literals, avg match %.1f, %.1f%% pattern copies, 2nd level %d/%d, %d refills, tables %d (+%d cached) in %d ticks\n",
+           (int)pStats->u64Blocks[0], (int)pStats->u64Blocks[1], (int)pStats->u64Blocks[2],
+           100.0 * (double)pStats->u64Literals / (double)(pStream->iSize ? pStream->iSize : 1),
+           pStats->u64Matches ? (double)pStats->u64MatchBytes / (double)pStats->u64Matches : 0.0,
+           pStats->u64Matches ? 100.0 * (double)u64Pattern / (double)pStats->u64Matches : 0.0,
+           (int)pStats->u64LenLinks, (int)pStats->u64DistLinks, (int)pStats->u64Refills,
+           (int)pStats->u64TablesBuilt, (int)pStats->u64TableHits, (int)pStats->u64TableTicks);
+    printf("#   lengths");
+    for (i = 1; i < 9; i++) printf(" %d", (int)pStats->u64LenHist[i]);
+    printf(", distances");
+    for (i = 0; i < 16; i++) printf(" %d", (int)pStats->u64DistHist[i]);
+    printf(" (by power of 2)\n");
+} /* print_stats() */
+#endif
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+} /* seconds() */
+//
+// Deterministic pseudo-random numbers for the generated corpus
+//
+static uint32_t u32Seed;
+static uint32_t next_random(void)
+{
+    u32Seed ^= u32Seed << 13;
+    u32Seed ^= u32Seed >> 17;
+    u32Seed ^= u32Seed << 5;
+    return u32Seed;
+} /* next_random() */
+
+static bench_item *add_item(const char *szName, size_t iSize)
+{
+    bench_item *pItem;
+
+    if (iItemCount >= MAX_ITEMS) return NULL;
+    pItem = &items[iItemCount++];
+    snprintf(pItem->szName, sizeof(pItem->szName), "%s", szName);
+    pItem->pData = (uint8_t *)malloc(iSize ? iSize : 1);
+    pItem->iSize = iSize;
+    return pItem;
+} /* add_item() */
+//
+// Generate the built-in corpus
+//
+static void add_builtin(void)
+{
+    static const char *szWords[] = {"the", "of", "and", "to", "in", "a", "is", "that", "for", "it",
+        "as", "was", "with", "be", "by", "on", "not", "he", "this", "are", "or", "his", "from", "at",
+        "which", "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we",
+        "can", "her", "has", "there", "been", "if", "more", "when", "will", "would", "who", "so",
+        "compression", "window", "literal", "distance", "stream", "decoder", "buffer", "table",
+        "performance", "benchmark", "throughput", "latency", "memory", "cache", "branch", "register"};
+    const int iWordCount = (int)(sizeof(szWords) / sizeof(szWords[0]));
+    bench_item *pItem;
+    uint16_t *pPixels;
+    size_t i, iLen;
+    int x, y, iWord;
+    z_stream zs;
+
+    // English-like text with a skewed word distribution
+    u32Seed = 0x12345678;
+    pItem = add_item("text", 1 << 20);
+    for (i = 0; i < pItem->iSize; ) {
+        iWord = (int)((next_random() % iWordCount) * (next_random() % iWordCount) / iWordCount);
+        iLen = strlen(szWords[iWord]);
+        if (i + iLen + 2 > pItem->iSize) break;
+        memcpy(&pItem->pData[i], szWords[iWord], iLen);
+        i += iLen;
+        x = next_random() & 63;
+        pItem->pData[i++] = (x == 0) ? '\n' : (x < 4) ? ',' : ' ';
+        if (x == 0) pItem->pData[i++] = '\n';
+    }
+    memset(&pItem->pData[i], ' ', pItem->iSize - i);
+    // The RGB565 bitmap from the bitmap_gzip example
+    pItem = add_item("cogwheel565", 100*100*2);
+    memset(&zs, 0, sizeof(zs));
+    inflateInit2(&zs, 16 + MAX_WBITS);
+    zs.next_in = (Bytef *)cogwheel_100x100;
+    zs.avail_in = sizeof(cogwheel_100x100);
+    zs.next_out = pItem->pData;
+    zs.avail_out = (uInt)pItem->iSize;
+    inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+    // A larger RGB565 screen: gradient background, flat boxes and some noise
+    pItem = add_item("screen565", 320*240*2);
+    pPixels = (uint16_t *)pItem->pData;
+    for (y = 0; y < 240; y++) {
+        for (x = 0; x < 320; x++) {
+            uint16_t us = (uint16_t)(((y * 31 / 239) << 11) | ((x * 63 / 319) << 5) | 8);
+            if ((x / 40 + y / 30) % 3 == 0 && (x % 40) > 4 && (y % 30) > 4) us = 0xffff; // boxes
+            if ((next_random() & 15) == 0) us ^= (uint16_t)(next_random() & 0x0821); // noise
+            pPixels[y * 320 + x] = us;
+        }
+    }
+    // Highly repetitive: a short record repeated with rare changes
+    pItem = add_item("repeat", 1 << 20);
+    for (i = 0; i < pItem->iSize; i++) {
+        pItem->pData[i] = "All work and no play makes Jack a dull boy. "[i % 45];
+        if ((i & 4095) == 4095) pItem->pData[i] = (uint8_t)next_random();
+    }
+    pItem = add_item("zeros", 1 << 20);
+    memset(pItem->pData, 0, pItem->iSize);
+    // Incompressible, so every level writes stored blocks
+    pItem = add_item("random", 1 << 20);
+    for (i = 0; i < pItem->iSize; i++) {
+        pItem->pData[i] = (uint8_t)(next_random() >> 24);
+    }
+} /* add_builtin() */
+//
+// Add a file, or all of the regular files in a directory
+//
+static void add_path(const char *szPath)
+{
+    struct stat st;
+    char szFile[1024];
+    struct dirent *pEntry;
+    bench_item *pItem;
+    const char *szName;
+    DIR *pDir;
+    FILE *f;
+
+    if (stat(szPath, &st) != 0) {
+        fprintf(stderr, "Can't open %s\n", szPath);
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        pDir = opendir(szPath);
+        if (pDir == NULL) return;
+        while ((pEntry = readdir(pDir)) != NULL) {
+            if (pEntry->d_name[0] == '.') continue;
+            snprintf(szFile, sizeof(szFile), "%s/%s", szPath, pEntry->d_name);
+            if (stat(szFile, &st) == 0 && S_ISREG(st.st_mode)) add_path(szFile);
+        }
+        closedir(pDir);
+        return;
+    }
+    if (st.st_size >= 0x7fffffff) { // zt_gunzip() takes an int size
+        fprintf(stderr, "Skipping %s, it's too large\n", szPath);
+        return;
+    }
+    szName = strrchr(szPath, '/');
+    szName = szName ? szName + 1 : szPath;
+    pItem = add_item(szName, (size_t)st.st_size);
+    if (pItem == NULL) return;
+    f = fopen(szPath, "rb");
+    if (f == NULL || fread(pItem->pData, 1, pItem->iSize, f) != pItem->iSize) {
+        fprintf(stderr, "Error reading %s\n", szPath);
+        iItemCount--;
+        free(pItem->pData);
+    }
+    if (f) fclose(f);
+} /* add_path() */
+//
+// Compress iSize bytes with the system zlib, then wrap the same deflate data
+// in a gzip header and trailer
+//
+static int make_stream(bench_stream *pStream, uint8_t *pData, size_t iSize, int iLevel)
+{
+    uLongf ulSize;
+    uint32_t u32;
+    size_t iDeflate;
+
+    pStream->pData = pData;
+    pStream->iSize = iSize;
+    ulSize = compressBound((uLong)iSize);
+    pStream->pZlib = (uint8_t *)malloc(ulSize);
+    if (compress2(pStream->pZlib, &ulSize, pData, (uLong)iSize, iLevel) != Z_OK) {
+        free(pStream->pZlib);
+        return 0;
+    }
+    pStream->iZlibSize = ulSize;
+    iDeflate = ulSize - 6; // no 2 byte header or 4 byte Adler-32
+    pStream->pGzip = (uint8_t *)malloc(iDeflate + 18);
+    memcpy(pStream->pGzip, "\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\x03", 10);
+    memcpy(&pStream->pGzip[10], &pStream->pZlib[2], iDeflate);
+    u32 = (uint32_t)crc32(0, pData, (uInt)iSize);
+    memcpy(&pStream->pGzip[10 + iDeflate], &u32, 4);
+    u32 = (uint32_t)iSize;
+    memcpy(&pStream->pGzip[14 + iDeflate], &u32, 4);
+    pStream->iGzipSize = iDeflate + 18;
+    return 1;
+} /* make_stream() */
+//
+// Time one decoder on one stream. It runs enough times for each of the REPS
+// timings to take about dTime/REPS seconds and the fastest is kept.
+// Returns 0 if the decoder failed or its output was wrong.
+//
+static int bench_one(bench_decoder *pDec, bench_stream *pStream, uint8_t *pOut, double dTime, double *pdMBs, double *pdCycles)
+{
+    double d, dBest = 1e30;
+    uint64_t u64, u64Best = 0;
+    int i, iRep, iIters;
+
+    memset(pOut, 0xa5, pStream->iSize);
+    if ((*pDec->pfnDecode)(pStream, pOut) != 0 || memcmp(pOut, pStream->pData, pStream->iSize) != 0) {
+        return 0;
+    }
+    d = seconds();
+    (*pDec->pfnDecode)(pStream, pOut);
+    d = seconds() - d;
+    iIters = (int)(dTime / REPS / (d > 1e-9 ? d : 1e-9));
+    if (iIters < 1) iIters = 1;
+    for (iRep = 0; iRep < REPS; iRep++) {
+        u64 = read_cycles();
+        d = seconds();
+        for (i = 0; i < iIters; i++) {
+            (*pDec->pfnDecode)(pStream, pOut);
+        }
+        d = (seconds() - d) / iIters;
+        u64 = (read_cycles() - u64) / iIters;
+        if (d < dBest) {
+            dBest = d;
+            u64Best = u64;
+        }
+    }
+    *pdMBs = (double)pStream->iSize / dBest / 1e6;
+    *pdCycles = (double)u64Best / (double)pStream->iSize;
+    return 1;
+} /* bench_one() */
+
+static int parse_list(const char *szList, size_t *pList, int iMax, int bSizes)
+{
+    int iCount = 0;
+    char *szEnd;
+    size_t i;
+
+    while (*szList && iCount < iMax) {
+        if (bSizes && strncmp(szList, "all", 3) == 0) {
+            i = 0;
+            szEnd = (char *)szList + 3;
+        } else {
+            i = (size_t)strtoul(szList, &szEnd, 10);
+            if (szEnd == szList) break;
+            if (*szEnd == 'K' || *szEnd == 'k') { i <<= 10; szEnd++; }
+            else if (*szEnd == 'M' || *szEnd == 'm') { i <<= 20; szEnd++; }
+        }
+        pList[iCount++] = i;
+        szList = (*szEnd == ',') ? szEnd + 1 : szEnd;
+    }
+    return iCount;
+} /* parse_list() */
+
+static void print_system(void)
+{
+    char szLine[256], *s;
+    FILE *f;
+    int i;
+
+    f = fopen("/proc/cpuinfo", "r");
+    if (f) {
+        while (fgets(szLine, sizeof(szLine), f)) {
+            if (strncmp(szLine, "model name", 10) == 0) {
+                s = strchr(szLine, ':');
+                printf("# cpu: %s", s ? s + 2 : szLine);
+                break;
+            }
+        }
+        fclose(f);
+    }
+    printf("# compiler: %s\n", __VERSION__);
+    printf("# zlib %s", zlibVersion());
+    if (pfnZngVersion) printf(", zlib-ng %s", (*pfnZngVersion)());
+    printf(", libdeflate %s\n", decoders[4].bAvailable ? "loaded" : "not found");
+    printf("# cycles: %s\n", szCycleSource);
+    printf("# decoders:");
+    for (i = 0; i < DECODER_COUNT; i++) {
+        if (decoders[i].bAvailable) printf(" %s", decoders[i].szName);
+    }
+    printf("\n");
+} /* print_system() */
+
+int main(int argc, char *argv[])
+{
+    size_t levels[MAX_LEVELS] = {1, 6, 9}, sizes[MAX_SIZES] = {4096, 65536, 1 << 20, 0};
+    int iLevelCount = 3, iSizeCount = 4;
+    int i, j, k, l, bCSV = 0, bBuiltin = 1, iCPU = -1;
+    double dTime = 0.1, dMBs[DECODER_COUNT], dCycles[DECODER_COUNT];
+    int bOK[DECODER_COUNT];
+    bench_stream stream;
+    size_t iSize;
+    uint8_t *pOut;
+    cpu_set_t cpus;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            iLevelCount = parse_list(argv[++i], levels, MAX_LEVELS, 0);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            iSizeCount = parse_list(argv[++i], sizes, MAX_SIZES, 1);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            dTime = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            iCPU = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-csv") == 0) {
+            bCSV = 1;
+        } else if (strcmp(argv[i], "-nobuiltin") == 0) {
+            bBuiltin = 0;
+        } else if (argv[i][0] == '-') {
+            printf("usage: %s [-l levels] [-s sizes] [-t secs] [-c cpu] [-csv] [-nobuiltin] [files/dirs...]\n", argv[0]);
+            printf("  -l  zlib compression levels to test (default 1,6,9)\n");
+            printf("  -s  sizes to cut each input to, K/M suffixes or 'all' (default 4K,64K,1M,all)\n");
+            printf("  -t  seconds to spend timing each decoder on each stream (default 0.1)\n");
+            printf("  -c  pin the benchmark to this cpu\n");
+            printf("  -csv  one line of comma separated values per result\n");
+            printf("  -nobuiltin  only test the named files\n");
+            return 0;
+        } else {
+            add_path(argv[i]);
+        }
+    }
+    if (iCPU >= 0) {
+        CPU_ZERO(&cpus);
+        CPU_SET(iCPU, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "Can't pin to cpu %d\n", iCPU);
+        }
+    }
+    if (bBuiltin) add_builtin();
+    load_libraries();
+    init_cycles();
+    zt_init(&ztState);
+    print_system();
+    if (bCSV) {
+        printf("corpus,size,level,compressed,decoder,MB/s,cycles/byte\n");
+    } else {
+        printf("%-14s %9s %3s %6s", "corpus", "size", "lvl", "ratio");
+        for (j = 0; j < DECODER_COUNT; j++) {
+            if (decoders[j].bAvailable) printf(" %15s", decoders[j].szName);
+        }
+        printf("   (MB/s  cycles/byte)\n");
+    }
+    for (i = 0; i < iItemCount; i++) {
+        pOut = (uint8_t *)malloc(items[i].iSize ? items[i].iSize : 1);
+        for (k = 0; k < iSizeCount; k++) {
+            iSize = sizes[k];
+            if (iSize == 0) {
+                iSize = items[i].iSize;
+                if (k > 0 && sizes[k-1] == iSize) continue; // already done
+            } else if (iSize > items[i].iSize) {
+                continue;
+            }
+            for (l = 0; l < iLevelCount; l++) {
+                if (!make_stream(&stream, items[i].pData, iSize, (int)levels[l])) continue;
+                for (j = 0; j < DECODER_COUNT; j++) {
+                    bOK[j] = decoders[j].bAvailable && bench_one(&decoders[j], &stream, pOut, dTime, &dMBs[j], &dCycles[j]);
+                    if (decoders[j].bAvailable && !bOK[j]) {
+                        fprintf(stderr, "%s failed on %s (size %d, level %d)\n", decoders[j].szName, items[i].szName, (int)iSize, (int)levels[l]);
+                    }
+                }
+                if (bOK[0] && bOK[1]) {
+                    for (j = ZT_DECODERS; j < DECODER_COUNT; j++) {
+                        if (bOK[j]) {
+                            decoders[j].dLogRatio[0] += log(dMBs[0] / dMBs[j]);
+                            decoders[j].dLogRatio[1] += log(dMBs[1] / dMBs[j]);
+                            decoders[j].iCompared++;
+                        }
+                    }
+                }
+                if (bCSV) {
+                    for (j = 0; j < DECODER_COUNT; j++) {
+                        if (!decoders[j].bAvailable) continue;
+                        printf("%s,%d,%d,%d,%s", items[i].szName, (int)iSize, (int)levels[l], (int)stream.iZlibSize, decoders[j].szName);
+                        if (bOK[j]) printf(",%.1f,%.2f\n", dMBs[j], dCycles[j]);
+                        else printf(",FAIL,\n");
+                    }
+                } else {
+                    printf("%-14s %9d %3d %6.2f", items[i].szName, (int)iSize, (int)levels[l], (double)iSize / (double)stream.iZlibSize);
+                    for (j = 0; j < DECODER_COUNT; j++) {
+                        if (!decoders[j].bAvailable) continue;
+                        if (bOK[j]) printf(" %8.1f %6.2f", dMBs[j], dCycles[j]);
+                        else printf(" %15s", "FAIL");
+                    }
+                    printf("\n");
+#ifdef ZT_STATS
+                    print_stats(&stream, pOut);
+#endif
+                }
+                fflush(stdout);
+                free(stream.pZlib);
+                free(stream.pGzip);
+            }
+        }
+        free(pOut);
+    }
+    if (!bCSV) {
+        for (j = ZT_DECODERS; j < DECODER_COUNT; j++) {
+            if (decoders[j].iCompared) {
+                printf("# speed vs %s (geometric mean of %d tests): zt_gunzip %.2fx, zt_inflate %.2fx\n", decoders[j].szName, decoders[j].iCompared,
+                       exp(decoders[j].dLogRatio[0] / decoders[j].iCompared), exp(decoders[j].dLogRatio[1] / decoders[j].iCompared));
+            }
+        }
+    }
+    return 0;
+} /* main() */
@@ -33,6 +33,58 @@
 */
 
 #include "zlib_turbo.h"
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__PCLMUL__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+#ifdef ZT_THREADS
+#include <thread>
+#include <atomic>
+#endif
+#ifdef ZT_FILES
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef ZT_STATS
+// Timer for zt_stats.u64TableTicks; TSC cycles on x86, the virtual counter
+// on AArch64, microseconds on Arduino and clock() ticks anywhere else
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ZT_TICKS() __rdtsc()
+#elif defined(__aarch64__) && defined(__GNUC__)
+static inline uint64_t zt_ticks(void)
+{
+    uint64_t u64;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(u64));
+    return u64;
+} /* zt_ticks() */
+#define ZT_TICKS() zt_ticks()
+#elif defined(ARDUINO)
+#define ZT_TICKS() micros()
+#else
+#include <time.h>
+#define ZT_TICKS() (uint64_t)clock()
+#endif
+#endif // ZT_STATS
+#ifdef __GNUC__
+#define ZT_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ZT_ALWAYS_INLINE inline
+#endif
+#ifdef ZT_DISPATCH
+// The decoder is compiled into each of the CPU specific versions
+#define ZT_DECODER_BODY static ZT_ALWAYS_INLINE
+#else
+#define ZT_DECODER_BODY static
+#endif
 
 static const uint8_t len_order[19] = /* permutation of code lengths */
     {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
@@ -123,6 +175,375 @@ static const code distfix[32] = {
     {16,5,4},{24,5,769},{20,5,49},{28,5,12289},{18,5,13},{26,5,3073},
     {22,5,193},{64,5,0}
 };
+//
+// CRC-32 (gzip) tables for the slicing-by-8 method; table[0] is the normal
+// byte-at-a-time table and table[k] advances a byte through k more zeros
+//
+static const uint32_t zt_crc_table[CRC_SLICES][256] = {
+  {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+  }
+#if CRC_SLICES == 8
+  ,
+  {
+    0x00000000, 0x191b3141, 0x32366282, 0x2b2d53c3, 0x646cc504, 0x7d77f445,
+    0x565aa786, 0x4f4196c7, 0xc8d98a08, 0xd1c2bb49, 0xfaefe88a, 0xe3f4d9cb,
+    0xacb54f0c, 0xb5ae7e4d, 0x9e832d8e, 0x87981ccf, 0x4ac21251, 0x53d92310,
+    0x78f470d3, 0x61ef4192, 0x2eaed755, 0x37b5e614, 0x1c98b5d7, 0x05838496,
+    0x821b9859, 0x9b00a918, 0xb02dfadb, 0xa936cb9a, 0xe6775d5d, 0xff6c6c1c,
+    0xd4413fdf, 0xcd5a0e9e, 0x958424a2, 0x8c9f15e3, 0xa7b24620, 0xbea97761,
+    0xf1e8e1a6, 0xe8f3d0e7, 0xc3de8324, 0xdac5b265, 0x5d5daeaa, 0x44469feb,
+    0x6f6bcc28, 0x7670fd69, 0x39316bae, 0x202a5aef, 0x0b07092c, 0x121c386d,
+    0xdf4636f3, 0xc65d07b2, 0xed705471, 0xf46b6530, 0xbb2af3f7, 0xa231c2b6,
+    0x891c9175, 0x9007a034, 0x179fbcfb, 0x0e848dba, 0x25a9de79, 0x3cb2ef38,
+    0x73f379ff, 0x6ae848be, 0x41c51b7d, 0x58de2a3c, 0xf0794f05, 0xe9627e44,
+    0xc24f2d87, 0xdb541cc6, 0x94158a01, 0x8d0ebb40, 0xa623e883, 0xbf38d9c2,
+    0x38a0c50d, 0x21bbf44c, 0x0a96a78f, 0x138d96ce, 0x5ccc0009, 0x45d73148,
+    0x6efa628b, 0x77e153ca, 0xbabb5d54, 0xa3a06c15, 0x888d3fd6, 0x91960e97,
+    0xded79850, 0xc7cca911, 0xece1fad2, 0xf5facb93, 0x7262d75c, 0x6b79e61d,
+    0x4054b5de, 0x594f849f, 0x160e1258, 0x0f152319, 0x243870da, 0x3d23419b,
+    0x65fd6ba7, 0x7ce65ae6, 0x57cb0925, 0x4ed03864, 0x0191aea3, 0x188a9fe2,
+    0x33a7cc21, 0x2abcfd60, 0xad24e1af, 0xb43fd0ee, 0x9f12832d, 0x8609b26c,
+    0xc94824ab, 0xd05315ea, 0xfb7e4629, 0xe2657768, 0x2f3f79f6, 0x362448b7,
+    0x1d091b74, 0x04122a35, 0x4b53bcf2, 0x52488db3, 0x7965de70, 0x607eef31,
+    0xe7e6f3fe, 0xfefdc2bf, 0xd5d0917c, 0xcccba03d, 0x838a36fa, 0x9a9107bb,
+    0xb1bc5478, 0xa8a76539, 0x3b83984b, 0x2298a90a, 0x09b5fac9, 0x10aecb88,
+    0x5fef5d4f, 0x46f46c0e, 0x6dd93fcd, 0x74c20e8c, 0xf35a1243, 0xea412302,
+    0xc16c70c1, 0xd8774180, 0x9736d747, 0x8e2de606, 0xa500b5c5, 0xbc1b8484,
+    0x71418a1a, 0x685abb5b, 0x4377e898, 0x5a6cd9d9, 0x152d4f1e, 0x0c367e5f,
+    0x271b2d9c, 0x3e001cdd, 0xb9980012, 0xa0833153, 0x8bae6290, 0x92b553d1,
+    0xddf4c516, 0xc4eff457, 0xefc2a794, 0xf6d996d5, 0xae07bce9, 0xb71c8da8,
+    0x9c31de6b, 0x852aef2a, 0xca6b79ed, 0xd37048ac, 0xf85d1b6f, 0xe1462a2e,
+    0x66de36e1, 0x7fc507a0, 0x54e85463, 0x4df36522, 0x02b2f3e5, 0x1ba9c2a4,
+    0x30849167, 0x299fa026, 0xe4c5aeb8, 0xfdde9ff9, 0xd6f3cc3a, 0xcfe8fd7b,
+    0x80a96bbc, 0x99b25afd, 0xb29f093e, 0xab84387f, 0x2c1c24b0, 0x350715f1,
+    0x1e2a4632, 0x07317773, 0x4870e1b4, 0x516bd0f5, 0x7a468336, 0x635db277,
+    0xcbfad74e, 0xd2e1e60f, 0xf9ccb5cc, 0xe0d7848d, 0xaf96124a, 0xb68d230b,
+    0x9da070c8, 0x84bb4189, 0x03235d46, 0x1a386c07, 0x31153fc4, 0x280e0e85,
+    0x674f9842, 0x7e54a903, 0x5579fac0, 0x4c62cb81, 0x8138c51f, 0x9823f45e,
+    0xb30ea79d, 0xaa1596dc, 0xe554001b, 0xfc4f315a, 0xd7626299, 0xce7953d8,
+    0x49e14f17, 0x50fa7e56, 0x7bd72d95, 0x62cc1cd4, 0x2d8d8a13, 0x3496bb52,
+    0x1fbbe891, 0x06a0d9d0, 0x5e7ef3ec, 0x4765c2ad, 0x6c48916e, 0x7553a02f,
+    0x3a1236e8, 0x230907a9, 0x0824546a, 0x113f652b, 0x96a779e4, 0x8fbc48a5,
+    0xa4911b66, 0xbd8a2a27, 0xf2cbbce0, 0xebd08da1, 0xc0fdde62, 0xd9e6ef23,
+    0x14bce1bd, 0x0da7d0fc, 0x268a833f, 0x3f91b27e, 0x70d024b9, 0x69cb15f8,
+    0x42e6463b, 0x5bfd777a, 0xdc656bb5, 0xc57e5af4, 0xee530937, 0xf7483876,
+    0xb809aeb1, 0xa1129ff0, 0x8a3fcc33, 0x9324fd72
+  },
+  {
+    0x00000000, 0x01c26a37, 0x0384d46e, 0x0246be59, 0x0709a8dc, 0x06cbc2eb,
+    0x048d7cb2, 0x054f1685, 0x0e1351b8, 0x0fd13b8f, 0x0d9785d6, 0x0c55efe1,
+    0x091af964, 0x08d89353, 0x0a9e2d0a, 0x0b5c473d, 0x1c26a370, 0x1de4c947,
+    0x1fa2771e, 0x1e601d29, 0x1b2f0bac, 0x1aed619b, 0x18abdfc2, 0x1969b5f5,
+    0x1235f2c8, 0x13f798ff, 0x11b126a6, 0x10734c91, 0x153c5a14, 0x14fe3023,
+    0x16b88e7a, 0x177ae44d, 0x384d46e0, 0x398f2cd7, 0x3bc9928e, 0x3a0bf8b9,
+    0x3f44ee3c, 0x3e86840b, 0x3cc03a52, 0x3d025065, 0x365e1758, 0x379c7d6f,
+    0x35dac336, 0x3418a901, 0x3157bf84, 0x3095d5b3, 0x32d36bea, 0x331101dd,
+    0x246be590, 0x25a98fa7, 0x27ef31fe, 0x262d5bc9, 0x23624d4c, 0x22a0277b,
+    0x20e69922, 0x2124f315, 0x2a78b428, 0x2bbade1f, 0x29fc6046, 0x283e0a71,
+    0x2d711cf4, 0x2cb376c3, 0x2ef5c89a, 0x2f37a2ad, 0x709a8dc0, 0x7158e7f7,
+    0x731e59ae, 0x72dc3399, 0x7793251c, 0x76514f2b, 0x7417f172, 0x75d59b45,
+    0x7e89dc78, 0x7f4bb64f, 0x7d0d0816, 0x7ccf6221, 0x798074a4, 0x78421e93,
+    0x7a04a0ca, 0x7bc6cafd, 0x6cbc2eb0, 0x6d7e4487, 0x6f38fade, 0x6efa90e9,
+    0x6bb5866c, 0x6a77ec5b, 0x68315202, 0x69f33835, 0x62af7f08, 0x636d153f,
+    0x612bab66, 0x60e9c151, 0x65a6d7d4, 0x6464bde3, 0x662203ba, 0x67e0698d,
+    0x48d7cb20, 0x4915a117, 0x4b531f4e, 0x4a917579, 0x4fde63fc, 0x4e1c09cb,
+    0x4c5ab792, 0x4d98dda5, 0x46c49a98, 0x4706f0af, 0x45404ef6, 0x448224c1,
+    0x41cd3244, 0x400f5873, 0x4249e62a, 0x438b8c1d, 0x54f16850, 0x55330267,
+    0x5775bc3e, 0x56b7d609, 0x53f8c08c, 0x523aaabb, 0x507c14e2, 0x51be7ed5,
+    0x5ae239e8, 0x5b2053df, 0x5966ed86, 0x58a487b1, 0x5deb9134, 0x5c29fb03,
+    0x5e6f455a, 0x5fad2f6d, 0xe1351b80, 0xe0f771b7, 0xe2b1cfee, 0xe373a5d9,
+    0xe63cb35c, 0xe7fed96b, 0xe5b86732, 0xe47a0d05, 0xef264a38, 0xeee4200f,
+    0xeca29e56, 0xed60f461, 0xe82fe2e4, 0xe9ed88d3, 0xebab368a, 0xea695cbd,
+    0xfd13b8f0, 0xfcd1d2c7, 0xfe976c9e, 0xff5506a9, 0xfa1a102c, 0xfbd87a1b,
+    0xf99ec442, 0xf85cae75, 0xf300e948, 0xf2c2837f, 0xf0843d26, 0xf1465711,
+    0xf4094194, 0xf5cb2ba3, 0xf78d95fa, 0xf64fffcd, 0xd9785d60, 0xd8ba3757,
+    0xdafc890e, 0xdb3ee339, 0xde71f5bc, 0xdfb39f8b, 0xddf521d2, 0xdc374be5,
+    0xd76b0cd8, 0xd6a966ef, 0xd4efd8b6, 0xd52db281, 0xd062a404, 0xd1a0ce33,
+    0xd3e6706a, 0xd2241a5d, 0xc55efe10, 0xc49c9427, 0xc6da2a7e, 0xc7184049,
+    0xc25756cc, 0xc3953cfb, 0xc1d382a2, 0xc011e895, 0xcb4dafa8, 0xca8fc59f,
+    0xc8c97bc6, 0xc90b11f1, 0xcc440774, 0xcd866d43, 0xcfc0d31a, 0xce02b92d,
+    0x91af9640, 0x906dfc77, 0x922b422e, 0x93e92819, 0x96a63e9c, 0x976454ab,
+    0x9522eaf2, 0x94e080c5, 0x9fbcc7f8, 0x9e7eadcf, 0x9c381396, 0x9dfa79a1,
+    0x98b56f24, 0x99770513, 0x9b31bb4a, 0x9af3d17d, 0x8d893530, 0x8c4b5f07,
+    0x8e0de15e, 0x8fcf8b69, 0x8a809dec, 0x8b42f7db, 0x89044982, 0x88c623b5,
+    0x839a6488, 0x82580ebf, 0x801eb0e6, 0x81dcdad1, 0x8493cc54, 0x8551a663,
+    0x8717183a, 0x86d5720d, 0xa9e2d0a0, 0xa820ba97, 0xaa6604ce, 0xaba46ef9,
+    0xaeeb787c, 0xaf29124b, 0xad6fac12, 0xacadc625, 0xa7f18118, 0xa633eb2f,
+    0xa4755576, 0xa5b73f41, 0xa0f829c4, 0xa13a43f3, 0xa37cfdaa, 0xa2be979d,
+    0xb5c473d0, 0xb40619e7, 0xb640a7be, 0xb782cd89, 0xb2cddb0c, 0xb30fb13b,
+    0xb1490f62, 0xb08b6555, 0xbbd72268, 0xba15485f, 0xb853f606, 0xb9919c31,
+    0xbcde8ab4, 0xbd1ce083, 0xbf5a5eda, 0xbe9834ed
+  },
+  {
+    0x00000000, 0xb8bc6765, 0xaa09c88b, 0x12b5afee, 0x8f629757, 0x37def032,
+    0x256b5fdc, 0x9dd738b9, 0xc5b428ef, 0x7d084f8a, 0x6fbde064, 0xd7018701,
+    0x4ad6bfb8, 0xf26ad8dd, 0xe0df7733, 0x58631056, 0x5019579f, 0xe8a530fa,
+    0xfa109f14, 0x42acf871, 0xdf7bc0c8, 0x67c7a7ad, 0x75720843, 0xcdce6f26,
+    0x95ad7f70, 0x2d111815, 0x3fa4b7fb, 0x8718d09e, 0x1acfe827, 0xa2738f42,
+    0xb0c620ac, 0x087a47c9, 0xa032af3e, 0x188ec85b, 0x0a3b67b5, 0xb28700d0,
+    0x2f503869, 0x97ec5f0c, 0x8559f0e2, 0x3de59787, 0x658687d1, 0xdd3ae0b4,
+    0xcf8f4f5a, 0x7733283f, 0xeae41086, 0x525877e3, 0x40edd80d, 0xf851bf68,
+    0xf02bf8a1, 0x48979fc4, 0x5a22302a, 0xe29e574f, 0x7f496ff6, 0xc7f50893,
+    0xd540a77d, 0x6dfcc018, 0x359fd04e, 0x8d23b72b, 0x9f9618c5, 0x272a7fa0,
+    0xbafd4719, 0x0241207c, 0x10f48f92, 0xa848e8f7, 0x9b14583d, 0x23a83f58,
+    0x311d90b6, 0x89a1f7d3, 0x1476cf6a, 0xaccaa80f, 0xbe7f07e1, 0x06c36084,
+    0x5ea070d2, 0xe61c17b7, 0xf4a9b859, 0x4c15df3c, 0xd1c2e785, 0x697e80e0,
+    0x7bcb2f0e, 0xc377486b, 0xcb0d0fa2, 0x73b168c7, 0x6104c729, 0xd9b8a04c,
+    0x446f98f5, 0xfcd3ff90, 0xee66507e, 0x56da371b, 0x0eb9274d, 0xb6054028,
+    0xa4b0efc6, 0x1c0c88a3, 0x81dbb01a, 0x3967d77f, 0x2bd27891, 0x936e1ff4,
+    0x3b26f703, 0x839a9066, 0x912f3f88, 0x299358ed, 0xb4446054, 0x0cf80731,
+    0x1e4da8df, 0xa6f1cfba, 0xfe92dfec, 0x462eb889, 0x549b1767, 0xec277002,
+    0x71f048bb, 0xc94c2fde, 0xdbf98030, 0x6345e755, 0x6b3fa09c, 0xd383c7f9,
+    0xc1366817, 0x798a0f72, 0xe45d37cb, 0x5ce150ae, 0x4e54ff40, 0xf6e89825,
+    0xae8b8873, 0x1637ef16, 0x048240f8, 0xbc3e279d, 0x21e91f24, 0x99557841,
+    0x8be0d7af, 0x335cb0ca, 0xed59b63b, 0x55e5d15e, 0x47507eb0, 0xffec19d5,
+    0x623b216c, 0xda874609, 0xc832e9e7, 0x708e8e82, 0x28ed9ed4, 0x9051f9b1,
+    0x82e4565f, 0x3a58313a, 0xa78f0983, 0x1f336ee6, 0x0d86c108, 0xb53aa66d,
+    0xbd40e1a4, 0x05fc86c1, 0x1749292f, 0xaff54e4a, 0x322276f3, 0x8a9e1196,
+    0x982bbe78, 0x2097d91d, 0x78f4c94b, 0xc048ae2e, 0xd2fd01c0, 0x6a4166a5,
+    0xf7965e1c, 0x4f2a3979, 0x5d9f9697, 0xe523f1f2, 0x4d6b1905, 0xf5d77e60,
+    0xe762d18e, 0x5fdeb6eb, 0xc2098e52, 0x7ab5e937, 0x680046d9, 0xd0bc21bc,
+    0x88df31ea, 0x3063568f, 0x22d6f961, 0x9a6a9e04, 0x07bda6bd, 0xbf01c1d8,
+    0xadb46e36, 0x15080953, 0x1d724e9a, 0xa5ce29ff, 0xb77b8611, 0x0fc7e174,
+    0x9210d9cd, 0x2aacbea8, 0x38191146, 0x80a57623, 0xd8c66675, 0x607a0110,
+    0x72cfaefe, 0xca73c99b, 0x57a4f122, 0xef189647, 0xfdad39a9, 0x45115ecc,
+    0x764dee06, 0xcef18963, 0xdc44268d, 0x64f841e8, 0xf92f7951, 0x41931e34,
+    0x5326b1da, 0xeb9ad6bf, 0xb3f9c6e9, 0x0b45a18c, 0x19f00e62, 0xa14c6907,
+    0x3c9b51be, 0x842736db, 0x96929935, 0x2e2efe50, 0x2654b999, 0x9ee8defc,
+    0x8c5d7112, 0x34e11677, 0xa9362ece, 0x118a49ab, 0x033fe645, 0xbb838120,
+    0xe3e09176, 0x5b5cf613, 0x49e959fd, 0xf1553e98, 0x6c820621, 0xd43e6144,
+    0xc68bceaa, 0x7e37a9cf, 0xd67f4138, 0x6ec3265d, 0x7c7689b3, 0xc4caeed6,
+    0x591dd66f, 0xe1a1b10a, 0xf3141ee4, 0x4ba87981, 0x13cb69d7, 0xab770eb2,
+    0xb9c2a15c, 0x017ec639, 0x9ca9fe80, 0x241599e5, 0x36a0360b, 0x8e1c516e,
+    0x866616a7, 0x3eda71c2, 0x2c6fde2c, 0x94d3b949, 0x090481f0, 0xb1b8e695,
+    0xa30d497b, 0x1bb12e1e, 0x43d23e48, 0xfb6e592d, 0xe9dbf6c3, 0x516791a6,
+    0xccb0a91f, 0x740cce7a, 0x66b96194, 0xde0506f1
+  },
+  {
+    0x00000000, 0x3d6029b0, 0x7ac05360, 0x47a07ad0, 0xf580a6c0, 0xc8e08f70,
+    0x8f40f5a0, 0xb220dc10, 0x30704bc1, 0x0d106271, 0x4ab018a1, 0x77d03111,
+    0xc5f0ed01, 0xf890c4b1, 0xbf30be61, 0x825097d1, 0x60e09782, 0x5d80be32,
+    0x1a20c4e2, 0x2740ed52, 0x95603142, 0xa80018f2, 0xefa06222, 0xd2c04b92,
+    0x5090dc43, 0x6df0f5f3, 0x2a508f23, 0x1730a693, 0xa5107a83, 0x98705333,
+    0xdfd029e3, 0xe2b00053, 0xc1c12f04, 0xfca106b4, 0xbb017c64, 0x866155d4,
+    0x344189c4, 0x0921a074, 0x4e81daa4, 0x73e1f314, 0xf1b164c5, 0xccd14d75,
+    0x8b7137a5, 0xb6111e15, 0x0431c205, 0x3951ebb5, 0x7ef19165, 0x4391b8d5,
+    0xa121b886, 0x9c419136, 0xdbe1ebe6, 0xe681c256, 0x54a11e46, 0x69c137f6,
+    0x2e614d26, 0x13016496, 0x9151f347, 0xac31daf7, 0xeb91a027, 0xd6f18997,
+    0x64d15587, 0x59b17c37, 0x1e1106e7, 0x23712f57, 0x58f35849, 0x659371f9,
+    0x22330b29, 0x1f532299, 0xad73fe89, 0x9013d739, 0xd7b3ade9, 0xead38459,
+    0x68831388, 0x55e33a38, 0x124340e8, 0x2f236958, 0x9d03b548, 0xa0639cf8,
+    0xe7c3e628, 0xdaa3cf98, 0x3813cfcb, 0x0573e67b, 0x42d39cab, 0x7fb3b51b,
+    0xcd93690b, 0xf0f340bb, 0xb7533a6b, 0x8a3313db, 0x0863840a, 0x3503adba,
+    0x72a3d76a, 0x4fc3feda, 0xfde322ca, 0xc0830b7a, 0x872371aa, 0xba43581a,
+    0x9932774d, 0xa4525efd, 0xe3f2242d, 0xde920d9d, 0x6cb2d18d, 0x51d2f83d,
+    0x167282ed, 0x2b12ab5d, 0xa9423c8c, 0x9422153c, 0xd3826fec, 0xeee2465c,
+    0x5cc29a4c, 0x61a2b3fc, 0x2602c92c, 0x1b62e09c, 0xf9d2e0cf, 0xc4b2c97f,
+    0x8312b3af, 0xbe729a1f, 0x0c52460f, 0x31326fbf, 0x7692156f, 0x4bf23cdf,
+    0xc9a2ab0e, 0xf4c282be, 0xb362f86e, 0x8e02d1de, 0x3c220dce, 0x0142247e,
+    0x46e25eae, 0x7b82771e, 0xb1e6b092, 0x8c869922, 0xcb26e3f2, 0xf646ca42,
+    0x44661652, 0x79063fe2, 0x3ea64532, 0x03c66c82, 0x8196fb53, 0xbcf6d2e3,
+    0xfb56a833, 0xc6368183, 0x74165d93, 0x49767423, 0x0ed60ef3, 0x33b62743,
+    0xd1062710, 0xec660ea0, 0xabc67470, 0x96a65dc0, 0x248681d0, 0x19e6a860,
+    0x5e46d2b0, 0x6326fb00, 0xe1766cd1, 0xdc164561, 0x9bb63fb1, 0xa6d61601,
+    0x14f6ca11, 0x2996e3a1, 0x6e369971, 0x5356b0c1, 0x70279f96, 0x4d47b626,
+    0x0ae7ccf6, 0x3787e546, 0x85a73956, 0xb8c710e6, 0xff676a36, 0xc2074386,
+    0x4057d457, 0x7d37fde7, 0x3a978737, 0x07f7ae87, 0xb5d77297, 0x88b75b27,
+    0xcf1721f7, 0xf2770847, 0x10c70814, 0x2da721a4, 0x6a075b74, 0x576772c4,
+    0xe547aed4, 0xd8278764, 0x9f87fdb4, 0xa2e7d404, 0x20b743d5, 0x1dd76a65,
+    0x5a7710b5, 0x67173905, 0xd537e515, 0xe857cca5, 0xaff7b675, 0x92979fc5,
+    0xe915e8db, 0xd475c16b, 0x93d5bbbb, 0xaeb5920b, 0x1c954e1b, 0x21f567ab,
+    0x66551d7b, 0x5b3534cb, 0xd965a31a, 0xe4058aaa, 0xa3a5f07a, 0x9ec5d9ca,
+    0x2ce505da, 0x11852c6a, 0x562556ba, 0x6b457f0a, 0x89f57f59, 0xb49556e9,
+    0xf3352c39, 0xce550589, 0x7c75d999, 0x4115f029, 0x06b58af9, 0x3bd5a349,
+    0xb9853498, 0x84e51d28, 0xc34567f8, 0xfe254e48, 0x4c059258, 0x7165bbe8,
+    0x36c5c138, 0x0ba5e888, 0x28d4c7df, 0x15b4ee6f, 0x521494bf, 0x6f74bd0f,
+    0xdd54611f, 0xe03448af, 0xa794327f, 0x9af41bcf, 0x18a48c1e, 0x25c4a5ae,
+    0x6264df7e, 0x5f04f6ce, 0xed242ade, 0xd044036e, 0x97e479be, 0xaa84500e,
+    0x4834505d, 0x755479ed, 0x32f4033d, 0x0f942a8d, 0xbdb4f69d, 0x80d4df2d,
+    0xc774a5fd, 0xfa148c4d, 0x78441b9c, 0x4524322c, 0x028448fc, 0x3fe4614c,
+    0x8dc4bd5c, 0xb0a494ec, 0xf704ee3c, 0xca64c78c
+  },
+  {
+    0x00000000, 0xcb5cd3a5, 0x4dc8a10b, 0x869472ae, 0x9b914216, 0x50cd91b3,
+    0xd659e31d, 0x1d0530b8, 0xec53826d, 0x270f51c8, 0xa19b2366, 0x6ac7f0c3,
+    0x77c2c07b, 0xbc9e13de, 0x3a0a6170, 0xf156b2d5, 0x03d6029b, 0xc88ad13e,
+    0x4e1ea390, 0x85427035, 0x9847408d, 0x531b9328, 0xd58fe186, 0x1ed33223,
+    0xef8580f6, 0x24d95353, 0xa24d21fd, 0x6911f258, 0x7414c2e0, 0xbf481145,
+    0x39dc63eb, 0xf280b04e, 0x07ac0536, 0xccf0d693, 0x4a64a43d, 0x81387798,
+    0x9c3d4720, 0x57619485, 0xd1f5e62b, 0x1aa9358e, 0xebff875b, 0x20a354fe,
+    0xa6372650, 0x6d6bf5f5, 0x706ec54d, 0xbb3216e8, 0x3da66446, 0xf6fab7e3,
+    0x047a07ad, 0xcf26d408, 0x49b2a6a6, 0x82ee7503, 0x9feb45bb, 0x54b7961e,
+    0xd223e4b0, 0x197f3715, 0xe82985c0, 0x23755665, 0xa5e124cb, 0x6ebdf76e,
+    0x73b8c7d6, 0xb8e41473, 0x3e7066dd, 0xf52cb578, 0x0f580a6c, 0xc404d9c9,
+    0x4290ab67, 0x89cc78c2, 0x94c9487a, 0x5f959bdf, 0xd901e971, 0x125d3ad4,
+    0xe30b8801, 0x28575ba4, 0xaec3290a, 0x659ffaaf, 0x789aca17, 0xb3c619b2,
+    0x35526b1c, 0xfe0eb8b9, 0x0c8e08f7, 0xc7d2db52, 0x4146a9fc, 0x8a1a7a59,
+    0x971f4ae1, 0x5c439944, 0xdad7ebea, 0x118b384f, 0xe0dd8a9a, 0x2b81593f,
+    0xad152b91, 0x6649f834, 0x7b4cc88c, 0xb0101b29, 0x36846987, 0xfdd8ba22,
+    0x08f40f5a, 0xc3a8dcff, 0x453cae51, 0x8e607df4, 0x93654d4c, 0x58399ee9,
+    0xdeadec47, 0x15f13fe2, 0xe4a78d37, 0x2ffb5e92, 0xa96f2c3c, 0x6233ff99,
+    0x7f36cf21, 0xb46a1c84, 0x32fe6e2a, 0xf9a2bd8f, 0x0b220dc1, 0xc07ede64,
+    0x46eaacca, 0x8db67f6f, 0x90b34fd7, 0x5bef9c72, 0xdd7beedc, 0x16273d79,
+    0xe7718fac, 0x2c2d5c09, 0xaab92ea7, 0x61e5fd02, 0x7ce0cdba, 0xb7bc1e1f,
+    0x31286cb1, 0xfa74bf14, 0x1eb014d8, 0xd5ecc77d, 0x5378b5d3, 0x98246676,
+    0x852156ce, 0x4e7d856b, 0xc8e9f7c5, 0x03b52460, 0xf2e396b5, 0x39bf4510,
+    0xbf2b37be, 0x7477e41b, 0x6972d4a3, 0xa22e0706, 0x24ba75a8, 0xefe6a60d,
+    0x1d661643, 0xd63ac5e6, 0x50aeb748, 0x9bf264ed, 0x86f75455, 0x4dab87f0,
+    0xcb3ff55e, 0x006326fb, 0xf135942e, 0x3a69478b, 0xbcfd3525, 0x77a1e680,
+    0x6aa4d638, 0xa1f8059d, 0x276c7733, 0xec30a496, 0x191c11ee, 0xd240c24b,
+    0x54d4b0e5, 0x9f886340, 0x828d53f8, 0x49d1805d, 0xcf45f2f3, 0x04192156,
+    0xf54f9383, 0x3e134026, 0xb8873288, 0x73dbe12d, 0x6eded195, 0xa5820230,
+    0x2316709e, 0xe84aa33b, 0x1aca1375, 0xd196c0d0, 0x5702b27e, 0x9c5e61db,
+    0x815b5163, 0x4a0782c6, 0xcc93f068, 0x07cf23cd, 0xf6999118, 0x3dc542bd,
+    0xbb513013, 0x700de3b6, 0x6d08d30e, 0xa65400ab, 0x20c07205, 0xeb9ca1a0,
+    0x11e81eb4, 0xdab4cd11, 0x5c20bfbf, 0x977c6c1a, 0x8a795ca2, 0x41258f07,
+    0xc7b1fda9, 0x0ced2e0c, 0xfdbb9cd9, 0x36e74f7c, 0xb0733dd2, 0x7b2fee77,
+    0x662adecf, 0xad760d6a, 0x2be27fc4, 0xe0beac61, 0x123e1c2f, 0xd962cf8a,
+    0x5ff6bd24, 0x94aa6e81, 0x89af5e39, 0x42f38d9c, 0xc467ff32, 0x0f3b2c97,
+    0xfe6d9e42, 0x35314de7, 0xb3a53f49, 0x78f9ecec, 0x65fcdc54, 0xaea00ff1,
+    0x28347d5f, 0xe368aefa, 0x16441b82, 0xdd18c827, 0x5b8cba89, 0x90d0692c,
+    0x8dd55994, 0x46898a31, 0xc01df89f, 0x0b412b3a, 0xfa1799ef, 0x314b4a4a,
+    0xb7df38e4, 0x7c83eb41, 0x6186dbf9, 0xaada085c, 0x2c4e7af2, 0xe712a957,
+    0x15921919, 0xdececabc, 0x585ab812, 0x93066bb7, 0x8e035b0f, 0x455f88aa,
+    0xc3cbfa04, 0x089729a1, 0xf9c19b74, 0x329d48d1, 0xb4093a7f, 0x7f55e9da,
+    0x6250d962, 0xa90c0ac7, 0x2f987869, 0xe4c4abcc
+  },
+  {
+    0x00000000, 0xa6770bb4, 0x979f1129, 0x31e81a9d, 0xf44f2413, 0x52382fa7,
+    0x63d0353a, 0xc5a73e8e, 0x33ef4e67, 0x959845d3, 0xa4705f4e, 0x020754fa,
+    0xc7a06a74, 0x61d761c0, 0x503f7b5d, 0xf64870e9, 0x67de9cce, 0xc1a9977a,
+    0xf0418de7, 0x56368653, 0x9391b8dd, 0x35e6b369, 0x040ea9f4, 0xa279a240,
+    0x5431d2a9, 0xf246d91d, 0xc3aec380, 0x65d9c834, 0xa07ef6ba, 0x0609fd0e,
+    0x37e1e793, 0x9196ec27, 0xcfbd399c, 0x69ca3228, 0x582228b5, 0xfe552301,
+    0x3bf21d8f, 0x9d85163b, 0xac6d0ca6, 0x0a1a0712, 0xfc5277fb, 0x5a257c4f,
+    0x6bcd66d2, 0xcdba6d66, 0x081d53e8, 0xae6a585c, 0x9f8242c1, 0x39f54975,
+    0xa863a552, 0x0e14aee6, 0x3ffcb47b, 0x998bbfcf, 0x5c2c8141, 0xfa5b8af5,
+    0xcbb39068, 0x6dc49bdc, 0x9b8ceb35, 0x3dfbe081, 0x0c13fa1c, 0xaa64f1a8,
+    0x6fc3cf26, 0xc9b4c492, 0xf85cde0f, 0x5e2bd5bb, 0x440b7579, 0xe27c7ecd,
+    0xd3946450, 0x75e36fe4, 0xb044516a, 0x16335ade, 0x27db4043, 0x81ac4bf7,
+    0x77e43b1e, 0xd19330aa, 0xe07b2a37, 0x460c2183, 0x83ab1f0d, 0x25dc14b9,
+    0x14340e24, 0xb2430590, 0x23d5e9b7, 0x85a2e203, 0xb44af89e, 0x123df32a,
+    0xd79acda4, 0x71edc610, 0x4005dc8d, 0xe672d739, 0x103aa7d0, 0xb64dac64,
+    0x87a5b6f9, 0x21d2bd4d, 0xe47583c3, 0x42028877, 0x73ea92ea, 0xd59d995e,
+    0x8bb64ce5, 0x2dc14751, 0x1c295dcc, 0xba5e5678, 0x7ff968f6, 0xd98e6342,
+    0xe86679df, 0x4e11726b, 0xb8590282, 0x1e2e0936, 0x2fc613ab, 0x89b1181f,
+    0x4c162691, 0xea612d25, 0xdb8937b8, 0x7dfe3c0c, 0xec68d02b, 0x4a1fdb9f,
+    0x7bf7c102, 0xdd80cab6, 0x1827f438, 0xbe50ff8c, 0x8fb8e511, 0x29cfeea5,
+    0xdf879e4c, 0x79f095f8, 0x48188f65, 0xee6f84d1, 0x2bc8ba5f, 0x8dbfb1eb,
+    0xbc57ab76, 0x1a20a0c2, 0x8816eaf2, 0x2e61e146, 0x1f89fbdb, 0xb9fef06f,
+    0x7c59cee1, 0xda2ec555, 0xebc6dfc8, 0x4db1d47c, 0xbbf9a495, 0x1d8eaf21,
+    0x2c66b5bc, 0x8a11be08, 0x4fb68086, 0xe9c18b32, 0xd82991af, 0x7e5e9a1b,
+    0xefc8763c, 0x49bf7d88, 0x78576715, 0xde206ca1, 0x1b87522f, 0xbdf0599b,
+    0x8c184306, 0x2a6f48b2, 0xdc27385b, 0x7a5033ef, 0x4bb82972, 0xedcf22c6,
+    0x28681c48, 0x8e1f17fc, 0xbff70d61, 0x198006d5, 0x47abd36e, 0xe1dcd8da,
+    0xd034c247, 0x7643c9f3, 0xb3e4f77d, 0x1593fcc9, 0x247be654, 0x820cede0,
+    0x74449d09, 0xd23396bd, 0xe3db8c20, 0x45ac8794, 0x800bb91a, 0x267cb2ae,
+    0x1794a833, 0xb1e3a387, 0x20754fa0, 0x86024414, 0xb7ea5e89, 0x119d553d,
+    0xd43a6bb3, 0x724d6007, 0x43a57a9a, 0xe5d2712e, 0x139a01c7, 0xb5ed0a73,
+    0x840510ee, 0x22721b5a, 0xe7d525d4, 0x41a22e60, 0x704a34fd, 0xd63d3f49,
+    0xcc1d9f8b, 0x6a6a943f, 0x5b828ea2, 0xfdf58516, 0x3852bb98, 0x9e25b02c,
+    0xafcdaab1, 0x09baa105, 0xfff2d1ec, 0x5985da58, 0x686dc0c5, 0xce1acb71,
+    0x0bbdf5ff, 0xadcafe4b, 0x9c22e4d6, 0x3a55ef62, 0xabc30345, 0x0db408f1,
+    0x3c5c126c, 0x9a2b19d8, 0x5f8c2756, 0xf9fb2ce2, 0xc813367f, 0x6e643dcb,
+    0x982c4d22, 0x3e5b4696, 0x0fb35c0b, 0xa9c457bf, 0x6c636931, 0xca146285,
+    0xfbfc7818, 0x5d8b73ac, 0x03a0a617, 0xa5d7ada3, 0x943fb73e, 0x3248bc8a,
+    0xf7ef8204, 0x519889b0, 0x6070932d, 0xc6079899, 0x304fe870, 0x9638e3c4,
+    0xa7d0f959, 0x01a7f2ed, 0xc400cc63, 0x6277c7d7, 0x539fdd4a, 0xf5e8d6fe,
+    0x647e3ad9, 0xc209316d, 0xf3e12bf0, 0x55962044, 0x90311eca, 0x3646157e,
+    0x07ae0fe3, 0xa1d90457, 0x579174be, 0xf1e67f0a, 0xc00e6597, 0x66796e23,
+    0xa3de50ad, 0x05a95b19, 0x34414184, 0x92364a30
+  },
+  {
+    0x00000000, 0xccaa009e, 0x4225077d, 0x8e8f07e3, 0x844a0efa, 0x48e00e64,
+    0xc66f0987, 0x0ac50919, 0xd3e51bb5, 0x1f4f1b2b, 0x91c01cc8, 0x5d6a1c56,
+    0x57af154f, 0x9b0515d1, 0x158a1232, 0xd92012ac, 0x7cbb312b, 0xb01131b5,
+    0x3e9e3656, 0xf23436c8, 0xf8f13fd1, 0x345b3f4f, 0xbad438ac, 0x767e3832,
+    0xaf5e2a9e, 0x63f42a00, 0xed7b2de3, 0x21d12d7d, 0x2b142464, 0xe7be24fa,
+    0x69312319, 0xa59b2387, 0xf9766256, 0x35dc62c8, 0xbb53652b, 0x77f965b5,
+    0x7d3c6cac, 0xb1966c32, 0x3f196bd1, 0xf3b36b4f, 0x2a9379e3, 0xe639797d,
+    0x68b67e9e, 0xa41c7e00, 0xaed97719, 0x62737787, 0xecfc7064, 0x205670fa,
+    0x85cd537d, 0x496753e3, 0xc7e85400, 0x0b42549e, 0x01875d87, 0xcd2d5d19,
+    0x43a25afa, 0x8f085a64, 0x562848c8, 0x9a824856, 0x140d4fb5, 0xd8a74f2b,
+    0xd2624632, 0x1ec846ac, 0x9047414f, 0x5ced41d1, 0x299dc2ed, 0xe537c273,
+    0x6bb8c590, 0xa712c50e, 0xadd7cc17, 0x617dcc89, 0xeff2cb6a, 0x2358cbf4,
+    0xfa78d958, 0x36d2d9c6, 0xb85dde25, 0x74f7debb, 0x7e32d7a2, 0xb298d73c,
+    0x3c17d0df, 0xf0bdd041, 0x5526f3c6, 0x998cf358, 0x1703f4bb, 0xdba9f425,
+    0xd16cfd3c, 0x1dc6fda2, 0x9349fa41, 0x5fe3fadf, 0x86c3e873, 0x4a69e8ed,
+    0xc4e6ef0e, 0x084cef90, 0x0289e689, 0xce23e617, 0x40ace1f4, 0x8c06e16a,
+    0xd0eba0bb, 0x1c41a025, 0x92cea7c6, 0x5e64a758, 0x54a1ae41, 0x980baedf,
+    0x1684a93c, 0xda2ea9a2, 0x030ebb0e, 0xcfa4bb90, 0x412bbc73, 0x8d81bced,
+    0x8744b5f4, 0x4beeb56a, 0xc561b289, 0x09cbb217, 0xac509190, 0x60fa910e,
+    0xee7596ed, 0x22df9673, 0x281a9f6a, 0xe4b09ff4, 0x6a3f9817, 0xa6959889,
+    0x7fb58a25, 0xb31f8abb, 0x3d908d58, 0xf13a8dc6, 0xfbff84df, 0x37558441,
+    0xb9da83a2, 0x7570833c, 0x533b85da, 0x9f918544, 0x111e82a7, 0xddb48239,
+    0xd7718b20, 0x1bdb8bbe, 0x95548c5d, 0x59fe8cc3, 0x80de9e6f, 0x4c749ef1,
+    0xc2fb9912, 0x0e51998c, 0x04949095, 0xc83e900b, 0x46b197e8, 0x8a1b9776,
+    0x2f80b4f1, 0xe32ab46f, 0x6da5b38c, 0xa10fb312, 0xabcaba0b, 0x6760ba95,
+    0xe9efbd76, 0x2545bde8, 0xfc65af44, 0x30cfafda, 0xbe40a839, 0x72eaa8a7,
+    0x782fa1be, 0xb485a120, 0x3a0aa6c3, 0xf6a0a65d, 0xaa4de78c, 0x66e7e712,
+    0xe868e0f1, 0x24c2e06f, 0x2e07e976, 0xe2ade9e8, 0x6c22ee0b, 0xa088ee95,
+    0x79a8fc39, 0xb502fca7, 0x3b8dfb44, 0xf727fbda, 0xfde2f2c3, 0x3148f25d,
+    0xbfc7f5be, 0x736df520, 0xd6f6d6a7, 0x1a5cd639, 0x94d3d1da, 0x5879d144,
+    0x52bcd85d, 0x9e16d8c3, 0x1099df20, 0xdc33dfbe, 0x0513cd12, 0xc9b9cd8c,
+    0x4736ca6f, 0x8b9ccaf1, 0x8159c3e8, 0x4df3c376, 0xc37cc495, 0x0fd6c40b,
+    0x7aa64737, 0xb60c47a9, 0x3883404a, 0xf42940d4, 0xfeec49cd, 0x32464953,
+    0xbcc94eb0, 0x70634e2e, 0xa9435c82, 0x65e95c1c, 0xeb665bff, 0x27cc5b61,
+    0x2d095278, 0xe1a352e6, 0x6f2c5505, 0xa386559b, 0x061d761c, 0xcab77682,
+    0x44387161, 0x889271ff, 0x825778e6, 0x4efd7878, 0xc0727f9b, 0x0cd87f05,
+    0xd5f86da9, 0x19526d37, 0x97dd6ad4, 0x5b776a4a, 0x51b26353, 0x9d1863cd,
+    0x1397642e, 0xdf3d64b0, 0x83d02561, 0x4f7a25ff, 0xc1f5221c, 0x0d5f2282,
+    0x079a2b9b, 0xcb302b05, 0x45bf2ce6, 0x89152c78, 0x50353ed4, 0x9c9f3e4a,
+    0x121039a9, 0xdeba3937, 0xd47f302e, 0x18d530b0, 0x965a3753, 0x5af037cd,
+    0xff6b144a, 0x33c114d4, 0xbd4e1337, 0x71e413a9, 0x7b211ab0, 0xb78b1a2e,
+    0x39041dcd, 0xf5ae1d53, 0x2c8e0fff, 0xe0240f61, 0x6eab0882, 0xa201081c,
+    0xa8c40105, 0x646e019b, 0xeae10678, 0x264b06e6
+  }
+#endif
+};
 
 /*
    Build a set of tables to decode the provided canonical Huffman code.
@@ -160,7 +581,7 @@ static int zt_table(codetype type, uint8_t *lens, int codes, code **table, uint8
     const uint16_t *base;     /* base value table to use */
     const uint16_t *extra;    /* extra bits table to use */
     unsigned match;             /* use base and extra for symbol >= match */
-    uint8_t count[MAXBITS+1];    /* number of codes of each length */
+    uint16_t count[MAXBITS+1];   /* number of codes of each length */
     uint16_t offs[MAXBITS+1];     /* offsets in table for each length */
     uint32_t *pU32, U32Here;
     static const uint16_t lbase[31] = { /* Length codes 257..285 base */
@@ -412,6 +833,35 @@ static int zt_table(codetype type, uint8_t *lens, int codes, code **table, uint8
     return 0;
 } /* zt_table() */
 
+//
+// Pack pairs of literals into single root table entries when both codes
+// together fit in the root bits. A packed entry has op = 0x80, the first
+// literal in the low byte of val, the second in the high byte and bits is
+// the combined code length. This lets the decoder output 2 literals with
+// one table lookup, which helps text-heavy data with short literal codes.
+// The entries are processed from the top down because each one looks at
+// a lower index (the bits which follow the first code) which must still
+// hold its original (unpacked) value.
+//
+static void zt_pack_literals(code *table, unsigned root)
+{
+    int i;
+    code here, next;
+
+    for (i = (1 << root) - 1; i >= 0; i--) {
+        here = table[i];
+        if (here.op == 0 && here.bits < root) { // literal with some bits to spare
+            next = table[i >> here.bits];
+            if (next.op == 0 && here.bits + next.bits <= root) {
+                here.op = 0x80;
+                here.val |= (next.val << 8);
+                here.bits += next.bits;
+                table[i] = here;
+            }
+        }
+    }
+} /* zt_pack_literals() */
+
 int zt_init(zt_state *state)
 {
     if (state) {
@@ -422,496 +872,5419 @@ int zt_init(zt_state *state)
     return ZT_SUCCESS;
 } /* zt_init() */
 //
+// Enable streaming mode. Back-references which reach before the current
+// output chunk are resolved from a circular window of (1<<iWindowBits)
+// bytes, so the output can be drained in small pieces instead of needing
+// a buffer large enough for all of it. Call this after zt_init().
+//
+int zt_init_window(zt_state *state, uint8_t *pWindow, int iWindowBits)
+{
+    if (state == NULL || pWindow == NULL || iWindowBits < 8 || iWindowBits > 15) {
+        return ZT_INVALID_PARAMETER;
+    }
+    state->pWindow = pWindow;
+    state->u32WindowSize = 1 << iWindowBits;
+    state->u32WindowPos = 0;
+    state->u32WindowHave = 0;
+    return ZT_SUCCESS;
+} /* zt_init_window() */
+//
+// Enable scatter/gather output. The output is written straight into a list
+// of caller-supplied segments (e.g. pooled fixed-size buffers), filling each
+// one before moving on to the next. Back-references which reach before the
+// current segment are copied from the earlier ones, so the list has to stay
+// intact until decoding is finished. Call this after zt_init() or
+// zt_reset() and decode with zt_inflate_segments().
+//
+int zt_init_segments(zt_state *state, zt_segment *pSegs, int iSegCount)
+{
+    if (state == NULL || pSegs == NULL || iSegCount <= 0) {
+        return ZT_INVALID_PARAMETER;
+    }
+    state->pWindow = NULL; // the earlier segments are the history
+    state->pSegs = pSegs;
+    state->u32SegCount = (uint32_t)iSegCount;
+    state->u32Seg = 0;
+    state->u32SegPos = 0;
+    return ZT_SUCCESS;
+} /* zt_init_segments() */
+//
+// Enable growable output. When the output buffer fills up before the data
+// ends, zt_inflate_grow() asks the reallocation hook for a larger one and
+// keeps decoding into it, so a stream of unknown size doesn't need a worst
+// case buffer. Pass NULL for pfnRealloc to use zt_realloc(). Call this after
+// zt_init() or zt_reset().
+//
+int zt_init_grow(zt_state *state, ZT_REALLOC_CALLBACK *pfnRealloc, void *pUser)
+{
+    if (state == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    state->pfnRealloc = (pfnRealloc) ? pfnRealloc : zt_realloc;
+    state->pReallocUser = pUser;
+    return ZT_SUCCESS;
+} /* zt_init_grow() */
+//
+// Default reallocation hook for growable output (the heap)
+//
+uint8_t *zt_realloc(void *pUser, uint8_t *pOld, size_t iOldSize, size_t iNewSize)
+{
+    (void)pUser; (void)iOldSize;
+    return (uint8_t *)realloc(pOld, iNewSize);
+} /* zt_realloc() */
+//
+// Enable incremental input. zt_inflate() normally leaves the input which it
+// can't use yet (the start of a block header or symbol which might not all
+// be there) in the buffer for the caller to pass again with the next data.
+// With this, those bytes are kept in the state instead and put in front of
+// the next input, so any amount of data (even 1 byte at a time, straight
+// from a socket) can be passed and ZT_INPUT_INSUFFICIENT always means it
+// was all used. When the stream ends, the part of whatever follows it (e.g.
+// a gzip trailer) which was already taken is left in state->carry
+// (state->u32Carry bytes) and the rest is at buffer->next_in as usual.
+// Call this after zt_init() or zt_reset().
+//
+int zt_init_carry(zt_state *state)
+{
+    if (state == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    state->bCarry = 1;
+    state->u32Carry = 0;
+    return ZT_SUCCESS;
+} /* zt_init_carry() */
+//
+// Enable checksum verification of the decoded data; ZT_CHECK_ADLER32 for
+// zlib streams (the trailer is checked by zt_inflate) or ZT_CHECK_CRC32 for
+// gzip (zt_gunzip checks the trailer). Call this after zt_init().
+//
+int zt_init_check(zt_state *state, int iCheckType)
+{
+    if (state == NULL || iCheckType < ZT_CHECK_NONE || iCheckType > ZT_CHECK_ADLER32) {
+        return ZT_INVALID_PARAMETER;
+    }
+    state->u8CheckType = (uint8_t)iCheckType;
+    state->u32Check = (iCheckType == ZT_CHECK_ADLER32) ? 1 : 0; // starting values
+    return ZT_SUCCESS;
+} /* zt_init_check() */
+//
+// Set the format of the stream which zt_inflate() will decode. The default
+// (after zt_init() or zt_reset()) is zlib. ZT_FORMAT_GZIP skips the gzip
+// header and, with zt_init_check(), verifies the trailer's CRC-32 and size.
+// ZT_FORMAT_AUTO detects gzip, zlib or raw deflate from the first bytes
+// (see zt_detect_format) and then carries on as if it had been given that
+// format; a zlib or gzip checksum is checked with whichever type the stream
+// has and raw deflate has none. state->u8Format tells which it was.
+// The gzip header has to fit in ZT_INPUT_CARRY bytes with incremental
+// input, or else be passed in one piece. With incremental input, the members
+// of a multi-member gzip file are all decoded. Call this after zt_init().
+//
+int zt_init_format(zt_state *state, int iFormat)
+{
+    if (state == NULL || iFormat < ZT_FORMAT_RAW || iFormat > ZT_FORMAT_AUTO) {
+        return ZT_INVALID_PARAMETER;
+    }
+    state->u8Format = (uint8_t)iFormat;
+    state->wbits = (iFormat == ZT_FORMAT_RAW) ? 15 : 0; // 0 = header not parsed yet
+    return ZT_SUCCESS;
+} /* zt_init_format() */
+//
+// Attach a cache of decoding tables to a decoder. Dynamic block headers
+// which match one of the last ZT_TABLE_CACHE headers decoded reuse its
+// tables instead of building new ones. The cache stays attached through
+// zt_reset(), so it keeps paying off across many small streams.
+//
+int zt_init_cache(zt_state *state, zt_table_cache *pCache)
+{
+    int i;
+
+    if (state == NULL) return ZT_INVALID_PARAMETER;
+    state->pCache = pCache;
+    if (pCache) {
+        pCache->u32Next = 0;
+        for (i=0; i<ZT_TABLE_CACHE; i++) {
+            pCache->entries[i].nlen = 0; // unused
+        }
+    }
+    return ZT_SUCCESS;
+} /* zt_init_cache() */
+static void zt_use_dict(zt_state *state, const uint8_t *pDict, uint32_t u32Size, uint32_t u32Id);
+//
+// Register a set of preset dictionaries. When a zlib header has the FDICT
+// flag, the one with the matching DICTID (computed here) is used; if none
+// match, zt_inflate() returns ZT_NEED_DICT with the DICTID it wanted in
+// state->u32DictId. The set stays registered through zt_reset(), so it only
+// has to be done once for a decoder which handles many small messages.
+// The dictionaries aren't copied, so they have to stay valid.
+//
+int zt_init_dicts(zt_state *state, zt_dict *pDicts, int iCount)
+{
+    int i;
+
+    if (state == NULL || iCount < 0 || (pDicts == NULL && iCount)) return ZT_INVALID_PARAMETER;
+    for (i=0; i<iCount; i++) {
+        pDicts[i].u32Id = zt_adler32(1, pDicts[i].pData, (int)pDicts[i].u32Size);
+    }
+    state->pDicts = pDicts;
+    state->u32DictCount = (uint32_t)iCount;
+    return ZT_SUCCESS;
+} /* zt_init_dicts() */
+//
+// Use a preset dictionary for the next stream: back-references which reach
+// before the start of the output come from the end of it. This is for raw
+// deflate streams (or to answer ZT_NEED_DICT); for zlib it has to be the
+// one named in the header. It isn't copied, except into the window in
+// streaming mode, so call this after zt_init_window().
+//
+int zt_init_dict(zt_state *state, const uint8_t *pDict, int iSize)
+{
+    uint32_t u32Id;
+
+    if (state == NULL || pDict == NULL || iSize <= 0) return ZT_INVALID_PARAMETER;
+    u32Id = zt_adler32(1, pDict, iSize);
+    if (state->u32DictId && state->pDict == NULL && u32Id != state->u32DictId) {
+        return ZT_INVALID_PARAMETER; // not the one the stream asked for
+    }
+    zt_use_dict(state, pDict, (uint32_t)iSize, u32Id);
+    return ZT_SUCCESS;
+} /* zt_init_dict() */
+//
+// Set up a temporary decoder (on the stack or from malloc) for zt_reset(),
+// which keeps the table cache and dictionary list as they are; everything
+// else is cleared there
+//
+static void zt_init_temp(zt_state *state)
+{
+    state->pCache = NULL;
+    state->pDicts = NULL;
+    state->u32DictCount = 0;
+} /* zt_init_temp() */
+//
+// Prepare a decoder for a new stream. Unlike zt_init(), this only clears
+// the variables and not the 6K+ of table building space, and it keeps the
+// table cache and registered dictionaries (if any). The window, segment
+// list, checksum and dictionary settings are cleared, so enable them again
+// if they're needed.
+//
+int zt_reset(zt_state *state)
+{
+    zt_table_cache *pCache;
+    zt_dict *pDicts;
+    uint32_t u32DictCount;
+
+    if (state == NULL) return ZT_INVALID_PARAMETER;
+    pCache = state->pCache;
+    pDicts = state->pDicts;
+    u32DictCount = state->u32DictCount;
+    memset(state, 0, offsetof(zt_state, lens));
+    state->pCache = pCache;
+    state->pDicts = pDicts;
+    state->u32DictCount = u32DictCount;
+    return ZT_SUCCESS;
+} /* zt_reset() */
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+//
+// CRC-32 of a multiple of 16 bytes (at least 64) with carry-less multiplies.
+// Four 128-bit lanes are folded in parallel, then folded into one and
+// Barrett reduced to 32 bits. The constants are from Intel's paper "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// The CRC is passed in and returned pre-inverted.
+//
+static uint32_t zt_crc32_pclmul(uint32_t u32CRC, const uint8_t *pData, int iLen)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+    const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124LL);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((const __m128i *)pData);
+    x2 = _mm_loadu_si128((const __m128i *)(pData + 16));
+    x3 = _mm_loadu_si128((const __m128i *)(pData + 32));
+    x4 = _mm_loadu_si128((const __m128i *)(pData + 48));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)u32CRC));
+    pData += 64;
+    iLen -= 64;
+    while (iLen >= 64) { // fold 4 x 128 bits at a time
+        x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)pData));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(pData + 16)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(pData + 32)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(pData + 48)));
+        pData += 64;
+        iLen -= 64;
+    }
+    // fold the 4 lanes into 1
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+    while (iLen >= 16) { // fold the remaining 128-bit blocks
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)pData)), x5);
+        pData += 16;
+        iLen -= 16;
+    }
+    // fold 128 bits to 64
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    // Barrett reduction to 32 bits
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+} /* zt_crc32_pclmul() */
+#endif
+//
+// Update a running CRC-32 (start with 0), the same as zlib's crc32()
+// Uses the ARMv8 CRC32 instructions or PCLMULQDQ when the compiler
+// targets them, otherwise the slicing-by-8 tables (1 table on 32-bit CPUs)
+//
+uint32_t zt_crc32(uint32_t u32CRC, const uint8_t *pData, int iLen)
+{
+    u32CRC = ~u32CRC;
+#if defined(__ARM_FEATURE_CRC32)
+    while (iLen && ((intptr_t)pData & 7)) {
+        u32CRC = __crc32b(u32CRC, *pData++);
+        iLen--;
+    }
+#if REGISTER_WIDTH == 64
+    while (iLen >= 8) {
+        u32CRC = __crc32d(u32CRC, *(const uint64_t *)pData);
+        pData += 8;
+        iLen -= 8;
+    }
+#endif
+    while (iLen >= 4) {
+        u32CRC = __crc32w(u32CRC, *(const uint32_t *)pData);
+        pData += 4;
+        iLen -= 4;
+    }
+#else
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+    if (iLen >= 64) {
+        u32CRC = zt_crc32_pclmul(u32CRC, pData, iLen & ~15);
+        pData += (iLen & ~15);
+        iLen &= 15;
+    }
+#endif
+#if CRC_SLICES == 8
+    while (iLen && ((intptr_t)pData & 7)) {
+        u32CRC = zt_crc_table[0][(u32CRC ^ *pData++) & 0xff] ^ (u32CRC >> 8);
+        iLen--;
+    }
+    while (iLen >= 8) { // 8 bytes at a time (little-endian)
+        uint32_t u32One = *(const uint32_t *)pData ^ u32CRC;
+        uint32_t u32Two = *(const uint32_t *)&pData[4];
+        u32CRC = zt_crc_table[7][u32One & 0xff] ^ zt_crc_table[6][(u32One >> 8) & 0xff] ^
+                 zt_crc_table[5][(u32One >> 16) & 0xff] ^ zt_crc_table[4][u32One >> 24] ^
+                 zt_crc_table[3][u32Two & 0xff] ^ zt_crc_table[2][(u32Two >> 8) & 0xff] ^
+                 zt_crc_table[1][(u32Two >> 16) & 0xff] ^ zt_crc_table[0][u32Two >> 24];
+        pData += 8;
+        iLen -= 8;
+    }
+#endif // CRC_SLICES
+#endif // __ARM_FEATURE_CRC32
+    while (iLen--) {
+#if defined(__ARM_FEATURE_CRC32)
+        u32CRC = __crc32b(u32CRC, *pData++);
+#else
+        u32CRC = zt_crc_table[0][(u32CRC ^ *pData++) & 0xff] ^ (u32CRC >> 8);
+#endif
+    }
+    return ~u32CRC;
+} /* zt_crc32() */
+//
+// Update a running Adler-32 (start with 1), the same as zlib's adler32()
+// The sums are only reduced every 5552 bytes; that's the most which can be
+// added before the 32-bit sum of sums could overflow
+//
+uint32_t zt_adler32(uint32_t u32Adler, const uint8_t *pData, int iLen)
+{
+    uint32_t a = u32Adler & 0xffff, b = u32Adler >> 16;
+    int i, iCount;
+
+    while (iLen > 0) {
+        iCount = (iLen < 5552) ? iLen : 5552;
+        iLen -= iCount;
+        while (iCount >= 8) {
+            a += pData[0]; b += a;
+            a += pData[1]; b += a;
+            a += pData[2]; b += a;
+            a += pData[3]; b += a;
+            a += pData[4]; b += a;
+            a += pData[5]; b += a;
+            a += pData[6]; b += a;
+            a += pData[7]; b += a;
+            pData += 8;
+            iCount -= 8;
+        }
+        for (i=0; i<iCount; i++) {
+            a += *pData++; b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+} /* zt_adler32() */
+//
+// Add newly decoded data to the running checksum (if enabled)
+//
+static inline void zt_update_check(zt_state *state, uint8_t *pData, unsigned len)
+{
+    if (state->u8CheckType == ZT_CHECK_CRC32) {
+        state->u32Check = zt_crc32(state->u32Check, pData, (int)len);
+    } else if (state->u8CheckType == ZT_CHECK_ADLER32) {
+        state->u32Check = zt_adler32(state->u32Check, pData, (int)len);
+    }
+} /* zt_update_check() */
+//
+// Check for the start of a gzip member where one is expected (the start
+// of the file or right after a trailer); like gzip, anything with the ID
+// bytes, deflate and no reserved flags is taken as one
+//
+static int zt_gzip_member_start(const uint8_t *s)
+{
+    return (s[0] == 0x1f && s[1] == 0x8b && s[2] == 0x08 && (s[3] & 0xe0) == 0);
+} /* zt_gzip_member_start() */
+//
+// Stricter check used when searching for a member boundary in the middle
+// of the data; the XFL and OS values have to be known ones too
+//
+static int zt_gzip_magic(const uint8_t *s)
+{
+    return (zt_gzip_member_start(s) && (s[8] == 0 || s[8] == 2 || s[8] == 4) && (s[9] <= 13 || s[9] == 255));
+} /* zt_gzip_magic() */
+//
+// BGZF (bgzip) members store their total size in a 'BC' extra field,
+// so the boundaries can be found without decoding anything.
+// Returns the member size or 0 if it's not there (or doesn't make sense)
+//
+static size_t zt_bgzf_size(const uint8_t *s, size_t iSize)
+{
+    const uint8_t *p, *pEnd;
+    size_t iMember;
+    unsigned len;
+
+    if (iSize < 18 || (s[3] & 4) == 0) return 0; // no extra field
+    len = s[10] | (s[11] << 8);
+    p = &s[12];
+    pEnd = (len > iSize - 12) ? &s[iSize] : p + len;
+    while (pEnd - p >= 4) { // walk the subfields
+        len = p[2] | (p[3] << 8);
+        if (p[0] == 'B' && p[1] == 'C' && len == 2 && pEnd - p >= 6) {
+            iMember = (size_t)(p[4] | (p[5] << 8)) + 1;
+            // smaller than the smallest member or past the end; search instead
+            return (iMember < 20 || iMember > iSize) ? 0 : iMember;
+        }
+        p += 4 + len;
+    }
+    return 0;
+} /* zt_bgzf_size() */
+static uint8_t *zt_gzip_header(uint8_t *pCompressed, size_t iSize);
+//
+// Check if a possible gzip header at s really looks like the start of a
+// new member which follows the one at pMember. Besides the header itself,
+// the first deflate block header has to be valid and the ISIZE in the
+// trailer before it has to fit the compressed size of the previous member
+// (deflate can't expand data much or compress it more than 1032:1)
+//
+static int zt_member_plausible(uint8_t *pMember, uint8_t *s, uint8_t *pEnd)
+{
+    uint8_t *d = zt_gzip_header(s, (size_t)(pEnd - s));
+    size_t iInSize = (size_t)(s - pMember);
+    uint32_t u32OutSize = *(uint32_t *)&s[-4];
+
+    if (d == NULL || pEnd - d < 5) return 0;
+    switch ((d[0] >> 1) & 3) { // first block type
+        case 0: // stored; LEN and NLEN must match
+            if ((d[1] ^ d[3]) != 0xff || (d[2] ^ d[4]) != 0xff) return 0;
+            break;
+        case 2: // dynamic; at most 286 length and 30 distance codes
+            if ((d[0] >> 3) > 29 || (d[1] & 31) > 29) return 0;
+            break;
+        case 3: // reserved
+            return 0;
+    }
+    if ((uint64_t)u32OutSize > (uint64_t)iInSize * 1032 || iInSize > (size_t)u32OutSize * 2 + 64) {
+        return 0;
+    }
+    return 1;
+} /* zt_member_plausible() */
+//
+// Find the start of the gzip member which follows the one at pMember
+// or return pEnd if there isn't one. Unless it's a BGZF file, this is a
+// search for the next plausible header, so it can be fooled by compressed
+// data which happens to look like one. Callers which decode members
+// independently must confirm each boundary (see zt_gunzip_parallel).
+//
+static uint8_t *zt_next_member(uint8_t *pMember, uint8_t *pEnd)
+{
+    uint8_t *s;
+    size_t iSize = zt_bgzf_size(pMember, (size_t)(pEnd - pMember));
+
+    if (iSize) {
+        return pMember + iSize;
+    }
+    s = pMember + 20; // smallest member = 10 byte header + 2 bytes of deflate + 8 byte trailer
+    while (pEnd - s >= 18) {
+        s = (uint8_t *)memchr(s, 0x1f, (size_t)(pEnd - s) - 17);
+        if (s == NULL) break;
+        if (zt_gzip_magic(s) && zt_member_plausible(pMember, s, pEnd)) return s;
+        s++;
+    }
+    return pEnd;
+} /* zt_next_member() */
+//
+// Read the ISIZE from the trailer of the member from s to pEnd
+// Returns 0 if it's too short to have one
+//
+static uint32_t zt_member_isize(const uint8_t *s, const uint8_t *pEnd)
+{
+    if (pEnd - s < 18) return 0;
+    return *(uint32_t *)&pEnd[-4];
+} /* zt_member_isize() */
+//
+// Find the members of a gzip file (concatenated gzip streams as written by
+// pigz, bgzip or by appending to a .gz file) and the offset of each one's
+// uncompressed data from the ISIZE in its trailer. Fills in up to iMaxMembers
+// entries (pMembers can be NULL to just count them) and returns the count.
+// The output size is pMembers[n-1].iOutOffset + pMembers[n-1].u32OutSize
+//
+int zt_gzip_members(uint8_t *pCompressed, size_t iSize, zt_member *pMembers, int iMaxMembers)
+{
+    uint8_t *s, *pNext, *pEnd = pCompressed + iSize;
+    size_t iOutOffset = 0;
+    uint32_t u32OutSize;
+    int iCount = 0;
+
+    if (pCompressed == NULL || iSize < 18 || !zt_gzip_member_start(pCompressed)) {
+        return 0;
+    }
+    for (s = pCompressed; s < pEnd; s = pNext) {
+        pNext = zt_next_member(s, pEnd);
+        u32OutSize = zt_member_isize(s, pNext);
+        if (pMembers && iCount < iMaxMembers) {
+            pMembers[iCount].iInOffset = (size_t)(s - pCompressed);
+            pMembers[iCount].iInSize = (size_t)(pNext - s);
+            pMembers[iCount].iOutOffset = iOutOffset;
+            pMembers[iCount].u32OutSize = u32OutSize;
+            pMembers[iCount].iResult = ZT_SUCCESS;
+        }
+        iOutOffset += u32OutSize;
+        iCount++;
+    }
+    return iCount;
+} /* zt_gzip_members() */
+//
 // Return uncompressed size and optional filename info
 // about a gzip compressed block of data. An invalid block
 // or other error will return 0 as the data size
+// For multi-member files, the size is the total of all members which the
+// search in zt_next_member() finds; a member whose header has an XFL or OS
+// value gzip doesn't write is only found by decoding, so it isn't counted
 //
 uint32_t zt_gzip_info(uint8_t *pCompressed, int iSize, char *szName, uint32_t *pu32Time)
 {
     uint32_t iUncompSize;
-    uint8_t u8Flags, u8ExtraFlags, *s = pCompressed;
-    // Parse the gzip header
-    if (s[0] != 0x1f || s[1] != 0x8b || s[2] != 0x08) { // not a gzip file
-//        printf("Not a gzip file!\n");
+    uint8_t *s = pCompressed, *pNext;
+
+    if (pCompressed == NULL || zt_gzip_header(pCompressed, (size_t)iSize) == NULL) { // not a gzip file
         return 0;
     }
-    s += 3;
-    u8Flags = *s++;
     if (pu32Time) {
-        *pu32Time = *(uint32_t *)s; // Unix time stamp
+        *pu32Time = (uint32_t)(s[4] | (s[5] << 8) | (s[6] << 16) | ((uint32_t)s[7] << 24)); // Unix time stamp
     }
-    s += 4;
-    u8ExtraFlags = *s++;
-    s++; // skip the operating system
-    
-    if (u8Flags & 1) { // text
-        s += strlen((const char *)s) + 1;
+    if (szName) { // the name comes after the extra field (if any)
+        szName[0] = 0;
+        s += 10;
+        if (pCompressed[3] & 4) {
+            s += 2 + (s[0] | (s[1] << 8));
+        }
+        if (pCompressed[3] & 8) {
+            strcpy(szName, (const char *)s); // zt_gzip_header() found its terminator
+        }
     }
-    if (u8Flags & 2) { // header crc
+    // The last 4 bytes of each member have its uncompressed size
+    iUncompSize = 0;
+    for (s = pCompressed; s < &pCompressed[iSize]; s = pNext) {
+        pNext = zt_next_member(s, &pCompressed[iSize]);
+        iUncompSize += zt_member_isize(s, pNext);
     }
-    if (u8Flags & 4) {// "Extra" follows
+    return iUncompSize;
+} /* zt_gzip_info() */
+
+//
+// Find the length of the gzip header at s (the fixed 10 bytes and the
+// optional extra field, name, comment and header CRC). The header CRC
+// is checked if there is one. Returns ZT_INPUT_INSUFFICIENT if the header
+// doesn't all fit in iSize bytes or ZT_HEADER_ERROR if it isn't valid.
+//
+static int zt_gzip_header_len(const uint8_t *pHeader, size_t iSize, size_t *piLen)
+{
+    const uint8_t *s = pHeader, *pEnd = &pHeader[iSize];
+    uint8_t u8Flags;
+
+    if (iSize >= 1 && s[0] != 0x1f) return ZT_HEADER_ERROR;
+    if (iSize >= 2 && s[1] != 0x8b) return ZT_HEADER_ERROR;
+    if (iSize >= 3 && s[2] != 0x08) return ZT_HEADER_ERROR; // only deflate is defined
+    if (iSize >= 4 && (s[3] & 0xe0)) return ZT_HEADER_ERROR; // reserved flags must be 0
+    if (iSize < 10) return ZT_INPUT_INSUFFICIENT;
+    u8Flags = s[3];
+    s += 10; // skip the time stamp, extra flags and operating system
+    if (u8Flags & 4) { // "Extra" follows
+        if (pEnd - s < 2 || pEnd - s - 2 < (s[0] | (s[1] << 8))) return ZT_INPUT_INSUFFICIENT;
+        s += 2 + (s[0] | (s[1] << 8));
     }
     if (u8Flags & 8) { // Name follows
-        if (szName) {
-            strcpy(szName, (const char *)s);
+        s = (const uint8_t *)memchr(s, 0, (size_t)(pEnd - s));
+        if (s == NULL) return ZT_INPUT_INSUFFICIENT;
+        s++;
+    }
+    if (u8Flags & 0x10) { // comment follows
+        s = (const uint8_t *)memchr(s, 0, (size_t)(pEnd - s));
+        if (s == NULL) return ZT_INPUT_INSUFFICIENT;
+        s++;
+    }
+    if (u8Flags & 2) { // header crc (the low 16 bits of the CRC-32 of the header so far)
+        if (pEnd - s < 2) return ZT_INPUT_INSUFFICIENT;
+        if ((zt_crc32(0, pHeader, (int)(s - pHeader)) & 0xffff) != (uint32_t)(s[0] | (s[1] << 8))) {
+            return ZT_HEADER_ERROR;
         }
-        s += strlen((const char *)s) + 1;
+        s += 2;
     }
-    iUncompSize = *(uint32_t *)&pCompressed[iSize-4]; // last 4 bytes has uncompressed size
-    return iUncompSize;
-} /* zt_gzip_info() */
+    *piLen = (size_t)(s - pHeader);
+    return ZT_SUCCESS;
+} /* zt_gzip_header_len() */
+//
+// Skip the gzip header and return a pointer to the deflate data
+// or NULL if it's not a gzip stream
+//
+static uint8_t *zt_gzip_header(uint8_t *pCompressed, size_t iSize)
+{
+    size_t iLen;
 
-int zt_gunzip(uint8_t *pCompressed, int iSize, uint8_t *pUncompressed)
+    if (iSize < 18 || zt_gzip_header_len(pCompressed, iSize, &iLen) != ZT_SUCCESS || iLen >= iSize) {
+        return NULL;
+    }
+    return &pCompressed[iLen];
+} /* zt_gzip_header() */
+//
+// Detect the format of compressed data from its first few bytes: a gzip
+// header, a zlib header (deflate, a valid window size and FCHECK) or else
+// raw deflate, if the first block header is valid. Since anything can be
+// raw deflate, that's only a guess, but the zlib and gzip headers are
+// checked first and a raw stream rarely looks like one of them.
+// Returns ZT_FORMAT_xxx or -1 if it's none of them.
+//
+int zt_detect_format(const uint8_t *pData, size_t iSize)
 {
-    zt_state state;
-    zt_buffer buffer;
-    uint8_t *s, u8Flags, u8ExtraFlags;
-    int rc;
-    uint64_t iCompSize, iUncompSize;
-    
-    zt_init(&state);
-    state.wbits = 15; // fixed value for GZIP data
+    size_t iLen;
 
-    s = pCompressed;
-    // Parse the gzip header
-    if (s[0] != 0x1f || s[1] != 0x8b || s[2] != 0x08) { // not a gzip file
-      //  printf("Not a gzip file!\n");
-        return ZT_HEADER_ERROR;
+    if (pData == NULL || iSize < 2) return -1;
+    if (pData[0] == 0x1f && pData[1] == 0x8b) {
+        return (zt_gzip_header_len(pData, iSize, &iLen) == ZT_HEADER_ERROR) ? -1 : ZT_FORMAT_GZIP;
     }
-    s += 3;
-    u8Flags = *s++;
-//    u32Time = *(uint32_t *)s; // Unix time stamp
-    s += 4;
-    u8ExtraFlags = *s++;
-    s++; // skip the operating system
-    
-    if (u8Flags & 1) { // text
-        s += strlen((const char *)s) + 1;
+    if ((pData[0] & 0xf) == 8 && (pData[0] >> 4) <= 7 && ((pData[0] << 8) | pData[1]) % 31 == 0) {
+        return ZT_FORMAT_ZLIB;
     }
-    if (u8Flags & 2) { // header crc
+    switch ((pData[0] >> 1) & 3) { // first block type
+        case 0: // stored; LEN and NLEN must match
+            if (iSize >= 5 && ((pData[1] ^ pData[3]) != 0xff || (pData[2] ^ pData[4]) != 0xff)) return -1;
+            break;
+        case 2: // dynamic; at most 286 length and 30 distance codes
+            if ((pData[0] >> 3) > 29 || (pData[1] & 31) > 29) return -1;
+            break;
+        case 3: // reserved
+            return -1;
     }
-    if (u8Flags & 4) {// "Extra" follows
+    return ZT_FORMAT_RAW;
+} /* zt_detect_format() */
+//
+// Check the trailer of a gzip member which was just decoded and find the
+// start of the next member (*ppNext = NULL if there isn't one).
+// The deflate data ends on a byte boundary, so the whole bytes which are
+// still in the bit accumulator belong to the trailer.
+//
+static int zt_gzip_trailer(zt_state *state, zt_buffer *buffer, uint8_t *pEnd, int bVerify, uint8_t **ppNext)
+{
+    uint8_t *s = buffer->next_in - (state->ulBitCount >> 3);
+
+    if (pEnd - s < 8) {
+        return ZT_INPUT_INSUFFICIENT;
     }
-    if (u8Flags & 8) { // Name follows
-        //strcpy(szOutName, (const char *)s);
-        s += strlen((const char *)s) + 1;
+    if (bVerify && (state->u32Check != *(uint32_t *)s || buffer->total_out != *(uint32_t *)&s[4])) {
+        return ZT_CHECKSUM_ERROR;
     }
-    iUncompSize = *(uint32_t *)&pCompressed[iSize-4]; // last 4 bytes has uncompressed size
-//    printf("Compressed size = %ul, uncompressed size = %ul\n", iCompSize, iUncompSize);
-    buffer.avail_in = (uint32_t)(iSize - 8 - (int)(s - pCompressed));
-    buffer.next_in = s;
-    buffer.avail_out = (uint32_t)iUncompSize;
-    buffer.total_out = 0;
-    buffer.next_out = pUncompressed;
-    rc = zt_inflate(&state, &buffer, 1);
+    s += 8;
+    *ppNext = (pEnd - s >= 18 && zt_gzip_member_start(s)) ? s : NULL;
+    return ZT_SUCCESS;
+} /* zt_gzip_trailer() */
+//
+// Decode the gzip member(s) from s to pEnd one after the other into the
+// output buffer (pOut to pOutEnd); the end of the output is returned in
+// *ppOutEnd if it's not NULL
+//
+static int zt_gunzip_serial(zt_state *state, uint8_t *s, uint8_t *pEnd, uint8_t *pOut, uint8_t *pOutEnd, int bVerify, uint8_t **ppOutEnd)
+{
+    zt_buffer buffer;
+    int rc;
+
+    buffer.next_out = pOut;
+    do {
+        zt_reset(state);
+        state->wbits = 15; // fixed value for GZIP data
+        if (bVerify) {
+            zt_init_check(state, ZT_CHECK_CRC32);
+        }
+        s = zt_gzip_header(s, (size_t)(pEnd - s));
+        if (s == NULL) {
+            return ZT_HEADER_ERROR;
+        }
+        // the input runs to the end of the data (the trailer and any members
+        // which follow); zt_inflate() stops at the end of the deflate data
+        buffer.avail_in = ((size_t)(pEnd - s) > 0xffffffff) ? 0xffffffff : (uint32_t)(pEnd - s);
+        buffer.next_in = s;
+        buffer.total_in = 0;
+        buffer.avail_out = ((size_t)(pOutEnd - buffer.next_out) > 0xffffffff) ? 0xffffffff : (uint32_t)(pOutEnd - buffer.next_out);
+        buffer.total_out = 0; // members are independent; no references to the previous one
+        rc = zt_inflate(state, &buffer, 1);
+        if (rc == ZT_SUCCESS) {
+            rc = zt_gzip_trailer(state, &buffer, pEnd, bVerify, &s);
+        }
+    } while (rc == ZT_SUCCESS && s != NULL);
+    if (ppOutEnd) *ppOutEnd = buffer.next_out;
     return rc;
-} /* zt_gunzip() */
+} /* zt_gunzip_serial() */
+//
+// Unzip gzip data in one shot. The output buffer must be large enough to
+// hold the uncompressed size (see zt_gzip_info).
+// Multi-member files are decoded one member after the other.
+//
+int zt_gunzip(uint8_t *pCompressed, int iSize, uint8_t *pUncompressed)
+{
+    zt_state state;
 
+    zt_init_temp(&state); // zt_reset() takes care of the rest
+    return zt_gunzip_reuse(&state, pCompressed, iSize, pUncompressed, 0);
+} /* zt_gunzip() */
 //
-// Inflate the given deflated data into the output buffer
-// This can be called repeatedly with small chunks of data,
-// ** BUT ** the output buffer must be allocated large enough
-// to hold all of the decompressed data in one shot. This is so
-// that a separate memory window does not need to exist. This
-// behavior diverges from the original zlib, but allows for a
-// simpler implementation that's also faster.
+// Same as zt_gunzip(), but the CRC-32 and size in the gzip trailer of each
+// member are checked against the output (ZT_CHECKSUM_ERROR if they don't match)
 //
-// returns:
+int zt_gunzip_verify(uint8_t *pCompressed, int iSize, uint8_t *pUncompressed)
+{
+    zt_state state;
+
+    zt_init_temp(&state);
+    return zt_gunzip_reuse(&state, pCompressed, iSize, pUncompressed, 1);
+} /* zt_gunzip_verify() */
 //
-// - ZT_SUCCESS (the current set of compressed blocks is fully decoded)
-// - ZT_ERROR... (an error occurred)
-// - ZT_INPUT_INSUFFICIENT (the decoding isn't complete; it needs more data)
+// Unzip gzip data in one shot (as zt_gunzip) with a decoder which is kept
+// by the caller. It's reset for each member instead of being cleared, and
+// a table cache attached to it (see zt_init_cache) is used for the dynamic
+// blocks, which saves time with many small files from the same encoder.
 //
-int zt_inflate(zt_state *state, zt_buffer *buffer, int bEnd)
+int zt_gunzip_reuse(zt_state *state, uint8_t *pCompressed, int iSize, uint8_t *pUncompressed, int bVerify)
 {
-    int ret, iLen;
-    BIGUINT ulBitCount, ulBits, lmask, dmask;
-    uint8_t *pBuf;
-    uint8_t *pEndOfInput, *pEndOfOutput;
-    uint8_t *pOut;
-    uint32_t u32;
-    int i;
-    int bLastBlock = 0;
-    uint8_t u8, *from;
-    unsigned int op, dist, copy, len;
-    int nlen, ndist, ncode; // huffman table vars
-    code here;
-    code const *lcode;
-    code const *dcode;
-    
-    if (state == NULL || buffer == NULL) return ZT_INVALID_PARAMETER;
-    state->iLastError = ZT_SUCCESS; // start by assuming success
-    pOut = buffer->next_out;
-    pBuf = buffer->next_in;
-    
-    pEndOfOutput = (uint8_t *)buffer->next_out + buffer->avail_out;
-    pEndOfInput = &pBuf[(buffer->avail_in)-sizeof(BIGUINT)]; // keep it from reading past the end
-    if (bEnd) {
-        pEndOfInput += sizeof(BIGUINT) + sizeof(BIGUINT)/2; // this is the final blob of data, let it read until the last byte
-    }
-    // Get some data to start
-    ulBitCount = state->ulBitCount;
-    ulBits = state->ulBits;
-    if (ulBitCount <= REGISTER_WIDTH/2) {
-        GETMOREBITS
-    }
-    if (ulBitCount <= REGISTER_WIDTH/2) { // we must be starting from 0
-        GETMOREBITS
+    uint32_t iUncompSize;
+    int rc;
+
+    if (state == NULL) return ZT_INVALID_PARAMETER;
+    if (pCompressed == NULL || iSize < 18) return ZT_HEADER_ERROR;
+    // Most files have a single member and the size in the last trailer
+    // covers all of it. Only search the data for the member boundaries to
+    // get the total when that isn't enough, since the search can take as
+    // long as decoding incompressible data.
+    iUncompSize = *(uint32_t *)&pCompressed[iSize-4];
+    rc = zt_gunzip_serial(state, pCompressed, &pCompressed[iSize], pUncompressed, &pUncompressed[iUncompSize], bVerify, NULL);
+    if (rc == ZT_OUTPUT_INSUFFICIENT) {
+        iUncompSize = zt_gzip_info(pCompressed, iSize, NULL, NULL); // total of all members
+        rc = zt_gunzip_serial(state, pCompressed, &pCompressed[iSize], pUncompressed, &pUncompressed[iUncompSize], bVerify, NULL);
     }
-    if (state->wbits == 0) { // header hasn't been parsed yet
-        // assume zlib header
+    return rc;
+} /* zt_gunzip_reuse() */
+//
+// Unzip gzip data in streaming mode. The output is produced in chunks
+// of up to iChunkSize bytes which are passed to the callback function.
+// pWindow must point to ZT_MAX_WINDOW (32K) bytes of memory.
+// If bVerify is true, the gzip trailer is checked as in zt_gunzip_verify().
+//
+int zt_gunzip_stream(uint8_t *pCompressed, int iSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser, int bVerify)
+{
+    zt_state state;
+    zt_buffer buffer;
+    uint8_t *s, *pEnd;
+    int rc;
+
+    pEnd = &pCompressed[iSize];
+    s = pCompressed;
+    do {
+        zt_init(&state);
+        state.wbits = 15; // fixed value for GZIP data
+        if (zt_init_window(&state, pWindow, 15) != ZT_SUCCESS) {
+            return ZT_INVALID_PARAMETER;
+        }
+        if (bVerify) {
+            zt_init_check(&state, ZT_CHECK_CRC32);
+        }
+        s = zt_gzip_header(s, (size_t)(pEnd - s));
+        if (s == NULL) {
+            return ZT_HEADER_ERROR;
+        }
+        buffer.avail_in = (uint32_t)(pEnd - s);
+        buffer.next_in = s;
+        buffer.total_in = 0;
+        buffer.total_out = 0;
+        rc = zt_inflate_stream(&state, &buffer, 1, pChunk, iChunkSize, pfnOutput, pUser);
+        if (rc != ZT_SUCCESS || !state.bLastBlock || state.lenbits != 0) {
+            break; // error or the callback stopped us early
+        }
+        rc = zt_gzip_trailer(&state, &buffer, pEnd, bVerify, &s);
+    } while (rc == ZT_SUCCESS && s != NULL);
+    return rc;
+} /* zt_gunzip_stream() */
+//
+// Prepare to split the output of streaming mode into rows of iRowSize bytes
+// (e.g. one or more lines of a bitmap) which are passed to pfnRow one at a
+// time. Pass zt_rows_output as the output callback and pRows as its pUser.
+// Rows which are complete in the output chunk are passed from there without
+// being copied; only a row split between two chunks is collected in pRow
+// (iRowSize bytes). If pfnTransform isn't NULL, it's applied to each row in
+// place just before the callback, while the data is still in the cache.
+// The chunk is reused as soon as the callback returns, so a DMA transfer
+// from the row must finish before then.
+//
+int zt_init_rows(zt_rows *pRows, uint8_t *pRow, int iRowSize, ZT_ROW_CALLBACK *pfnRow, ZT_ROW_TRANSFORM *pfnTransform, void *pUser)
+{
+    if (pRows == NULL || pRow == NULL || iRowSize <= 0 || pfnRow == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    pRows->pRow = pRow;
+    pRows->u32RowSize = (uint32_t)iRowSize;
+    pRows->u32Have = 0;
+    pRows->u32Row = 0;
+    pRows->pfnRow = pfnRow;
+    pRows->pfnTransform = pfnTransform;
+    pRows->pUser = pUser;
+    return ZT_SUCCESS;
+} /* zt_init_rows() */
+//
+// Streaming mode output callback for row output (see zt_init_rows)
+// The window already has its copy of the chunk, so the transform can
+// safely change the data in place. If the row callback returns 0, the
+// rest of the chunk is dropped and decoding stops.
+//
+int zt_rows_output(void *pUser, uint8_t *pData, int iLen)
+{
+    zt_rows *pRows = (zt_rows *)pUser;
+    uint8_t *pRow;
+    uint32_t u32Copy;
+
+    while (iLen > 0) {
+        if (pRows->u32Have == 0 && (uint32_t)iLen >= pRows->u32RowSize) { // all of it is here
+            pRow = pData;
+            pData += pRows->u32RowSize;
+            iLen -= (int)pRows->u32RowSize;
+        } else { // collect the pieces
+            u32Copy = pRows->u32RowSize - pRows->u32Have;
+            if (u32Copy > (uint32_t)iLen) u32Copy = (uint32_t)iLen;
+            memcpy(&pRows->pRow[pRows->u32Have], pData, u32Copy);
+            pRows->u32Have += u32Copy;
+            pData += u32Copy;
+            iLen -= (int)u32Copy;
+            if (pRows->u32Have < pRows->u32RowSize) break;
+            pRows->u32Have = 0;
+            pRow = pRows->pRow;
+        }
+        if (pRows->pfnTransform) {
+            (*pRows->pfnTransform)(pRow, (int)pRows->u32RowSize);
+        }
+        if (!(*pRows->pfnRow)(pRows->pUser, (int)pRows->u32Row++, pRow, (int)pRows->u32RowSize)) {
+            return 0;
+        }
+    }
+    return 1;
+} /* zt_rows_output() */
+//
+// Pass the last row to the callback if the output size wasn't a multiple
+// of the row size (it's shorter than the others)
+//
+int zt_rows_flush(zt_rows *pRows)
+{
+    if (pRows == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    if (pRows->u32Have) {
+        if (pRows->pfnTransform) {
+            (*pRows->pfnTransform)(pRows->pRow, (int)pRows->u32Have);
+        }
+        (*pRows->pfnRow)(pRows->pUser, (int)pRows->u32Row++, pRows->pRow, (int)pRows->u32Have);
+        pRows->u32Have = 0;
+    }
+    return ZT_SUCCESS;
+} /* zt_rows_flush() */
+//
+// Row transform which swaps the bytes of each 16-bit value
+// (little-endian RGB565 pixels to the big-endian order most LCDs expect)
+//
+void zt_swap16(uint8_t *pData, int iLen)
+{
+    int i = 0;
+    uint8_t u8;
+#if defined(__SSSE3__)
+    const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i+16<=iLen; i+=16) {
+        _mm_storeu_si128((__m128i *)&pData[i], _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&pData[i]), mask));
+    }
+#elif defined(__SSE2__)
+    __m128i x;
+    for (; i+16<=iLen; i+=16) {
+        x = _mm_loadu_si128((const __m128i *)&pData[i]);
+        _mm_storeu_si128((__m128i *)&pData[i], _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i+16<=iLen; i+=16) {
+        vst1q_u8(&pData[i], vrev16q_u8(vld1q_u8(&pData[i])));
+    }
+#endif
+    for (; i+2<=iLen; i+=2) {
+        u8 = pData[i];
+        pData[i] = pData[i+1];
+        pData[i+1] = u8;
+    }
+} /* zt_swap16() */
+//
+// Unzip gzip data in streaming mode with the output split into rows
+// (see zt_init_rows); a short last row is passed along at the end
+//
+int zt_gunzip_rows(uint8_t *pCompressed, int iSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, zt_rows *pRows, int bVerify)
+{
+    int rc;
+
+    if (pRows == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    rc = zt_gunzip_stream(pCompressed, iSize, pWindow, pChunk, iChunkSize, zt_rows_output, pRows, bVerify);
+    if (rc == ZT_SUCCESS) {
+        rc = zt_rows_flush(pRows);
+    }
+    return rc;
+} /* zt_gunzip_rows() */
+//
+// Unzip gzip data into a scatter/gather list of output segments (see
+// zt_init_segments). The members of a multi-member file follow each other
+// in the list and the total output size is returned in *piOutSize.
+// If bVerify is true, the gzip trailer is checked as in zt_gunzip_verify().
+//
+int zt_gunzip_segments(uint8_t *pCompressed, int iSize, zt_segment *pSegs, int iSegCount, size_t *piOutSize, int bVerify)
+{
+    zt_state state;
+    zt_buffer buffer;
+    uint8_t *s, *pEnd;
+    uint32_t u32Seg = 0, u32SegPos = 0;
+    size_t iOutSize = 0;
+    int rc;
+
+    if (pCompressed == NULL || iSize < 18) return ZT_HEADER_ERROR;
+    pEnd = &pCompressed[iSize];
+    s = pCompressed;
+    zt_init_temp(&state);
+    do {
+        zt_reset(&state);
+        state.wbits = 15; // fixed value for GZIP data
+        if (zt_init_segments(&state, pSegs, iSegCount) != ZT_SUCCESS) {
+            return ZT_INVALID_PARAMETER;
+        }
+        state.u32Seg = u32Seg; // pick up where the last member ended
+        state.u32SegPos = u32SegPos;
+        if (bVerify) {
+            zt_init_check(&state, ZT_CHECK_CRC32);
+        }
+        s = zt_gzip_header(s, (size_t)(pEnd - s));
+        if (s == NULL) {
+            return ZT_HEADER_ERROR;
+        }
+        buffer.avail_in = (uint32_t)(pEnd - s);
+        buffer.next_in = s;
+        buffer.total_in = 0;
+        buffer.total_out = 0;
+        rc = zt_inflate_segments(&state, &buffer, 1);
+        iOutSize += buffer.total_out;
+        u32Seg = state.u32Seg;
+        u32SegPos = state.u32SegPos;
+        if (rc == ZT_SUCCESS) {
+            rc = zt_gzip_trailer(&state, &buffer, pEnd, bVerify, &s);
+        }
+    } while (rc == ZT_SUCCESS && s != NULL);
+    if (piOutSize) *piOutSize = iOutSize;
+    return rc;
+} /* zt_gunzip_segments() */
+//
+// Decode one item of a batch (see zt_inflate_batch)
+//
+static int zt_inflate_item(zt_state *state, zt_batch_item *pItem, int bVerify)
+{
+    zt_buffer buffer;
+    uint8_t *pOutEnd;
+    int rc, iFormat;
+
+    pItem->iOutLen = 0;
+    if (pItem->pIn == NULL || pItem->pOut == NULL) return ZT_INVALID_PARAMETER;
+    iFormat = pItem->u8Format;
+    if (iFormat == ZT_FORMAT_AUTO) {
+        iFormat = zt_detect_format(pItem->pIn, pItem->iInSize);
+        if (iFormat < 0) return ZT_HEADER_ERROR;
+    }
+    if (iFormat == ZT_FORMAT_GZIP) {
+        if (pItem->iInSize < 18) return ZT_HEADER_ERROR;
+        rc = zt_gunzip_serial(state, pItem->pIn, &pItem->pIn[pItem->iInSize], pItem->pOut, &pItem->pOut[pItem->iOutSize], bVerify, &pOutEnd);
+        pItem->iOutLen = (size_t)(pOutEnd - pItem->pOut);
+        return rc;
+    }
+    if (iFormat != ZT_FORMAT_ZLIB && iFormat != ZT_FORMAT_RAW) return ZT_INVALID_PARAMETER;
+    zt_reset(state);
+    if (iFormat == ZT_FORMAT_RAW) {
+        state->wbits = 15; // no zlib header
+    } else if (bVerify) {
+        zt_init_check(state, ZT_CHECK_ADLER32);
+    }
+    buffer.next_in = pItem->pIn;
+    buffer.avail_in = (pItem->iInSize > 0xffffffff) ? 0xffffffff : (uint32_t)pItem->iInSize;
+    buffer.total_in = 0;
+    buffer.next_out = pItem->pOut;
+    buffer.avail_out = (pItem->iOutSize > 0xffffffff) ? 0xffffffff : (uint32_t)pItem->iOutSize;
+    buffer.total_out = 0;
+    rc = zt_inflate(state, &buffer, 1);
+    pItem->iOutLen = buffer.total_out;
+    if (rc == ZT_SUCCESS && (!state->bLastBlock || state->lenbits != 0 || state->u8CheckType != ZT_CHECK_NONE)) {
+        rc = ZT_INPUT_INSUFFICIENT; // the stream (or its trailer) was cut short
+    }
+    return rc;
+} /* zt_inflate_item() */
+//
+// Decode a batch of small independent gzip, zlib or raw deflate streams
+// with one decoder. Each item has its own input, output and format (or
+// ZT_FORMAT_AUTO to detect it, see zt_detect_format) and gets its own result (and output size). The decoder is only reset between the
+// items, and if it has a table cache (see zt_init_cache) the streams share
+// it, which is where most of the savings over separate zt_gunzip() calls
+// come from. state can be NULL to use a temporary decoder without a cache.
+// Returns ZT_SUCCESS or the error of the first item which failed.
+//
+int zt_inflate_batch(zt_state *state, zt_batch_item *pItems, int iCount, int bVerify)
+{
+    zt_state tmpState;
+    int i, rc = ZT_SUCCESS;
+
+    if (pItems == NULL || iCount < 0) return ZT_INVALID_PARAMETER;
+    if (state == NULL) {
+        state = &tmpState;
+        zt_init_temp(state);
+    }
+    for (i=0; i<iCount; i++) {
+        pItems[i].iResult = zt_inflate_item(state, &pItems[i], bVerify);
+        if (rc == ZT_SUCCESS) rc = pItems[i].iResult;
+    }
+    return rc;
+} /* zt_inflate_batch() */
+//
+// Decode a gzip, zlib or raw deflate stream in memory without knowing which
+// it is (see zt_detect_format). gzip goes through the same path as
+// zt_gunzip() (all members, trailers checked if bVerify is true) and the
+// others are decoded with one zt_inflate() call, straight into pOut.
+// state can be NULL to use a temporary decoder. The size of the output is
+// returned in *piOutSize if it's not NULL. For data over 4GB, use
+// zt_inflate_mem().
+//
+int zt_inflate_auto(zt_state *state, uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int bVerify)
+{
+    zt_state tmpState;
+    zt_buffer buffer;
+    uint8_t *pOutEnd;
+    int rc, iFormat;
+
+    if (piOutSize) *piOutSize = 0;
+    if (pIn == NULL || pOut == NULL || iInSize > 0xffffffff || iOutSize > 0xffffffff) {
+        return ZT_INVALID_PARAMETER;
+    }
+    if (state == NULL) {
+        state = &tmpState;
+        zt_init_temp(state);
+    }
+    iFormat = zt_detect_format(pIn, iInSize);
+    if (iFormat < 0) return ZT_HEADER_ERROR;
+    if (iFormat == ZT_FORMAT_GZIP) {
+        pOutEnd = pOut;
+        rc = zt_gunzip_serial(state, pIn, &pIn[iInSize], pOut, &pOut[iOutSize], bVerify, &pOutEnd);
+        if (piOutSize) *piOutSize = (size_t)(pOutEnd - pOut);
+        return rc;
+    }
+    zt_reset(state);
+    zt_init_format(state, iFormat);
+    if (iFormat == ZT_FORMAT_ZLIB && bVerify) {
+        zt_init_check(state, ZT_CHECK_ADLER32);
+    }
+    buffer.next_in = pIn;
+    buffer.avail_in = (uint32_t)iInSize;
+    buffer.total_in = 0;
+    buffer.next_out = pOut;
+    buffer.avail_out = (uint32_t)iOutSize;
+    buffer.total_out = 0;
+    rc = zt_inflate(state, &buffer, 1);
+    if (piOutSize) *piOutSize = buffer.total_out;
+    if (rc == ZT_SUCCESS && (!state->bLastBlock || state->lenbits != 0 || state->u8CheckType != ZT_CHECK_NONE)) {
+        rc = ZT_INPUT_INSUFFICIENT; // the stream (or its trailer) was cut short
+    }
+    return rc;
+} /* zt_inflate_auto() */
+#ifdef ZT_THREADS
+//
+// Decode a single member of a multi-member gzip file into its slice of the
+// output and confirm that its boundaries and size are what the scan in
+// zt_gzip_members() guessed
+//
+static int zt_gunzip_member(uint8_t *pCompressed, zt_member *pMember, uint8_t *pUncompressed, int bVerify)
+{
+    zt_state state;
+    zt_buffer buffer;
+    uint8_t *s, *pEnd, *pNext;
+    int rc;
+
+    zt_init(&state);
+    state.wbits = 15;
+    if (bVerify) {
+        zt_init_check(&state, ZT_CHECK_CRC32);
+    }
+    s = &pCompressed[pMember->iInOffset];
+    pEnd = s + pMember->iInSize;
+    s = zt_gzip_header(s, pMember->iInSize);
+    if (s == NULL) {
+        return ZT_HEADER_ERROR;
+    }
+    buffer.avail_in = (uint32_t)(pEnd - s);
+    buffer.next_in = s;
+    buffer.total_in = 0;
+    buffer.next_out = &pUncompressed[pMember->iOutOffset];
+    buffer.avail_out = pMember->u32OutSize;
+    buffer.total_out = 0;
+    rc = zt_inflate(&state, &buffer, 1);
+    if (rc == ZT_SUCCESS) {
+        rc = zt_gzip_trailer(&state, &buffer, pEnd, bVerify, &pNext);
+    }
+    if (rc == ZT_SUCCESS && (buffer.next_in - (state.ulBitCount >> 3) + 8 != pEnd || buffer.total_out != pMember->u32OutSize)) {
+        rc = ZT_DECODE_ERROR; // the member doesn't end where we thought it did
+    }
+    return rc;
+} /* zt_gunzip_member() */
+//
+// Unzip a multi-member gzip file (e.g. from pigz or bgzip) using multiple
+// threads. The members found by zt_gzip_members() are handed out to a pool
+// of iThreads threads (0 = one per CPU core) which decode them directly into
+// their slices of the output buffer. If a member boundary turns out to be
+// false (compressed data which looked like a gzip header), everything from
+// that member on is decoded again serially.
+//
+int zt_gunzip_parallel(uint8_t *pCompressed, zt_member *pMembers, int iMemberCount, uint8_t *pUncompressed, int iThreads, int bVerify)
+{
+    std::atomic<int> iNext(0);
+    std::thread *pThreads;
+    zt_member *pLast;
+    zt_state state;
+    int i;
+
+    if (pCompressed == NULL || pMembers == NULL || iMemberCount <= 0 || pUncompressed == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    if (iThreads <= 0) {
+        iThreads = (int)std::thread::hardware_concurrency();
+    }
+    if (iThreads > iMemberCount) iThreads = iMemberCount;
+    auto worker = [&]() {
+        int j;
+        while ((j = iNext++) < iMemberCount) {
+            pMembers[j].iResult = zt_gunzip_member(pCompressed, &pMembers[j], pUncompressed, bVerify);
+        }
+    };
+    pThreads = new std::thread[iThreads > 1 ? iThreads - 1 : 1];
+    for (i=0; i<iThreads-1; i++) {
+        pThreads[i] = std::thread(worker);
+    }
+    worker(); // the calling thread works too
+    for (i=0; i<iThreads-1; i++) {
+        pThreads[i].join();
+    }
+    delete[] pThreads;
+    for (i=0; i<iMemberCount; i++) {
+        if (pMembers[i].iResult != ZT_SUCCESS) break;
+    }
+    if (i == iMemberCount) {
+        return ZT_SUCCESS;
+    }
+    // Decode the rest serially; the members before this one are good
+    pLast = &pMembers[iMemberCount-1];
+    zt_init_temp(&state);
+    return zt_gunzip_serial(&state, &pCompressed[pMembers[i].iInOffset], &pCompressed[pLast->iInOffset + pLast->iInSize],
+                            &pUncompressed[pMembers[i].iOutOffset], &pUncompressed[pLast->iOutOffset + pLast->u32OutSize], bVerify, NULL);
+} /* zt_gunzip_parallel() */
+#endif // ZT_THREADS
+
+//
+// Copy a match the slow way, one byte at a time. This handles the cases
+// the fast copy in zt_inflate() can't; the source reaching back before the
+// start of the output buffer (into the sliding window in streaming mode,
+// the previous segments of a scatter/gather list or a preset dictionary)
+// and matches which were split across two calls.
+// Returns the updated output pointer or NULL if the distance is invalid
+//
+static uint8_t *zt_copy_history(zt_state *state, uint8_t *pOut, uint8_t *pOutStart, unsigned dist, unsigned len)
+{
+    unsigned back, copy, pos, run;
+    uint32_t i;
+    uint8_t *from;
+
+    if (state->pDict && state->pWindow == NULL) { // (the window already has it)
+        back = (unsigned)(pOut - pOutStart); // all of the output so far
+        for (i=0; state->pSegs && i<state->u32Seg; i++) {
+            back += state->pSegs[i].u32Size;
+        }
+        if (dist > back) { // the start of the match is in the dictionary
+            back = dist - back;
+            if (back > state->u32DictSize) {
+                return NULL; // distance too far back
+            }
+            copy = (back < len) ? back : len;
+            memcpy(pOut, &state->pDict[state->u32DictSize - back], copy);
+            pOut += copy;
+            len -= copy;
+            if (len == 0) return pOut;
+            // the rest starts at the beginning of the output
+        }
+    }
+    if (dist <= (unsigned)(pOut - pOutStart)) {
+        back = 0; // all of it is in the output buffer
+    } else if (state->pSegs) { // the earlier output is in the previous segments
+        back = dist - (unsigned)(pOut - pOutStart);
+        pos = back;
+        i = state->u32Seg;
+        do { // find the segment where the match starts
+            if (i == 0) {
+                return NULL; // distance too far back
+            }
+            i--;
+            if (pos <= state->pSegs[i].u32Size) break;
+            pos -= state->pSegs[i].u32Size;
+        } while (1);
+        pos = state->pSegs[i].u32Size - pos;
+        copy = (back < len) ? back : len;
+        len -= copy;
+        while (copy) { // it can span any number of (small) segments
+            run = state->pSegs[i].u32Size - pos;
+            if (run > copy) run = copy;
+            memcpy(pOut, &state->pSegs[i].pData[pos], run);
+            pOut += run;
+            copy -= run;
+            pos = 0;
+            i++;
+        }
+    } else {
+        back = dist - (unsigned)(pOut - pOutStart); // bytes needed from the window
+        if (state->pWindow == NULL || back > state->u32WindowHave) {
+            return NULL; // distance too far back
+        }
+        pos = (state->u32WindowPos - back) & (state->u32WindowSize - 1);
+        copy = (back < len) ? back : len;
+        len -= copy;
+        while (copy) { // the window is circular, so this may take 2 pieces
+            run = state->u32WindowSize - pos;
+            if (run > copy) run = copy;
+            memcpy(pOut, &state->pWindow[pos], run);
+            pOut += run;
+            copy -= run;
+            pos = 0;
+        }
+    }
+    from = pOut - dist; // the rest comes from the output buffer (may overlap)
+    while (len--) {
+        *pOut++ = *from++;
+    }
+    return pOut;
+} /* zt_copy_history() */
+#if COPY_WIDTH > 8
+//
+// Shuffle indices to expand a repeating pattern of 1-15 bytes into a full
+// vector register; row d holds (i % d) for i = 0..31. The first 16 bytes
+// make the low half and the last 16 the high half of a 32-byte register
+//
+static const uint8_t zt_pattern_index[16][32] = {
+    {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+    {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+    {0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1},
+    {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1},
+    {0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3},
+    {0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0,1},
+    {0,1,2,3,4,5,0,1,2,3,4,5,0,1,2,3,4,5,0,1,2,3,4,5,0,1,2,3,4,5,0,1},
+    {0,1,2,3,4,5,6,0,1,2,3,4,5,6,0,1,2,3,4,5,6,0,1,2,3,4,5,6,0,1,2,3},
+    {0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7},
+    {0,1,2,3,4,5,6,7,8,0,1,2,3,4,5,6,7,8,0,1,2,3,4,5,6,7,8,0,1,2,3,4},
+    {0,1,2,3,4,5,6,7,8,9,0,1,2,3,4,5,6,7,8,9,0,1,2,3,4,5,6,7,8,9,0,1},
+    {0,1,2,3,4,5,6,7,8,9,10,0,1,2,3,4,5,6,7,8,9,10,0,1,2,3,4,5,6,7,8,9},
+    {0,1,2,3,4,5,6,7,8,9,10,11,0,1,2,3,4,5,6,7,8,9,10,11,0,1,2,3,4,5,6,7},
+    {0,1,2,3,4,5,6,7,8,9,10,11,12,0,1,2,3,4,5,6,7,8,9,10,11,12,0,1,2,3,4,5},
+    {0,1,2,3,4,5,6,7,8,9,10,11,12,13,0,1,2,3,4,5,6,7,8,9,10,11,12,13,0,1,2,3},
+    {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,0,1}
+};
+#endif
+//
+// Copy a match inside the fast loop with the widest registers available
+// (AVX2, SSE2/SSSE3, AArch64 NEON or the native integer size). There is
+// always room for up to COPY_WIDTH-1 bytes of overshoot past the end of the
+// match. Short repeating patterns (source overlapping the destination) are
+// expanded into a full register once and then just written; that way we're
+// only writing data instead of reading, then writing.
+//
+static inline void zt_copy_fast(uint8_t *pOut, unsigned dist, unsigned len)
+{
+    uint8_t *from = pOut - dist;
+    uint8_t *pEnd = pOut + len;
+#if defined(__AVX2__)
+    if (dist >= 32) { // regular copy, no overlap within a register
+        do {
+            _mm256_storeu_si256((__m256i *)pOut, _mm256_loadu_si256((const __m256i *)from));
+            pOut += 32;
+            from += 32;
+        } while (pOut < pEnd);
+    } else if (dist >= 16) {
+        do {
+            _mm_storeu_si128((__m128i *)pOut, _mm_loadu_si128((const __m128i *)from));
+            pOut += 16;
+            from += 16;
+        } while (pOut < pEnd);
+    } else if (dist >= len) { // short match which doesn't overlap itself
+        _mm_storeu_si128((__m128i *)pOut, _mm_loadu_si128((const __m128i *)from));
+    } else { // repeating pattern of 1-15 bytes
+        __m128i src = _mm_loadu_si128((const __m128i *)from);
+        __m128i lo = _mm_shuffle_epi8(src, _mm_loadu_si128((const __m128i *)&zt_pattern_index[dist][0]));
+        __m128i hi = _mm_shuffle_epi8(src, _mm_loadu_si128((const __m128i *)&zt_pattern_index[dist][16]));
+        __m256i pattern = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        dist = 32 - (32 % dist); // whole repeats per write
+        do {
+            _mm256_storeu_si256((__m256i *)pOut, pattern);
+            pOut += dist;
+        } while (pOut < pEnd);
+    }
+#elif defined(__SSE2__)
+    if (dist >= 16) { // regular copy, no overlap within a register
+        do {
+            _mm_storeu_si128((__m128i *)pOut, _mm_loadu_si128((const __m128i *)from));
+            pOut += 16;
+            from += 16;
+        } while (pOut < pEnd);
+    } else if (dist >= len) { // short match which doesn't overlap itself
+        _mm_storeu_si128((__m128i *)pOut, _mm_loadu_si128((const __m128i *)from));
+    } else { // repeating pattern of 1-15 bytes
+        __m128i pattern;
+#ifdef __SSSE3__
+        pattern = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)from), _mm_loadu_si128((const __m128i *)&zt_pattern_index[dist][0]));
+#else
+        if (dist == 1) {
+            pattern = _mm_set1_epi8((char)*from);
+        } else { // SSE2 has no byte shuffle, so build it in memory
+            uint8_t u8Pattern[16];
+            unsigned i;
+            for (i=0; i<16; i++) {
+                u8Pattern[i] = from[zt_pattern_index[dist][i]];
+            }
+            pattern = _mm_loadu_si128((const __m128i *)u8Pattern);
+        }
+#endif
+        dist = 16 - (16 % dist); // whole repeats per write
+        do {
+            _mm_storeu_si128((__m128i *)pOut, pattern);
+            pOut += dist;
+        } while (pOut < pEnd);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (dist >= 16) { // regular copy, no overlap within a register
+        do {
+            vst1q_u8(pOut, vld1q_u8(from));
+            pOut += 16;
+            from += 16;
+        } while (pOut < pEnd);
+    } else if (dist >= len) { // short match which doesn't overlap itself
+        vst1q_u8(pOut, vld1q_u8(from));
+    } else { // repeating pattern of 1-15 bytes
+        uint8x16_t pattern = vqtbl1q_u8(vld1q_u8(from), vld1q_u8(&zt_pattern_index[dist][0]));
+        dist = 16 - (16 % dist); // whole repeats per write
+        do {
+            vst1q_u8(pOut, pattern);
+            pOut += dist;
+        } while (pOut < pEnd);
+    }
+#else // native registers
+    unsigned i;
+    if (dist < len && dist < sizeof(BIGUINT)) { // repeating pattern
+        BIGUINT pattern;
+        if (dist == 1) { // special case, do it faster
+            pattern = *from;
+            pattern = pattern | (pattern << 8);
+            pattern = pattern | (pattern << 16);
+#if REGISTER_WIDTH == 64
+            pattern = pattern | (pattern << 32);
+#endif
+        } else { // 2-7 byte pattern
+            uint8_t *p = (uint8_t *)&pattern;
+            for (i=0; i<dist; i++) {
+                p[i] = from[i];
+            }
+            for (; i<sizeof(BIGUINT); i++) {
+                p[i] = p[i - dist];
+            }
+        }
+        dist = sizeof(BIGUINT) - (sizeof(BIGUINT) % dist); // whole repeats per write
+        while (pOut < pEnd) {
+            memcpy(pOut, &pattern, sizeof(BIGUINT));
+            pOut += dist;
+        }
+    } else { // regular copy
+        while (pOut < pEnd) {
+            memcpy(pOut, from, sizeof(BIGUINT));
+            pOut += sizeof(BIGUINT);
+            from += sizeof(BIGUINT);
+        }
+    }
+#endif
+} /* zt_copy_fast() */
+//
+// Find the source of a match for the fast loop in scatter/gather mode
+// (back = bytes before the current segment). Only matches which fit in one
+// segment, with room for the overread of a wide copy, are handled here;
+// zt_copy_history() takes care of the ones which straddle two segments.
+//
+static inline uint8_t *zt_segment_source(zt_state *state, unsigned back, unsigned len)
+{
+    zt_segment *pSeg = &state->pSegs[state->u32Seg];
+
+    while (pSeg != state->pSegs) {
+        pSeg--;
+        if (back <= pSeg->u32Size) {
+            return (back >= len + COPY_WIDTH) ? &pSeg->pData[pSeg->u32Size - back] : NULL;
+        }
+        back -= pSeg->u32Size;
+    }
+    return NULL; // too far back
+} /* zt_segment_source() */
+//
+// Copy a match from another buffer (an earlier segment) inside the fast
+// loop; there's room for COPY_WIDTH-1 bytes of overshoot at both ends
+//
+static inline void zt_copy_from(uint8_t *pOut, const uint8_t *from, unsigned len)
+{
+    uint8_t *pEnd = pOut + len;
+
+    do {
+        memcpy(pOut, from, COPY_WIDTH);
+        pOut += COPY_WIDTH;
+        from += COPY_WIDTH;
+    } while (pOut < pEnd);
+} /* zt_copy_from() */
+//
+// Add the newly decoded data to the circular window (streaming mode)
+//
+static void zt_update_window(zt_state *state, uint8_t *pData, unsigned len)
+{
+    unsigned copy, size = state->u32WindowSize;
+
+    if (len >= size) { // only the most recent window-full matters
+        memcpy(state->pWindow, &pData[len - size], size);
+        state->u32WindowPos = 0;
+        state->u32WindowHave = size;
+        return;
+    }
+    copy = size - state->u32WindowPos;
+    if (copy > len) copy = len;
+    memcpy(&state->pWindow[state->u32WindowPos], pData, copy);
+    if (len > copy) { // wrap around to the start
+        memcpy(state->pWindow, &pData[copy], len - copy);
+    }
+    state->u32WindowPos = (state->u32WindowPos + len) & (size - 1);
+    state->u32WindowHave += len;
+    if (state->u32WindowHave > size) state->u32WindowHave = size;
+} /* zt_update_window() */
+//
+// Make a preset dictionary the history before the start of the output.
+// In streaming mode the history is the window, so it goes in there
+//
+static void zt_use_dict(zt_state *state, const uint8_t *pDict, uint32_t u32Size, uint32_t u32Id)
+{
+    state->pDict = pDict;
+    state->u32DictSize = u32Size;
+    state->u32DictId = u32Id;
+    if (state->pWindow) {
+        zt_update_window(state, (uint8_t *)pDict, u32Size);
+    }
+} /* zt_use_dict() */
+//
+// Find the dictionary a zlib header asked for (see zt_init_dicts)
+//
+static int zt_find_dict(zt_state *state, uint32_t u32Id)
+{
+    uint32_t i;
+
+    if (state->pDict && state->u32DictId == u32Id) {
+        return ZT_SUCCESS; // already given with zt_init_dict()
+    }
+    for (i=0; i<state->u32DictCount; i++) {
+        if (state->pDicts[i].u32Id == u32Id) {
+            zt_use_dict(state, state->pDicts[i].pData, state->pDicts[i].u32Size, u32Id);
+            return ZT_SUCCESS;
+        }
+    }
+    state->pDict = NULL;
+    state->u32DictId = u32Id; // tell the caller which one
+    return ZT_NEED_DICT;
+} /* zt_find_dict() */
+
+//
+// Look for the tables of a dynamic header with the same code lengths in the
+// cache. If there aren't any, the entry to build them in is returned with
+// nlen = 0 (it's marked as unused until they're complete). The code lengths
+// are compared directly; different headers almost always differ in the
+// first few, so that's cheaper than hashing all of them.
+//
+static zt_table_entry *zt_cache_find(zt_table_cache *pCache, const uint8_t *pLens, int nlen, int ndist, int bPair)
+{
+    zt_table_entry *pEntry;
+    int i;
+
+    for (i=0; i<ZT_TABLE_CACHE; i++) {
+        pEntry = &pCache->entries[i];
+        if (pEntry->nlen == nlen && pEntry->ndist == ndist && pEntry->bPaired >= bPair && memcmp(pEntry->lens, pLens, nlen + ndist) == 0) {
+            return pEntry;
+        }
+    }
+    pEntry = &pCache->entries[pCache->u32Next];
+    pCache->u32Next = (pCache->u32Next + 1) % ZT_TABLE_CACHE;
+    pEntry->nlen = 0;
+    return pEntry;
+} /* zt_cache_find() */
+//
+// Read the code lengths of a dynamic block and build its decoding tables.
+// This is shared by zt_inflate() and the block boundary search of
+// zt_inflate_parallel(), so the bit accumulator is passed in and out.
+// bPair enables literal pairing (see zt_pack_literals); it isn't worth its
+// cost for a block which won't produce much output.
+// Returns ZT_SUCCESS or ZT_DECODE_ERROR for an invalid set of codes
+//
+static int zt_dynamic_tables(zt_state *state, BIGUINT *pulBits, BIGUINT *pulBitCount, uint8_t **ppBuf, uint8_t *pInEnd, int bPair)
+{
+    BIGUINT ulBits = *pulBits, ulBitCount = *pulBitCount;
+    uint8_t *pBuf = *ppBuf;
+    int i, ret, nlen, ndist, ncode;
+    unsigned int len, copy;
+    code here, *pCodes;
+    zt_table_entry *pEntry;
+
+    nlen = BITS(5);
+    nlen += 257;
+    state->nlen = nlen;
+    DROPBITS(5);
+    ndist = BITS(5);
+    ndist += 1;
+    state->ndist = ndist;
+    DROPBITS(5);
+    if (ulBitCount < REGISTER_WIDTH/2) { // needed for 32-bit
+        GETMOREBITS_SAFE;
+    }
+    if (nlen > 286 || ndist > 30) { // too many length or distance symbols
+        ret = ZT_DECODE_ERROR;
+        goto dynamic_exit;
+    }
+    ncode = BITS(4);
+    ncode += 4;
+    state->ncode = ncode;
+    DROPBITS(4);
+    // get the lengths of the lengths
+    for (i=0; i<ncode; i++) {
+        uint16_t codelen;
+        if (ulBitCount < REGISTER_WIDTH/2) { // get more bits
+            GETMOREBITS_SAFE;
+        }
+        codelen = BITS(3);
+        state->lens[len_order[i]] = codelen;
+        DROPBITS(3); // 3 bits per length
+    }
+    while (i < 19) {
+        state->lens[len_order[i++]] = 0;
+    }
+    state->have = 19;
+    state->next = state->codes;
+    state->lencode = (const code *)(state->next);
+    state->lenbits = 7;
+    ret = zt_table(CODES,
+                        state->lens,
+                        19,
+                        &(state->next),
+                        &(state->lenbits),
+                        state->work);
+    if (ret) {
+        //   strm->msg = (char *)"invalid code lengths set";
+        ret = ZT_DECODE_ERROR;
+        goto dynamic_exit;
+    }
+    state->have = 0;
+    
+    //state->mode = CODELENS;
+    while (state->have < state->nlen + state->ndist) {
+        if (ulBitCount < REGISTER_WIDTH/2) { // get more bits
+            GETMOREBITS_SAFE;
+        }
+        here = state->lencode[BITS(state->lenbits)];
+        if (here.val < 16) {
+            DROPBITS(here.bits);
+            state->lens[state->have++] = here.val;
+        }
+        else {
+            if (here.val == 16) {
+                if (ulBitCount < REGISTER_WIDTH/2) GETMOREBITS_SAFE
+                    //NEEDBITS(here.bits + 2);
+                    DROPBITS(here.bits);
+                if (state->have == 0) {
+                    ret = ZT_DECODE_ERROR;
+                    goto dynamic_exit;
+                }
+                len = state->lens[state->have - 1];
+                copy = 3 + BITS(2);
+                DROPBITS(2);
+            }
+            else if (here.val == 17) {
+                if (ulBitCount < REGISTER_WIDTH/2) GETMOREBITS_SAFE
+                    //NEEDBITS(here.bits + 3);
+                    DROPBITS(here.bits);
+                len = 0;
+                copy = 3 + BITS(3);
+                DROPBITS(3);
+            }
+            else {
+                if (ulBitCount < REGISTER_WIDTH/2) GETMOREBITS_SAFE
+                    //NEEDBITS(here.bits + 7);
+                    DROPBITS(here.bits);
+                len = 0;
+                copy = 11 + BITS(7);
+                DROPBITS(7);
+            }
+            if (state->have + copy > state->nlen + state->ndist) {
+                //strm->msg = (char *)"invalid bit length repeat";
+                ret = ZT_DECODE_ERROR;
+                goto dynamic_exit;
+            }
+            while (copy--)
+                state->lens[state->have++] = (uint16_t)len;
+        }
+    }
+    
+    /* check for end-of-block code (better have one) */
+    if (state->lens[256] == 0) {
+        // strm->msg = (char *)"invalid code -- missing end-of-block";
+        ret = ZT_DECODE_ERROR;
+        goto dynamic_exit;
+    }
+    pCodes = state->codes;
+    pEntry = NULL;
+    if (state->pCache) { // use the tables of an identical header or build them in the oldest entry
+        pEntry = zt_cache_find(state->pCache, state->lens, nlen, ndist, bPair);
+        if (pEntry->nlen) {
+            ZT_COUNT(u64TableHits, 1)
+            state->lencode = pEntry->codes;
+            state->lenbits = pEntry->lenbits;
+            state->distcode = &pEntry->codes[pEntry->distoffset];
+            state->distbits = pEntry->distbits;
+            ret = ZT_SUCCESS;
+            goto dynamic_exit;
+        }
+        pCodes = pEntry->codes;
+    }
+    
+    /* build code tables -- the ENOUGH constants depend on the lenbits and
+     distbits values here (see ZT_LENBITS in zlib_turbo.h) */
+    state->next = pCodes;
+    state->lencode = (const code *)(state->next);
+    state->lenbits = ZT_LENBITS;
+    ret = zt_table(LENS, state->lens, state->nlen, &(state->next),
+                        &(state->lenbits), state->work);
+    if (ret) {
+        // strm->msg = (char *)"invalid literal/lengths set";
+        ret = ZT_DECODE_ERROR;
+        goto dynamic_exit;
+    }
+#ifdef PAIR_LITERALS
+    if (bPair) {
+        zt_pack_literals(pCodes, state->lenbits);
+    }
+#endif
+    state->distcode = (const code *)(state->next);
+    state->distbits = ZT_DISTBITS;
+    ret = zt_table(DISTS, state->lens + state->nlen, state->ndist,
+                        &(state->next), &(state->distbits), state->work);
+    if (ret) {
+        // strm->msg = (char *)"invalid distances set";
+        ret = ZT_DECODE_ERROR;
+        goto dynamic_exit;
+    }
+    if (pEntry) { // the entry is only valid once both tables are built
+        pEntry->nlen = (uint16_t)nlen;
+        pEntry->ndist = (uint16_t)ndist;
+        pEntry->lenbits = state->lenbits;
+        pEntry->distbits = state->distbits;
+        pEntry->distoffset = (uint16_t)(state->distcode - pCodes);
+        pEntry->bPaired = (uint8_t)bPair;
+        memcpy(pEntry->lens, state->lens, nlen + ndist);
+    }
+    ZT_COUNT(u64TablesBuilt, 1)
+    ret = ZT_SUCCESS;
+dynamic_exit:
+    if (pBuf > pInEnd && (BIGUINT)(pBuf - pInEnd) * 8 > ulBitCount) {
+        ret = ZT_INPUT_INSUFFICIENT; // it read the zero padding past the end of the input
+    }
+    *pulBits = ulBits;
+    *pulBitCount = ulBitCount;
+    *ppBuf = pBuf;
+    return ret;
+} /* zt_dynamic_tables() */
+#ifdef ZT_STATS
+// Short repeating patterns which zt_copy_fast() expands in a register
+#define ZT_PATTERN_MAX ((COPY_WIDTH > 8) ? 16 : COPY_WIDTH)
+//
+// Add a match to the statistics and its length and distance histograms
+//
+static void zt_count_match(zt_stats *pStats, unsigned len, unsigned dist)
+{
+    int i;
+
+    pStats->u64Matches++;
+    pStats->u64MatchBytes += len;
+    for (i = 0; len > 1; i++) len >>= 1;
+    pStats->u64LenHist[i]++;
+    for (i = 0; dist > 1; i++) dist >>= 1;
+    pStats->u64DistHist[i & 15]++;
+} /* zt_count_match() */
+#define ZT_COUNT_MATCH(len, dist) zt_count_match(&state->stats, len, dist);
+#else
+#define ZT_COUNT_MATCH(len, dist)
+#endif
+//
+// Detect the format of the stream (ZT_FORMAT_AUTO) and skip a gzip header
+// at the start of the input (see zt_init_format). A zlib header is left for
+// zt_inflate_body to parse. Unless it's the end of the data, it waits
+// until it has the whole gzip header or enough to tell the formats apart.
+//
+static int zt_stream_header(zt_state *state, uint8_t **ppBuf, uint8_t *pInEnd, int bEnd)
+{
+    uint8_t *pBuf = *ppBuf;
+    size_t iLen, iSize = (size_t)(pInEnd - pBuf);
+    int rc, iFormat;
+
+    if (iSize < 5 && !bEnd) { // enough to check a raw stored block header
+        return ZT_INPUT_INSUFFICIENT;
+    }
+    iFormat = zt_detect_format(pBuf, iSize);
+    if (iFormat < 0 || (state->u8Format == ZT_FORMAT_GZIP && iFormat != ZT_FORMAT_GZIP)) {
+        return (iSize < 2) ? ZT_INPUT_INSUFFICIENT : ZT_HEADER_ERROR;
+    }
+    state->u8Format = (uint8_t)iFormat;
+    if (iFormat == ZT_FORMAT_GZIP) {
+        rc = zt_gzip_header_len(pBuf, iSize, &iLen);
+        if (rc != ZT_SUCCESS) {
+            state->u8Format = ZT_FORMAT_AUTO; // try again with more data
+            return rc;
+        }
+        if (state->pWindow && state->u32WindowSize < ZT_MAX_WINDOW) {
+            return ZT_HEADER_ERROR; // gzip doesn't say, so it could need all 32K
+        }
+        *ppBuf = &pBuf[iLen];
+        state->wbits = 15;
+        if (state->u8CheckType != ZT_CHECK_NONE) {
+            zt_init_check(state, ZT_CHECK_CRC32);
+        }
+    } else if (iFormat == ZT_FORMAT_RAW) {
+        state->wbits = 15;
+        state->u8CheckType = ZT_CHECK_NONE; // nothing to check it against
+    } else if (state->u8CheckType != ZT_CHECK_NONE) { // zlib
+        zt_init_check(state, ZT_CHECK_ADLER32);
+    }
+    return ZT_SUCCESS;
+} /* zt_stream_header() */
+//
+// The fast loop of the decoder; it runs while there's enough input for the
+// longest symbol and enough output space for the longest match (+ wide write
+// overshoot), so there are no bounds checks per symbol. It's inlined into
+// zt_inflate_body() twice, once for dynamic blocks and once with a constant
+// bFixed for fixed Huffman blocks (the usual kind for short messages), where
+// the tables, masks and root bits are constants, there are no 2nd level
+// codes or literal pairs, and the compiler can leave out those paths.
+// Returns 1 at the end of the block, 0 when it gets too close to the end of
+// either buffer or -1 for an error (state->iLastError)
+//
+static ZT_ALWAYS_INLINE int zt_decode_fast(zt_state *state, const int bFixed, code const *lcode, code const *dcode, BIGUINT lmask, BIGUINT dmask,
+                                           BIGUINT &ulBits, BIGUINT &ulBitCount, uint8_t *&pBuf, uint8_t *&pOut, uint8_t *&pChecked, uint8_t *&pCheckNext,
+                                           uint8_t *pEndOfInput, uint8_t *pFastOutEnd, uint8_t *pEndOfOutput, uint8_t *pOutStart)
+{
+    unsigned int op, dist, len;
+    uint8_t *from;
+    code here;
+
+    if (bFixed) { // the fixed code tables are 9/5 bits with no links
+        lcode = lenfix;
+        lmask = 511;
+        dcode = distfix;
+        dmask = 31;
+    }
+    while (pBuf < pEndOfInput && pOut < pFastOutEnd) {
+        GETMOREBITS_FAST
+        ZT_COUNT(u64Refills, 1)
+        here = lcode[ulBits & lmask];
+    fast_length:
+        op = (unsigned)(here.op);
+        if ((op & 0x7f) == 0) {                 /* 1 or 2 literals */
+            DROPBITS(here.bits);
+            // a 16-bit write covers both cases (see zt_pack_literals)
+            memcpy(pOut, &here.val, 2);
+            if (bFixed) op = 0; // the fixed table isn't paired
+            pOut += 1 + (op >> 7);
+            ZT_COUNT(u64Literals, 1 + (op >> 7))
+#if REGISTER_WIDTH == 64
+            // a refill leaves enough bits for 2 more literal entries, so decode
+            // them without going around the loop
+            here = lcode[ulBits & lmask];
+            if ((here.op & 0x7f) == 0) {
+                DROPBITS(here.bits);
+                memcpy(pOut, &here.val, 2);
+                pOut += (bFixed) ? 1 : 1 + (here.op >> 7);
+                ZT_COUNT(u64Literals, 1 + (here.op >> 7))
+                here = lcode[ulBits & lmask];
+                if ((here.op & 0x7f) == 0) {
+                    DROPBITS(here.bits);
+                    memcpy(pOut, &here.val, 2);
+                    pOut += (bFixed) ? 1 : 1 + (here.op >> 7);
+                    ZT_COUNT(u64Literals, 1 + (here.op >> 7))
+                }
+            }
+#endif
+        }
+        else if (op & 16) {                     /* length base */
+            op &= 15;                           /* number of extra bits */
+#if REGISTER_WIDTH == 64
+            // the extra bits follow the code; drop both with one shift
+            len = (unsigned)here.val + (unsigned)((ulBits >> here.bits) & ~(~(uint64_t)0 << op));
+            op += here.bits;
+            DROPBITS(op);
+#else
+            DROPBITS(here.bits);
+            len = (unsigned)(here.val);
+            GETMOREBITS_FAST
+            len += (unsigned)BITS(op);
+            DROPBITS(op);
+            GETMOREBITS_FAST
+#endif
+            here = dcode[ulBits & dmask];
+        fast_distance:
+            op = (unsigned)(here.op);
+            if (op & 16) {                      /* distance base */
+                op &= 15;                       /* number of extra bits */
+#if REGISTER_WIDTH == 64
+                dist = (unsigned)here.val + (unsigned)((ulBits >> here.bits) & ~(~(uint64_t)0 << op));
+                op += here.bits;
+                DROPBITS(op);
+#else
+                DROPBITS(here.bits);
+                dist = (unsigned)(here.val);
+                GETMOREBITS_FAST
+                dist += BITS(op);
+                DROPBITS(op);
+#endif
+                ZT_COUNT_MATCH(len, dist)
+                if (dist > (unsigned)(pOut - pOutStart)) { // reaches back before the output buffer
+                    if (state->pSegs && (from = zt_segment_source(state, dist - (unsigned)(pOut - pOutStart), len)) != NULL) {
+                        zt_copy_from(pOut, from, len); // usually it's all in the previous segment
+                        pOut += len;
+                        ZT_COUNT(u64Copies[ZT_COPY_WIDE], 1)
+                        continue;
+                    }
+                    from = zt_copy_history(state, pOut, pOutStart, dist, len);
+                    if (from == NULL) {
+                        state->iLastError = ZT_DECODE_ERROR;
+                        return -1;
+                    }
+                    pOut = from;
+                    ZT_COUNT(u64Copies[ZT_COPY_HISTORY], 1)
+                    continue;
+                }
+                ZT_COUNT(u64Copies[(dist < len && dist < ZT_PATTERN_MAX) ? ZT_COPY_PATTERN : ZT_COPY_WIDE], 1)
+                zt_copy_fast(pOut, dist, len);
+                pOut += len;
+                if (pOut >= pCheckNext) { // checksum the output while it's still in the cache
+                    zt_update_check(state, pChecked, (unsigned)(pOut - pChecked));
+                    pChecked = pOut;
+                    pCheckNext = ((unsigned)(pEndOfOutput - pOut) > CHECK_CHUNK) ? pOut + CHECK_CHUNK : pEndOfOutput;
+                }
+            }
+            else if (!bFixed && (op & 64) == 0) { /* 2nd level distance code */
+                DROPBITS(here.bits);
+#if REGISTER_WIDTH == 32
+                GETMOREBITS_FAST
+#endif
+                here = dcode[here.val + BITS(op)];
+                ZT_COUNT(u64DistLinks, 1)
+                goto fast_distance;
+            }
+            else {
+                //strm->msg = (char *)"invalid distance code";
+                state->iLastError = ZT_DECODE_ERROR;
+                return -1;
+            }
+        }
+        else if (!bFixed && (op & 64) == 0) { /* 2nd level length code */
+            DROPBITS(here.bits);
+#if REGISTER_WIDTH == 32
+            GETMOREBITS_FAST
+#endif
+            here = lcode[here.val + BITS(op)];
+            ZT_COUNT(u64LenLinks, 1)
+            goto fast_length;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            DROPBITS(here.bits);
+            state->lenbits = 0; // mark that we completed the current block
+            return 1;
+        }
+        else {
+            //strm->msg = (char *)"invalid literal/length code";
+            state->iLastError = ZT_DECODE_ERROR;
+            return -1;
+        }
+    } // fast loop
+    return 0;
+} /* zt_decode_fast() */
+//
+// Inflate the given deflated data into the output buffer
+// This can be called repeatedly with small chunks of data,
+// ** BUT ** the output buffer must be allocated large enough
+// to hold all of the decompressed data in one shot. This is so
+// that a separate memory window does not need to exist. This
+// behavior diverges from the original zlib, but allows for a
+// simpler implementation that's also faster.
+// In streaming mode (see zt_init_window), the output buffer only
+// needs to hold the current chunk and it can be reused (drained)
+// between calls.
+// Input which can't be used yet is left in the buffer to be passed again
+// with the next data, unless incremental input is enabled (zt_init_carry).
+//
+// returns:
+//
+// - ZT_SUCCESS (the current set of compressed blocks is fully decoded)
+// - ZT_ERROR... (an error occurred)
+// - ZT_INPUT_INSUFFICIENT (the decoding isn't complete; it needs more data)
+// - ZT_OUTPUT_INSUFFICIENT (the output buffer is full; drain it and call again)
+//
+ZT_DECODER_BODY int zt_inflate_body(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    int ret;
+    BIGUINT ulBitCount, ulBits, lmask, dmask;
+    uint8_t *pBuf;
+    uint8_t *pEndOfInput, *pEndOfOutput, *pInEnd, *pFastOutEnd;
+    uint8_t *pOut, *pOutStart;
+    uint8_t *pChecked, *pCheckNext; // checksum progress
+    BIGINT iMinBits, iStartBits;
+    uint32_t u32;
+    int i;
+    int bLastBlock;
+    uint8_t u8, *from;
+    unsigned int op, dist, copy, len;
+    code here;
+    code const *lcode;
+    code const *dcode;
+#ifdef ZT_STATS
+    uint64_t u64Ticks;
+#endif
+    
+    state->iLastError = ZT_SUCCESS; // start by assuming success
+    pOut = buffer->next_out;
+    pChecked = pOut;
+    pBuf = buffer->next_in;
+    // In streaming mode, the output buffer only holds the current chunk and
+    // older data lives in the window; with a segment list, it's the current
+    // segment and older data is in the ones before it. Otherwise the complete
+    // output is present and back-references can reach all the way back to the
+    // start of it
+    if (state->pWindow) {
+        pOutStart = pOut;
+    } else if (state->pSegs) {
+        pOutStart = state->pSegs[state->u32Seg].pData; // (u32SegPos is behind when zt_inflate() calls us twice)
+    } else {
+        pOutStart = pOut - buffer->total_out;
+    }
+    pEndOfOutput = pOut + buffer->avail_out;
+    pInEnd = &pBuf[buffer->avail_in];
+    // The fast loop runs while there's enough room at both ends that no symbol
+    // can reach the end of a buffer; the careful loop finishes the rest exactly
+    pEndOfInput = (buffer->avail_in > FAST_INPUT_MARGIN) ? pInEnd - FAST_INPUT_MARGIN : pBuf;
+    pFastOutEnd = (buffer->avail_out > FAST_OUTPUT_MARGIN) ? pEndOfOutput - FAST_OUTPUT_MARGIN : pOut;
+    // Unless this is the final call, don't start a symbol unless all of its bits
+    // are here. Otherwise the end of the data is zero padded (see GETMOREBITS_SAFE)
+    iMinBits = (bEnd) ? 0 : MAX_SYMBOL_BITS-1;
+    bLastBlock = state->bLastBlock;
+    // Get some data to start
+    ulBitCount = state->ulBitCount;
+    ulBits = state->ulBits;
+    if (state->wbits == 0 && state->u8Format >= ZT_FORMAT_GZIP) { // nothing has been read yet
+        state->iLastError = (uint8_t)zt_stream_header(state, &pBuf, pInEnd, bEnd);
+        if (state->iLastError != ZT_SUCCESS) goto inflate_exit;
+    }
+    if (ulBitCount < REGISTER_WIDTH/2) {
+        GETMOREBITS_SAFE
+    }
+    if (ulBitCount < REGISTER_WIDTH/2) { // we must be starting from 0
+        GETMOREBITS_SAFE
+    }
+    if (state->wbits == 0) { // header hasn't been parsed yet
+        if (((BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount) < 16) {
+            goto need_more_data;
+        }
+        // assume zlib header
         u8 = ulBits & 0xf; // first 4 bits are the compression type
         if (u8 != 8) // DEFLATE = 8
-            return -1; // we can only handle DEFLATE streams
-        state->wbits = u8 = ((ulBits >> 4) & 0xf) + 8; // log2 of window size minus 8
-        //iWindowSize = 1 << u8;
+            return ZT_HEADER_ERROR; // we can only handle DEFLATE streams
+        u8 = ((ulBits >> 4) & 0xf) + 8; // log2 of window size minus 8
+        if (state->pWindow && (1U << u8) > state->u32WindowSize) {
+            return ZT_HEADER_ERROR; // the stream needs a larger window than we were given
+        }
+        if ((ulBits & 0x2000) && ((BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount) < 48) {
+            goto need_more_data; // wait for the DICTID too
+        }
+        state->wbits = u8;
         u8 = (ulBits >> 8) & 0xff; // flags
         ulBitCount -= 16;
         ulBits >>= 16;
-        if (u8 & 0x20) { // fixed dictionary present
-            u8 = (uint8_t)ulBits; // 8-bit checksum
-            ulBitCount -= 8;
-            ulBits >>= 8;
+        if (u8 & 0x20) { // preset dictionary; its Adler-32 (DICTID) follows
+            u32 = 0;
+            for (i=0; i<4; i++) { // stored big-endian
+                if (ulBitCount < 8) GETMOREBITS_SAFE
+                u32 = (u32 << 8) | (uint32_t)BITS(8);
+                DROPBITS(8);
+            }
+            if (zt_find_dict(state, u32) != ZT_SUCCESS) {
+                state->iLastError = ZT_NEED_DICT; // supply it with zt_init_dict() and call again
+                goto inflate_exit;
+            }
+        }
+    }
+    // The fast loop keeps the checksum up to date every CHECK_CHUNK bytes;
+    // the rest is done when we exit
+    pCheckNext = (state->u8CheckType && buffer->avail_out > CHECK_CHUNK) ? pOut + CHECK_CHUNK : pEndOfOutput;
+    if (state->u32CopyLen) { // finish a match which didn't fit last time
+        len = state->u32CopyLen;
+        copy = (unsigned)(pEndOfOutput - pOut);
+        if (len > copy) len = copy;
+        from = zt_copy_history(state, pOut, pOutStart, state->u32CopyDist, len);
+        if (from == NULL) {
+            state->iLastError = ZT_DECODE_ERROR;
+            goto inflate_exit;
+        }
+        pOut = from;
+        ZT_COUNT(u64Copies[ZT_COPY_HISTORY], 1)
+        state->u32CopyLen -= len;
+        if (state->u32CopyLen) goto output_full;
+    }
+    iStartBits = (BIGINT)(pBuf - buffer->next_in) * 8 - (BIGINT)ulBitCount; // where this call started
+next_block:
+    for (;;) {
+        if (state->u32StoredLen) { // in the middle of a stored block
+            if (pBuf > pInEnd) { // don't copy the zero padding from GETMOREBITS_SAFE
+                op = (unsigned)(pBuf - pInEnd) * 8;
+                if (op > ulBitCount) op = (unsigned)ulBitCount;
+                ulBitCount -= op;
+                pBuf = pInEnd;
+            }
+            // the bytes already in the bit accumulator come first
+            while (ulBitCount >= 8 && state->u32StoredLen && pOut < pEndOfOutput) {
+                *pOut++ = (uint8_t)ulBits;
+                DROPBITS(8);
+                state->u32StoredLen--;
+            }
+            if (ulBitCount == 0) { // then copy the rest straight from the input
+                ulBits = 0;
+                copy = state->u32StoredLen;
+                if (pBuf >= pInEnd) copy = 0;
+                else if (copy > (unsigned)(pInEnd - pBuf)) copy = (unsigned)(pInEnd - pBuf);
+                if (copy > (unsigned)(pEndOfOutput - pOut)) copy = (unsigned)(pEndOfOutput - pOut);
+                memcpy(pOut, pBuf, copy);
+                pOut += copy;
+                pBuf += copy;
+                state->u32StoredLen -= copy;
+            }
+            if (state->u32StoredLen) {
+                if (pOut >= pEndOfOutput) goto output_full;
+                goto need_more_data;
+            }
+        }
+        if (state->lenbits == 0) { // need to parse the block header
+            if (bLastBlock) { // the last block is complete, we're done
+                if (state->u8CheckType == ZT_CHECK_ADLER32) { // verify the zlib trailer
+                    zt_update_check(state, pChecked, (unsigned)(pOut - pChecked));
+                    pChecked = pOut;
+                    op = (unsigned)(ulBitCount & 7);
+                    DROPBITS(op); // it starts on a byte boundary
+                    if (((BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount) < 32) {
+                        goto need_more_data;
+                    }
+                    u32 = 0;
+                    for (i=0; i<4; i++) { // stored big-endian
+                        if (ulBitCount < 8) GETMOREBITS_SAFE
+                        u32 = (u32 << 8) | (uint32_t)BITS(8);
+                        DROPBITS(8);
+                    }
+                    if (u32 != state->u32Check) {
+                        state->iLastError = ZT_CHECKSUM_ERROR;
+                        goto inflate_exit;
+                    }
+                    state->u8CheckType = ZT_CHECK_NONE; // verified; don't read it again
+                } else if (state->u8Format == ZT_FORMAT_GZIP && !state->bTrailer) {
+                    // read the gzip trailer (CRC-32 and size mod 2^32, little-endian)
+                    // even if it isn't checked, so a member which follows starts after it
+                    if (state->u8CheckType == ZT_CHECK_CRC32) {
+                        zt_update_check(state, pChecked, (unsigned)(pOut - pChecked));
+                        pChecked = pOut;
+                    }
+                    op = (unsigned)(ulBitCount & 7);
+                    DROPBITS(op);
+                    if (((BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount) < 64) {
+                        goto need_more_data;
+                    }
+                    u32 = 0;
+                    for (i=0; i<8; i++) {
+                        if (ulBitCount < 8) GETMOREBITS_SAFE
+                        u32 = (u32 >> 8) | ((uint32_t)BITS(8) << 24);
+                        DROPBITS(8);
+                        if (i == 3 && u32 != state->u32Check && state->u8CheckType == ZT_CHECK_CRC32) break;
+                    }
+                    if (state->u8CheckType == ZT_CHECK_CRC32 && (i < 8 || u32 != (uint32_t)(buffer->total_out + (pOut - buffer->next_out) - state->u32MemberOut))) {
+                        state->iLastError = ZT_CHECKSUM_ERROR;
+                        goto inflate_exit;
+                    }
+                    state->bTrailer = 1; // (the check stays on for the next member)
+                }
+                goto inflate_exit;
+            }
+            if (state->bBlockStop && (BIGINT)(pBuf - buffer->next_in) * 8 - (BIGINT)ulBitCount != iStartBits) {
+                // let the caller see the block boundary (unless we started at it)
+                state->iLastError = ZT_BLOCK_END;
+                goto inflate_exit;
+            }
+            if (!INPUT_LEFT || (!bEnd && (pInEnd - pBuf) < 96)) {
+                goto need_more_data; // don't risk running out of data while decoding the block header
+            }
+            if (!bEnd && (BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount < (BIGINT)state->u16NeedIn * 8) {
+                goto need_more_data; // a long dynamic header didn't fit last time
+            }
+            if (ulBitCount < REGISTER_WIDTH/2) { // get more bits
+                GETMOREBITS_SAFE;
+            }
+            bLastBlock = BITS(1);
+            DROPBITS(1);
+            u8 = BITS(2);
+            DROPBITS(2);
+            switch (u8) {
+                case 0: // stored
+                    ZT_COUNT(u64Blocks[0], 1)
+                    op = (unsigned)(ulBitCount & 7);
+                    DROPBITS(op); // skip to the next byte boundary
+                    if (ulBitCount < 16) GETMOREBITS_SAFE
+                    u32 = BITS(16); // LEN
+                    DROPBITS(16);
+                    if (ulBitCount < 16) GETMOREBITS_SAFE
+                    if (u32 != (BITS(16) ^ 0xffff)) { // NLEN must be the complement
+                        // bad length
+                        state->iLastError = ZT_DECODE_ERROR;
+                        goto inflate_exit;
+                    }
+                    DROPBITS(16);
+                    ZT_COUNT(u64StoredBytes, u32)
+                    state->u32StoredLen = u32;
+                    continue; // copy it
+                case 1: // static Huffman table
+                    ZT_COUNT(u64Blocks[1], 1)
+                    state->lencode = lenfix;
+                    state->lenbits = 9;
+                    state->distcode = distfix;
+                    state->distbits = 5;
+                    break;
+                case 2: // dynamic Huffman table
+                    ZT_COUNT(u64Blocks[2], 1)
+                    {
+                        BIGUINT ulTmpBits = ulBits, ulTmpCount = ulBitCount; // keep the real ones in registers
+                        uint8_t *pTmp = pBuf;
+#ifdef ZT_STATS
+                        u64Ticks = ZT_TICKS();
+#endif
+                        ret = zt_dynamic_tables(state, &ulTmpBits, &ulTmpCount, &pTmp, pInEnd,
+                                                (state->pWindow != NULL || state->pSegs != NULL || pEndOfOutput - pOut >= ZT_PAIR_MIN_OUTPUT));
+                        ZT_COUNT(u64TableTicks, ZT_TICKS() - u64Ticks)
+                        if (ret != ZT_INPUT_INSUFFICIENT) { // otherwise it's read again from the start
+                            ulBits = ulTmpBits;
+                            ulBitCount = ulTmpCount;
+                            pBuf = pTmp;
+                        }
+                    }
+                    if (ret == ZT_INPUT_INSUFFICIENT) {
+                        // the header isn't all here; put back its first 3 bits
+                        // and try again when there's more than this
+                        state->u16NeedIn = (uint16_t)(((BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount + 3) / 8 + 1);
+                        ulBits = (ulBits << 3) | (2 << 1) | (BIGUINT)bLastBlock;
+                        ulBitCount += 3;
+                        bLastBlock = 0;
+                        state->lenbits = 0;
+                        goto need_more_data;
+                    }
+                    if (ret != ZT_SUCCESS) {
+                        state->iLastError = ZT_DECODE_ERROR;
+                        goto inflate_exit;
+                    }
+                    state->u16NeedIn = 0;
+                    break;
+                case 3: // reserved
+                    state->iLastError = ZT_DECODE_ERROR;
+                    goto inflate_exit;
+            } // switch on block type
+        } // need to parse block header
+        // Decode the block
+        lmask = (1U << state->lenbits) - 1;
+        dmask = (1U << state->distbits) - 1;
+        lcode = state->lencode;
+        dcode = state->distcode;
+        if (lcode == lenfix) {
+            ret = zt_decode_fast(state, 1, lcode, dcode, lmask, dmask, ulBits, ulBitCount, pBuf, pOut, pChecked, pCheckNext, pEndOfInput, pFastOutEnd, pEndOfOutput, pOutStart);
+        } else {
+            ret = zt_decode_fast(state, 0, lcode, dcode, lmask, dmask, ulBits, ulBitCount, pBuf, pOut, pChecked, pCheckNext, pEndOfInput, pFastOutEnd, pEndOfOutput, pOutStart);
+        }
+        if (ret < 0) goto inflate_exit;
+        if (ret > 0) goto next_block;
+        // Careful loop - exact at the end of the input and output
+        while (INPUT_LEFT) {
+            if (ulBitCount < REGISTER_WIDTH/2) {
+                GETMOREBITS_SAFE
+                ZT_COUNT(u64Refills, 1)
+            }
+            if (pOut >= pEndOfOutput) { // no room left; see if the block ends here
+                here = lcode[ulBits & lmask];
+                op = here.bits;
+                if (here.op != 0 && (here.op & 0xf0) == 0) { // 2nd level code
+                    here = lcode[here.val + ((ulBits >> op) & ((1U << here.op) - 1))];
+                    op += here.bits;
+                }
+                if ((here.op & 32) && op <= ulBitCount) { // end-of-block
+                    DROPBITS(op);
+                    state->lenbits = 0;
+                    goto next_block;
+                }
+                goto output_full;
+            }
+            here = lcode[ulBits & lmask];
+        get_length:
+            op = (unsigned)(here.op);
+            if (op == 0x80 && (pEndOfOutput - pOut) < 2) { // literal pair, but only room for the first one
+                op = 0;
+                here.bits = state->lens[here.val & 0xff];
+            }
+            DROPBITS(here.bits);
+            if (op == 0) {                          /* literal */
+                *pOut++ = (unsigned char)(here.val);
+                ZT_COUNT(u64Literals, 1)
+            }
+            else if (op == 0x80) {                  /* 2 literals */
+                *pOut++ = (unsigned char)(here.val);
+                *pOut++ = (unsigned char)(here.val >> 8);
+                ZT_COUNT(u64Literals, 2)
+            }
+            else if (op & 16) {                     /* length base */
+                len = (unsigned)(here.val);
+                op &= 15;                           /* number of extra bits */
+#if REGISTER_WIDTH == 32 // this check isn't needed on 64-bit machines
+                if (ulBitCount < REGISTER_WIDTH/2) {
+                    GETMOREBITS_SAFE
+                }
+#endif
+                len += (unsigned)BITS(op);
+                DROPBITS(op);
+                if (ulBitCount < REGISTER_WIDTH/2) {
+                    GETMOREBITS_SAFE
+                }
+                here = dcode[ulBits & dmask];
+            get_distance:
+                DROPBITS(here.bits);
+                op = (unsigned)(here.op);
+                if (op & 16) {                      /* distance base */
+                    dist = (unsigned)(here.val);
+                    op &= 15;                       /* number of extra bits */
+#if REGISTER_WIDTH == 32 // this check isn't needed on 64-bit machines
+                    if (ulBitCount < REGISTER_WIDTH/2) {
+                        GETMOREBITS_SAFE
+                    }
+#endif
+                    dist += BITS(op);
+                    DROPBITS(op);
+                    ZT_COUNT_MATCH(len, dist)
+                    copy = (unsigned)(pEndOfOutput - pOut);
+                    if (len > copy) { // it doesn't fit; finish it on the next call
+                        state->u32CopyLen = len - copy;
+                        state->u32CopyDist = dist;
+                        len = copy;
+                    }
+                    if (dist > (unsigned)(pOut - pOutStart)) { // reaches back before the output buffer
+                        from = zt_copy_history(state, pOut, pOutStart, dist, len);
+                        if (from == NULL) {
+                            //strm->msg = (char *)"invalid distance too far back";
+                            state->iLastError = ZT_DECODE_ERROR;
+                            goto inflate_exit;
+                        }
+                        pOut = from;
+                        ZT_COUNT(u64Copies[ZT_COPY_HISTORY], 1)
+                    } else {
+                        uint8_t *pEnd = pOut+len;
+                        from = pOut - dist;
+                        if ((unsigned)(pEndOfOutput - pEnd) < sizeof(BIGUINT)) {
+                            // too close to the end of the buffer for the wide writes below
+                            ZT_COUNT(u64Copies[ZT_COPY_BYTES], 1)
+                            while (pOut < pEnd) {
+                                *pOut++ = *from++;
+                            }
+                        } else if (dist < len && dist < sizeof(BIGUINT)) { // repeating pattern
+                            // Check for a repeating pattern (source overlapping destination). This optimization can speed up
+                            // decompression because we're only writing data instead of reading, then writing.
+                            // For 1-byte patterns we create a register-sized set of bytes to blast them out faster
+                            // for 2-7 byte patterns, we fill a register with the repeated pattern and write it
+                            // while advancing the destination pointer by a whole number of pattern repeats
+                            BIGUINT pattern;
+                            ZT_COUNT(u64Copies[ZT_COPY_PATTERN], 1)
+                            if (dist == 1) { // special case, do it faster
+                                pattern = *from;
+                                pattern = pattern | (pattern << 8);
+                                pattern = pattern | (pattern << 16);
+#if REGISTER_WIDTH == 64
+                                pattern = pattern | (pattern << 32);
+#endif
+                            } else { // 2-7 byte pattern
+                                uint8_t *p = (uint8_t *)&pattern;
+                                for (op=0; op<dist; op++) {
+                                    p[op] = from[op];
+                                }
+                                for (; op<sizeof(BIGUINT); op++) {
+                                    p[op] = p[op - dist];
+                                }
+                            }
+                            dist = sizeof(BIGUINT) - (sizeof(BIGUINT) % dist); // whole repeats per write
+                            while (pOut < pEnd) {
+                                memcpy(pOut, &pattern, sizeof(BIGUINT));
+                                pOut += dist;
+                            }
+                        } else { // regular copy (source and dest don't overlap by < 8 bytes)
+                            ZT_COUNT(u64Copies[ZT_COPY_WIDE], 1)
+                            while (pOut < pEnd) {
+                                memcpy(pOut, from, sizeof(BIGUINT));
+                                pOut += sizeof(BIGUINT);
+                                from += sizeof(BIGUINT);
+                            }
+                        }
+                        // correct for possible overshoot of destination ptr
+                        pOut = pEnd;
+                    }
+                    if (state->u32CopyLen) goto output_full;
+                } // op & 16
+                else if ((op & 64) == 0) {          /* 2nd level distance code */
+                    if (ulBitCount < REGISTER_WIDTH/2) {
+                        GETMOREBITS_SAFE
+                    }
+                    here = dcode[here.val + BITS(op)];
+                    ZT_COUNT(u64DistLinks, 1)
+                    goto get_distance;
+                }
+                else {
+                    //strm->msg = (char *)"invalid distance code";
+                    state->iLastError = ZT_DECODE_ERROR;
+                    goto inflate_exit;
+                }
+            }
+            else if ((op & 64) == 0) {     /* 2nd level length code */
+                if (ulBitCount < REGISTER_WIDTH/2) {
+                    GETMOREBITS_SAFE
+                }
+                here = lcode[here.val + BITS(op)];
+                ZT_COUNT(u64LenLinks, 1)
+                goto get_length;
+            }
+            else if (op & 32) {                     /* end-of-block */
+                state->lenbits = 0; // mark that we completed the current block
+                goto next_block;
+            }
+            else {
+                //strm->msg = (char *)"invalid literal/length code";
+                state->iLastError = ZT_DECODE_ERROR;
+                goto inflate_exit;
+            }
+        } // while decoding the current block
+        goto need_more_data;
+    } // for each block
+output_full:
+    state->iLastError = ZT_OUTPUT_INSUFFICIENT; // drain the output and call again
+    goto inflate_exit;
+need_more_data:
+    state->iLastError = ZT_INPUT_INSUFFICIENT; // need more data
+inflate_exit:
+    if (pBuf > pInEnd) { // give back the zero padding from GETMOREBITS_SAFE
+        BIGUINT ulPad = (BIGUINT)(pBuf - pInEnd) * 8;
+        if (ulPad > ulBitCount) { // we used bits which weren't there
+            ulPad = ulBitCount;
+            if (state->iLastError == ZT_SUCCESS) state->iLastError = ZT_INPUT_INSUFFICIENT;
+        }
+        ulBitCount -= ulPad;
+        pBuf = pInEnd;
+    }
+    state->ulBits = ulBits;
+    state->ulBitCount = ulBitCount;
+    buffer->total_in += (int)(pBuf - buffer->next_in);
+    buffer->avail_in -= (int)(pBuf - buffer->next_in);
+    buffer->next_in = pBuf;
+    state->bLastBlock = bLastBlock;
+    if (pOut > pChecked) {
+        zt_update_check(state, pChecked, (unsigned)(pOut - pChecked));
+    }
+    if (state->pWindow) { // keep the most recent output as the history for the next chunk
+        zt_update_window(state, buffer->next_out, (unsigned)(pOut - buffer->next_out));
+    }
+    buffer->total_out += (int)(intptr_t)(pOut - buffer->next_out);
+    buffer->avail_out -= (int)(intptr_t)(pOut - buffer->next_out);
+    buffer->next_out = pOut;
+    return state->iLastError;
+} /* zt_inflate_body() */
+#ifdef ZT_DISPATCH
+//
+// The same decoder compiled for x86-64 CPUs with BMI2 (Haswell and later);
+// the shifts and masks of the bit accumulator become shrx/shlx/bzhi, which
+// don't tie up the flags or need the shift count in cl
+//
+__attribute__((target("bmi2"))) static int zt_inflate_bmi2(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    return zt_inflate_body(state, buffer, bEnd);
+} /* zt_inflate_bmi2() */
+static int zt_inflate_generic(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    return zt_inflate_body(state, buffer, bEnd);
+} /* zt_inflate_generic() */
+typedef int (ZT_DECODER)(zt_state *state, zt_buffer *buffer, int bEnd);
+//
+// Check the CPU for the best decoder
+//
+static ZT_DECODER *zt_pick_decoder(void)
+{
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("bmi2")) ? zt_inflate_bmi2 : zt_inflate_generic;
+} /* zt_pick_decoder() */
+#endif // ZT_DISPATCH
+//
+// Decode from a single input buffer with the decoder for this CPU
+//
+static int zt_inflate_buffer(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+#ifdef ZT_DISPATCH
+    static ZT_DECODER *pfnDecoder = zt_pick_decoder(); // once per process
+
+    return (*pfnDecoder)(state, buffer, bEnd);
+#else
+    return zt_inflate_body(state, buffer, bEnd);
+#endif
+} /* zt_inflate_buffer() */
+//
+// The stream has ended; the deflate data finishes on a byte boundary, so
+// the whole bytes still in the bit accumulator are the start of whatever
+// follows it. Put them back in front of the carried input.
+//
+static void zt_carry_end(zt_state *state)
+{
+    unsigned int i, n = (unsigned int)(state->ulBitCount >> 3);
+    BIGUINT ulBits = state->ulBits >> (state->ulBitCount & 7);
+
+    memmove(&state->carry[n], state->carry, state->u32Carry);
+    for (i=0; i<n; i++) {
+        state->carry[i] = (uint8_t)ulBits;
+        ulBits >>= 8;
+    }
+    state->u32Carry += n;
+    state->ulBits = 0;
+    state->ulBitCount = 0;
+} /* zt_carry_end() */
+//
+// A gzip member has ended (and zt_carry_end() put back what follows it);
+// if the next bytes start another member, set up the decoder for it the
+// way zt_gunzip_serial() does. Anything else after the last member is
+// ignored, like gzip does. Returns 1 if a new member was started, ZT_SUCCESS
+// if there isn't one or ZT_INPUT_INSUFFICIENT if it can't tell yet (the
+// input is kept in carry[] for the next call).
+//
+static int zt_gzip_next(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    uint8_t u8Magic[2];
+    uint32_t i, n;
+
+    n = state->u32Carry + buffer->avail_in;
+    if (n < 2) {
+        if (bEnd) return ZT_SUCCESS;
+        memcpy(&state->carry[state->u32Carry], buffer->next_in, buffer->avail_in);
+        state->u32Carry += buffer->avail_in;
+        buffer->next_in += buffer->avail_in;
+        buffer->total_in += buffer->avail_in;
+        buffer->avail_in = 0;
+        return ZT_INPUT_INSUFFICIENT;
+    }
+    for (i=0; i<2; i++) {
+        u8Magic[i] = (i < state->u32Carry) ? state->carry[i] : buffer->next_in[i - state->u32Carry];
+    }
+    if (u8Magic[0] != 0x1f || u8Magic[1] != 0x8b) {
+        return ZT_SUCCESS; // trailing data, not another member
+    }
+    // members are independent; the header is parsed by zt_stream_header()
+    state->wbits = 0;
+    state->bLastBlock = 0;
+    state->bTrailer = 0;
+    state->u32MemberOut = buffer->total_out; // (for the ISIZE check)
+    return 1;
+} /* zt_gzip_next() */
+//
+// Inflate with incremental input (see zt_init_carry); the bytes kept from
+// the last call are topped up with the start of the new input and decoded
+// from the carry buffer until the decoder has moved on to the new input;
+// whatever it can't use at the end is kept for next time.
+//
+static int zt_inflate_carry(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    zt_buffer carry;
+    uint32_t u32Copy, u32Used;
+    int rc;
+
+    while (state->u32Carry) {
+        u32Copy = ZT_INPUT_CARRY - state->u32Carry;
+        if (u32Copy > buffer->avail_in) u32Copy = buffer->avail_in;
+        memcpy(&state->carry[state->u32Carry], buffer->next_in, u32Copy);
+        carry = *buffer;
+        carry.next_in = state->carry;
+        carry.avail_in = state->u32Carry + u32Copy;
+        rc = zt_inflate_buffer(state, &carry, bEnd && u32Copy == buffer->avail_in);
+        buffer->next_out = carry.next_out;
+        buffer->avail_out = carry.avail_out;
+        buffer->total_out = carry.total_out;
+        u32Used = (uint32_t)(carry.next_in - state->carry);
+        if (u32Used >= state->u32Carry) { // it has moved on to the new input
+            u32Used -= state->u32Carry;
+            state->u32Carry = 0;
+        } else if (rc == ZT_INPUT_INSUFFICIENT) {
+            // keep the rest, along with all of the new input which fit
+            state->u32Carry += u32Copy - u32Used;
+            memmove(state->carry, &state->carry[u32Used], state->u32Carry);
+            u32Used = u32Copy;
+        } else { // the new input will be added again next time
+            state->u32Carry -= u32Used;
+            memmove(state->carry, &state->carry[u32Used], state->u32Carry);
+            u32Used = 0;
+        }
+        buffer->next_in += u32Used;
+        buffer->avail_in -= u32Used;
+        buffer->total_in += u32Used;
+        if (rc == ZT_SUCCESS) {
+            zt_carry_end(state);
+        }
+        if (rc != ZT_INPUT_INSUFFICIENT || buffer->avail_in == 0) {
+            return rc;
+        }
+        if (state->u32Carry == ZT_INPUT_CARRY) {
+            return ZT_DECODE_ERROR; // nothing valid needs this much to make progress
+        }
+    }
+    rc = zt_inflate_buffer(state, buffer, bEnd);
+    if (rc == ZT_INPUT_INSUFFICIENT && buffer->avail_in <= ZT_INPUT_CARRY) { // keep what it couldn't use yet
+        memcpy(state->carry, buffer->next_in, buffer->avail_in);
+        state->u32Carry = buffer->avail_in;
+        buffer->next_in += buffer->avail_in;
+        buffer->total_in += buffer->avail_in;
+        buffer->avail_in = 0;
+    } else if (rc == ZT_SUCCESS) {
+        zt_carry_end(state);
+    }
+    return rc;
+} /* zt_inflate_carry() */
+//
+// Inflate the given deflated data (see zt_inflate_body above)
+// With incremental input (zt_init_carry), the input can be passed in pieces
+// of any size, and a gzip stream (ZT_FORMAT_GZIP/AUTO) carries on into the
+// members which follow it, like zt_gunzip() does.
+//
+int zt_inflate(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    int rc;
+
+    if (state == NULL || buffer == NULL) return ZT_INVALID_PARAMETER;
+    if (!state->bCarry) {
+        return zt_inflate_buffer(state, buffer, bEnd);
+    }
+    rc = zt_inflate_carry(state, buffer, bEnd);
+    while (rc == ZT_SUCCESS && state->u8Format == ZT_FORMAT_GZIP) {
+        rc = zt_gzip_next(state, buffer, bEnd);
+        if (rc != 1) break; // no more members (or not enough input to tell)
+        rc = zt_inflate_carry(state, buffer, bEnd);
+    }
+    return rc;
+} /* zt_inflate() */
+//
+// Inflate in streaming mode (see zt_init_window). The output is decoded
+// into pChunk and each time it fills up (or the data ends), the chunk is
+// passed to the callback function and the buffer is reused for the next one.
+// Peak memory use is the window + chunk instead of the full output size.
+// If the callback returns 0, decoding stops with ZT_OUTPUT_INSUFFICIENT
+// and can be resumed later by calling this function again.
+//
+int zt_inflate_stream(zt_state *state, zt_buffer *buffer, int bEnd, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser)
+{
+    int rc;
+
+    if (state == NULL || buffer == NULL || state->pWindow == NULL || pChunk == NULL || iChunkSize <= 0 || pfnOutput == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    do {
+        buffer->next_out = pChunk;
+        buffer->avail_out = (uint32_t)iChunkSize;
+        rc = zt_inflate(state, buffer, bEnd);
+        if (rc != ZT_SUCCESS && rc != ZT_OUTPUT_INSUFFICIENT && rc != ZT_INPUT_INSUFFICIENT && rc != ZT_BLOCK_END) {
+            break; // decode error
+        }
+        if (buffer->next_out != pChunk) { // pass along what we have
+            if ((*pfnOutput)(pUser, pChunk, (int)(buffer->next_out - pChunk)) == 0) {
+                return (rc == ZT_SUCCESS) ? ZT_SUCCESS : ZT_OUTPUT_INSUFFICIENT; // caller asked us to stop
+            }
+        }
+    } while (rc == ZT_OUTPUT_INSUFFICIENT);
+    return rc;
+} /* zt_inflate_stream() */
+//
+// Inflate into a scatter/gather list of output segments (see
+// zt_init_segments); buffer->next_out and avail_out are set here. When the
+// list is full before the data ends, ZT_OUTPUT_INSUFFICIENT is returned.
+// The amount of output is in buffer->total_out, and state->u32Seg and
+// u32SegPos tell where it ends in the list. Like zt_inflate(), it can be
+// called again with more input.
+//
+int zt_inflate_segments(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    zt_segment *pSeg;
+    uint8_t *pStart;
+    int rc;
+
+    if (state == NULL || buffer == NULL || state->pSegs == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    do {
+        // move past the full (or empty) segments
+        while (state->u32Seg < state->u32SegCount && state->u32SegPos >= state->pSegs[state->u32Seg].u32Size) {
+            state->u32Seg++;
+            state->u32SegPos = 0;
+        }
+        if (state->u32Seg >= state->u32SegCount) {
+            return ZT_OUTPUT_INSUFFICIENT; // out of segments
+        }
+        pSeg = &state->pSegs[state->u32Seg];
+        pStart = &pSeg->pData[state->u32SegPos];
+        buffer->next_out = pStart;
+        buffer->avail_out = pSeg->u32Size - state->u32SegPos;
+        rc = zt_inflate(state, buffer, bEnd);
+        state->u32SegPos += (uint32_t)(buffer->next_out - pStart);
+    } while (rc == ZT_OUTPUT_INSUFFICIENT);
+    return rc;
+} /* zt_inflate_segments() */
+//
+// Give growable output a larger buffer. The output so far stays at the start
+// of it and next_out/avail_out are moved to the new one; back-references are
+// relative to next_out - total_out, so decoding carries on as if it had been
+// there all along. When all of the input is present, the new size is a guess
+// at the final size from the compression ratio so far (or the gzip trailer),
+// so most streams are allocated two or three times at close to their real
+// size; it grows by at least half each time either way.
+//
+static int zt_grow_output(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    uint8_t *pOld, *pNew;
+    uint64_t u64Old, u64Size, u64Left;
+
+    pOld = buffer->next_out - buffer->total_out;
+    u64Old = (uint64_t)buffer->total_out + buffer->avail_out;
+    u64Size = u64Old * 2;
+    if (bEnd) {
+        u64Left = (uint64_t)buffer->avail_in + state->u32Carry; // input not decoded yet
+        if (buffer->total_out == 0 || buffer->total_in <= state->u32Carry) {
+            // nothing to go by yet; a gzip trailer has the size (mod 2^32) of
+            // the last member, otherwise decode as much as the input to get a ratio
+            u64Size = u64Left;
+            if (buffer->total_in == 0 && buffer->avail_in >= 18 && buffer->next_in[0] == 0x1f && buffer->next_in[1] == 0x8b) {
+                const uint8_t *s = &buffer->next_in[buffer->avail_in - 4];
+                u64Size = s[0] | (s[1] << 8) | (s[2] << 16) | ((uint32_t)s[3] << 24);
+            }
+        } else {
+            u64Size = buffer->total_out + (u64Left * buffer->total_out) / (buffer->total_in - state->u32Carry);
+            u64Size += u64Size / 8; // a little extra for a change of ratio
+        }
+        if (u64Size < u64Old + u64Old/2) u64Size = u64Old + u64Old/2;
+    }
+    if (u64Size < ZT_GROW_MIN) u64Size = ZT_GROW_MIN;
+    if (u64Size > 0xffffffff) u64Size = 0xffffffff; // (the size is kept in 32 bits)
+    if (u64Size <= u64Old || (size_t)u64Size != u64Size) {
+        return ZT_OUTPUT_INSUFFICIENT;
+    }
+    pNew = (*state->pfnRealloc)(state->pReallocUser, (u64Old) ? pOld : NULL, (size_t)u64Old, (size_t)u64Size);
+    if (pNew == NULL) {
+        return ZT_OUTPUT_INSUFFICIENT; // the old buffer is still there to resume with
+    }
+    buffer->next_out = pNew + buffer->total_out;
+    buffer->avail_out = (uint32_t)(u64Size - buffer->total_out);
+    return ZT_SUCCESS;
+} /* zt_grow_output() */
+//
+// Inflate into a growable output buffer (see zt_init_grow). buffer->next_out
+// and avail_out start as a buffer from the hook (or NULL and 0 to let the
+// first one be allocated here) and are moved to a larger one whenever it
+// fills up. At the end, the output starts at buffer->next_out -
+// buffer->total_out and it's up to the caller to free (or shrink) it.
+// ZT_OUTPUT_INSUFFICIENT means the hook couldn't provide more space; the
+// current buffer is left in place. Like zt_inflate(), it can be called again
+// with more input.
+//
+int zt_inflate_grow(zt_state *state, zt_buffer *buffer, int bEnd)
+{
+    int rc;
+
+    if (state == NULL || buffer == NULL || state->pfnRealloc == NULL || state->pWindow || state->pSegs) {
+        return ZT_INVALID_PARAMETER;
+    }
+    if (buffer->avail_out == 0 && (buffer->avail_in || state->u32Carry)) {
+        rc = zt_grow_output(state, buffer, bEnd);
+        if (rc != ZT_SUCCESS) return rc;
+    }
+    rc = zt_inflate(state, buffer, bEnd);
+    while (rc == ZT_OUTPUT_INSUFFICIENT) {
+        if (zt_grow_output(state, buffer, bEnd) != ZT_SUCCESS) break;
+        rc = zt_inflate(state, buffer, bEnd);
+    }
+    return rc;
+} /* zt_inflate_grow() */
+//
+// Find the start of the deflate data and the format of the stream
+// (see zt_detect_format)
+// Returns NULL if the header is invalid or not supported
+//
+static uint8_t *zt_stream_start(uint8_t *pCompressed, size_t iSize, int *piFormat)
+{
+    *piFormat = zt_detect_format(pCompressed, iSize);
+    switch (*piFormat) {
+        case ZT_FORMAT_GZIP:
+            return zt_gzip_header(pCompressed, iSize);
+        case ZT_FORMAT_ZLIB:
+            if (pCompressed[1] & 0x20) return NULL; // preset dictionary isn't supported here
+            return &pCompressed[2];
+        case ZT_FORMAT_RAW:
+            return pCompressed;
+    }
+    return NULL;
+} /* zt_stream_start() */
+//
+// Add an access point to the index with a copy of the current window
+//
+static int zt_index_add(zt_index *pIndex, zt_state *state, uint64_t u64InBits, uint64_t u64OutOffset)
+{
+    zt_point *pPoint;
+    unsigned have, pos, copy;
+
+    if (pIndex->iCount == pIndex->iMax) { // make room for more
+        int iMax = (pIndex->iMax) ? pIndex->iMax * 2 : 16;
+        pPoint = (zt_point *)realloc(pIndex->pPoints, iMax * sizeof(zt_point));
+        if (pPoint == NULL) return ZT_INVALID_PARAMETER; // out of memory
+        pIndex->pPoints = pPoint;
+        pIndex->iMax = iMax;
+    }
+    pPoint = &pIndex->pPoints[pIndex->iCount];
+    have = state->u32WindowHave;
+    pPoint->u64InBits = u64InBits;
+    pPoint->u64OutOffset = u64OutOffset;
+    pPoint->u32WindowHave = have;
+    pPoint->pWindow = NULL;
+    if (have) {
+        pPoint->pWindow = (uint8_t *)malloc(have);
+        if (pPoint->pWindow == NULL) return ZT_INVALID_PARAMETER;
+        // the window is circular; copy it out in order (oldest byte first)
+        pos = (state->u32WindowPos - have) & (state->u32WindowSize - 1);
+        copy = state->u32WindowSize - pos;
+        if (copy > have) copy = have;
+        memcpy(pPoint->pWindow, &state->pWindow[pos], copy);
+        memcpy(&pPoint->pWindow[copy], state->pWindow, have - copy);
+    }
+    pIndex->iCount++;
+    return ZT_SUCCESS;
+} /* zt_index_add() */
+//
+// Start a new gzip member after the one which just finished; returns the
+// start of its deflate data, NULL at the end of the data or sets *pRC if
+// something is wrong
+//
+static uint8_t *zt_next_deflate(zt_state *state, zt_buffer *buffer, uint8_t *pEnd, int iFormat, uint8_t *pWindow, int *pRC)
+{
+    uint8_t *s = NULL;
+
+    if (iFormat != ZT_FORMAT_GZIP || zt_gzip_trailer(state, buffer, pEnd, 0, &s) != ZT_SUCCESS || s == NULL) {
+        return NULL; // that was the end
+    }
+    s = zt_gzip_header(s, (size_t)(pEnd - s));
+    if (s == NULL) {
+        *pRC = ZT_HEADER_ERROR;
+        return NULL;
+    }
+    zt_init(state);
+    state->wbits = 15;
+    zt_init_window(state, pWindow, 15);
+    return s;
+} /* zt_next_deflate() */
+//
+// Build an index for random access into compressed data (gzip, zlib or
+// raw deflate) by decoding all of it once. An access point is recorded at
+// the first block boundary after every u32Span bytes of output; each point
+// holds the bit offset of the block, its output offset and the 32K of
+// output which precedes it, so decoding can resume there with
+// zt_index_extract(). Members of multi-member gzip files each get a point.
+// The index is allocated with malloc; release it with zt_index_free().
+//
+int zt_index_build(uint8_t *pCompressed, size_t iSize, uint32_t u32Span, zt_index **ppIndex)
+{
+    zt_index *pIndex;
+    zt_state state;
+    zt_buffer buffer;
+    uint8_t *s, *pEnd, *pChunk;
+    uint64_t u64Out = 0;
+    size_t iLeft;
+    int rc, iFormat, bEnd;
+
+    if (pCompressed == NULL || ppIndex == NULL || u32Span == 0) {
+        return ZT_INVALID_PARAMETER;
+    }
+    *ppIndex = NULL;
+    pEnd = &pCompressed[iSize];
+    s = zt_stream_start(pCompressed, iSize, &iFormat);
+    if (s == NULL) {
+        return ZT_HEADER_ERROR;
+    }
+    pIndex = (zt_index *)calloc(1, sizeof(zt_index));
+    if (pIndex == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    pIndex->u8Format = (uint8_t)iFormat;
+    pIndex->u32Span = u32Span;
+    pIndex->pWork = (uint8_t *)malloc(2 * ZT_MAX_WINDOW); // window + output chunk
+    if (pIndex->pWork == NULL) {
+        zt_index_free(pIndex);
+        return ZT_INVALID_PARAMETER;
+    }
+    pChunk = &pIndex->pWork[ZT_MAX_WINDOW];
+    zt_init(&state);
+    state.wbits = 15; // the header (if any) was already skipped
+    zt_init_window(&state, pIndex->pWork, 15);
+    buffer.next_in = s;
+    buffer.total_in = 0;
+    rc = zt_index_add(pIndex, &state, (uint64_t)(s - pCompressed) * 8, 0);
+    while (rc == ZT_SUCCESS) {
+        state.bBlockStop = 1;
+        iLeft = (size_t)(pEnd - buffer.next_in);
+        buffer.avail_in = (iLeft > 0x40000000) ? 0x40000000 : (uint32_t)iLeft;
+        buffer.next_out = pChunk;
+        buffer.avail_out = ZT_MAX_WINDOW;
+        buffer.total_out = 0;
+        bEnd = (buffer.avail_in == iLeft);
+        rc = zt_inflate(&state, &buffer, bEnd);
+        u64Out += (uint64_t)(buffer.next_out - pChunk);
+        if (rc == ZT_BLOCK_END) {
+            rc = ZT_SUCCESS;
+            if (u64Out - pIndex->pPoints[pIndex->iCount-1].u64OutOffset >= u32Span) {
+                rc = zt_index_add(pIndex, &state, (uint64_t)(buffer.next_in - pCompressed) * 8 - state.ulBitCount, u64Out);
+            }
+        } else if (rc == ZT_OUTPUT_INSUFFICIENT || (rc == ZT_INPUT_INSUFFICIENT && !bEnd)) {
+            rc = ZT_SUCCESS; // keep going
+        } else if (rc == ZT_SUCCESS) { // end of the stream (or gzip member)
+            s = zt_next_deflate(&state, &buffer, pEnd, iFormat, pIndex->pWork, &rc);
+            if (s == NULL) break;
+            buffer.next_in = s;
+            rc = zt_index_add(pIndex, &state, (uint64_t)(s - pCompressed) * 8, u64Out);
+        }
+    }
+    if (rc != ZT_SUCCESS) {
+        zt_index_free(pIndex);
+        return rc;
+    }
+    pIndex->u64OutSize = u64Out;
+    *ppIndex = pIndex;
+    return ZT_SUCCESS;
+} /* zt_index_build() */
+//
+// Read iLen bytes of uncompressed data starting at u64Offset by resuming
+// from the closest access point before it. pCompressed must be the same
+// data the index was built from. Returns the number of bytes read (less
+// than iLen at the end of the data) or a negative error code (-ZT_xxx)
+//
+int zt_index_extract(zt_index *pIndex, uint8_t *pCompressed, size_t iSize, uint64_t u64Offset, uint8_t *pOut, int iLen)
+{
+    zt_state state;
+    zt_buffer buffer;
+    zt_point *pPoint;
+    uint8_t *s, *pEnd, *pChunk, *pStart;
+    uint64_t u64Skip;
+    size_t iLeft;
+    int rc, iDone, lo, hi, mid, bEnd;
+
+    if (pIndex == NULL || pIndex->iCount == 0 || pCompressed == NULL || pOut == NULL || iLen < 0) {
+        return -ZT_INVALID_PARAMETER;
+    }
+    if (u64Offset >= pIndex->u64OutSize || iLen == 0) {
+        return 0;
+    }
+    if (pIndex->pWork == NULL) { // index was loaded with zt_index_read()
+        pIndex->pWork = (uint8_t *)malloc(2 * ZT_MAX_WINDOW);
+        if (pIndex->pWork == NULL) return -ZT_INVALID_PARAMETER;
+    }
+    pChunk = &pIndex->pWork[ZT_MAX_WINDOW];
+    // binary search for the last point at or before the offset
+    lo = 0;
+    hi = pIndex->iCount - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) >> 1;
+        if (pIndex->pPoints[mid].u64OutOffset <= u64Offset) lo = mid;
+        else hi = mid - 1;
+    }
+    pPoint = &pIndex->pPoints[lo];
+    if ((pPoint->u64InBits >> 3) >= iSize) {
+        return -ZT_INVALID_PARAMETER; // not the data this index is for
+    }
+    // restore the decoder state as it was at the start of that block
+    zt_init(&state);
+    state.wbits = 15;
+    zt_init_window(&state, pIndex->pWork, 15);
+    if (pPoint->u32WindowHave) {
+        memcpy(pIndex->pWork, pPoint->pWindow, pPoint->u32WindowHave);
+    }
+    state.u32WindowPos = pPoint->u32WindowHave & (ZT_MAX_WINDOW - 1);
+    state.u32WindowHave = pPoint->u32WindowHave;
+    buffer.next_in = &pCompressed[pPoint->u64InBits >> 3];
+    buffer.total_in = 0;
+    if (pPoint->u64InBits & 7) { // the block starts in the middle of a byte
+        state.ulBitCount = 8 - (pPoint->u64InBits & 7);
+        state.ulBits = *buffer.next_in++ >> (pPoint->u64InBits & 7);
+    }
+    pEnd = &pCompressed[iSize];
+    u64Skip = u64Offset - pPoint->u64OutOffset;
+    iDone = 0;
+    while (iDone < iLen) {
+        iLeft = (size_t)(pEnd - buffer.next_in);
+        buffer.avail_in = (iLeft > 0x40000000) ? 0x40000000 : (uint32_t)iLeft;
+        if (u64Skip) { // decode up to the requested offset and throw it away
+            buffer.next_out = pChunk;
+            buffer.avail_out = (u64Skip < ZT_MAX_WINDOW) ? (uint32_t)u64Skip : ZT_MAX_WINDOW;
+        } else { // then straight into the caller's buffer
+            buffer.next_out = &pOut[iDone];
+            buffer.avail_out = (uint32_t)(iLen - iDone);
+        }
+        buffer.total_out = 0;
+        pStart = buffer.next_out;
+        bEnd = (buffer.avail_in == iLeft);
+        rc = zt_inflate(&state, &buffer, bEnd);
+        if (u64Skip) {
+            u64Skip -= (uint64_t)(buffer.next_out - pStart);
+        } else {
+            iDone += (int)(buffer.next_out - pStart);
+        }
+        if (rc == ZT_OUTPUT_INSUFFICIENT || (rc == ZT_INPUT_INSUFFICIENT && !bEnd)) {
+            continue;
+        }
+        if (rc != ZT_SUCCESS) {
+            return -rc;
+        }
+        s = zt_next_deflate(&state, &buffer, pEnd, pIndex->u8Format, pIndex->pWork, &rc);
+        if (s == NULL) {
+            if (rc != ZT_SUCCESS) return -rc;
+            break; // end of the data
+        }
+        buffer.next_in = s;
+    }
+    return iDone;
+} /* zt_index_extract() */
+//
+// Helpers to store multi-byte values in little-endian order
+//
+static uint8_t *zt_put_le(uint8_t *d, uint64_t u64, int iBytes)
+{
+    while (iBytes--) {
+        *d++ = (uint8_t)u64;
+        u64 >>= 8;
+    }
+    return d;
+} /* zt_put_le() */
+static uint64_t zt_get_le(const uint8_t *s, int iBytes)
+{
+    uint64_t u64 = 0;
+    while (iBytes--) {
+        u64 = (u64 << 8) | s[iBytes];
+    }
+    return u64;
+} /* zt_get_le() */
+#define ZT_INDEX_HEADER 24 // "ZTIX", version, format, span, count, output size
+#define ZT_POINT_HEADER 20 // bit offset, output offset, window size
+//
+// Return the number of bytes needed to save the index with zt_index_write()
+//
+size_t zt_index_size(zt_index *pIndex)
+{
+    size_t iSize = ZT_INDEX_HEADER;
+    int i;
+
+    for (i=0; i<pIndex->iCount; i++) {
+        iSize += ZT_POINT_HEADER + pIndex->pPoints[i].u32WindowHave;
+    }
+    return iSize;
+} /* zt_index_size() */
+//
+// Serialize the index into pData (zt_index_size() bytes) so that it can
+// be saved to a file. Returns the number of bytes written
+//
+size_t zt_index_write(zt_index *pIndex, uint8_t *pData)
+{
+    uint8_t *d = pData;
+    zt_point *pPoint;
+    int i;
+
+    memcpy(d, "ZTIX", 4);
+    d[4] = 1; // version
+    d[5] = pIndex->u8Format;
+    d = zt_put_le(&d[6], 0, 2);
+    d = zt_put_le(d, pIndex->u32Span, 4);
+    d = zt_put_le(d, (uint64_t)pIndex->iCount, 4);
+    d = zt_put_le(d, pIndex->u64OutSize, 8);
+    for (i=0; i<pIndex->iCount; i++) {
+        pPoint = &pIndex->pPoints[i];
+        d = zt_put_le(d, pPoint->u64InBits, 8);
+        d = zt_put_le(d, pPoint->u64OutOffset, 8);
+        d = zt_put_le(d, pPoint->u32WindowHave, 4);
+        if (pPoint->u32WindowHave) {
+            memcpy(d, pPoint->pWindow, pPoint->u32WindowHave);
+            d += pPoint->u32WindowHave;
+        }
+    }
+    return (size_t)(d - pData);
+} /* zt_index_write() */
+//
+// Load an index which was saved with zt_index_write()
+// The index is allocated with malloc; release it with zt_index_free()
+//
+int zt_index_read(uint8_t *pData, size_t iSize, zt_index **ppIndex)
+{
+    zt_index *pIndex;
+    zt_point *pPoint;
+    uint8_t *s, *pEnd;
+    int i, iCount;
+
+    if (pData == NULL || ppIndex == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    *ppIndex = NULL;
+    if (iSize < ZT_INDEX_HEADER || memcmp(pData, "ZTIX", 4) != 0 || pData[4] != 1) {
+        return ZT_HEADER_ERROR;
+    }
+    iCount = (int)zt_get_le(&pData[12], 4);
+    if (iCount <= 0 || (size_t)iCount > (iSize - ZT_INDEX_HEADER) / ZT_POINT_HEADER) {
+        return ZT_HEADER_ERROR;
+    }
+    pIndex = (zt_index *)calloc(1, sizeof(zt_index));
+    if (pIndex == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    pIndex->u8Format = pData[5];
+    pIndex->u32Span = (uint32_t)zt_get_le(&pData[8], 4);
+    pIndex->u64OutSize = zt_get_le(&pData[16], 8);
+    pIndex->pPoints = (zt_point *)calloc(iCount, sizeof(zt_point));
+    if (pIndex->pPoints == NULL) {
+        free(pIndex);
+        return ZT_INVALID_PARAMETER;
+    }
+    pIndex->iMax = iCount;
+    s = &pData[ZT_INDEX_HEADER];
+    pEnd = &pData[iSize];
+    for (i=0; i<iCount; i++) {
+        pPoint = &pIndex->pPoints[i];
+        if (pEnd - s < ZT_POINT_HEADER) break;
+        pPoint->u64InBits = zt_get_le(s, 8);
+        pPoint->u64OutOffset = zt_get_le(&s[8], 8);
+        pPoint->u32WindowHave = (uint32_t)zt_get_le(&s[16], 4);
+        s += ZT_POINT_HEADER;
+        if (pPoint->u32WindowHave > ZT_MAX_WINDOW || (size_t)(pEnd - s) < pPoint->u32WindowHave) break;
+        pIndex->iCount++; // from here on, zt_index_free() releases it
+        if (pPoint->u32WindowHave) {
+            pPoint->pWindow = (uint8_t *)malloc(pPoint->u32WindowHave);
+            if (pPoint->pWindow == NULL) break;
+            memcpy(pPoint->pWindow, s, pPoint->u32WindowHave);
+            s += pPoint->u32WindowHave;
+        }
+    }
+    if (i != iCount) { // truncated or corrupt
+        zt_index_free(pIndex);
+        return ZT_HEADER_ERROR;
+    }
+    *ppIndex = pIndex;
+    return ZT_SUCCESS;
+} /* zt_index_read() */
+//
+// Free an index from zt_index_build() or zt_index_read()
+//
+void zt_index_free(zt_index *pIndex)
+{
+    int i;
+
+    if (pIndex == NULL) return;
+    for (i=0; i<pIndex->iCount; i++) {
+        free(pIndex->pPoints[i].pWindow);
+    }
+    free(pIndex->pPoints);
+    free(pIndex->pWork);
+    free(pIndex);
+} /* zt_index_free() */
+//
+// Largest piece of input or output given to zt_inflate() at a time by the
+// 64-bit functions below; zt_buffer only has 32-bit counters
+//
+#define ZT_MAX_PIECE 0x40000000
+//
+// Decode everything in pSpan->pIn: one zlib or raw deflate stream, or all
+// of the members of a gzip file. The output is handed to zt_inflate() up to
+// ZT_MAX_PIECE bytes at a time, with the output already decoded in the same
+// stream as its history. Returns ZT_OUTPUT_INSUFFICIENT if the output is
+// full; it can continue after the caller makes it larger.
+//
+static int zt_inflate_span(zt_state *state, zt_span *pSpan)
+{
+    zt_buffer buffer;
+    uint8_t *s, *pInEnd = &pSpan->pIn[pSpan->u64InSize];
+    uint64_t u64Left, u64History;
+    uint32_t u32Size;
+    int rc, bEnd;
+
+    if (pSpan->bDone) return ZT_SUCCESS;
+    for (;;) {
+        if (!pSpan->bInStream) { // parse the header of the next stream or member
+            if (!pSpan->bStarted) {
+                s = zt_stream_start(pSpan->pIn, (size_t)pSpan->u64InSize, &pSpan->iFormat);
+                pSpan->bStarted = 1;
+            } else {
+                s = zt_gzip_header(&pSpan->pIn[pSpan->u64InPos], (size_t)(pSpan->u64InSize - pSpan->u64InPos));
+            }
+            if (s == NULL) return ZT_HEADER_ERROR;
+            zt_reset(state);
+            state->wbits = 15; // the header was already skipped
+            if (pSpan->bVerify && pSpan->iFormat != ZT_FORMAT_RAW) {
+                zt_init_check(state, (pSpan->iFormat == ZT_FORMAT_GZIP) ? ZT_CHECK_CRC32 : ZT_CHECK_ADLER32);
+            }
+            pSpan->u64InPos = (uint64_t)(s - pSpan->pIn);
+            pSpan->u64MemberOut = pSpan->u64OutPos;
+            pSpan->bInStream = 1;
+        }
+        do {
+            u64Left = pSpan->u64InSize - pSpan->u64InPos;
+            buffer.next_in = &pSpan->pIn[pSpan->u64InPos];
+            buffer.avail_in = (u64Left > ZT_MAX_PIECE) ? ZT_MAX_PIECE : (uint32_t)u64Left;
+            buffer.total_in = 0;
+            bEnd = (buffer.avail_in == u64Left);
+            u64Left = pSpan->u64OutSize - pSpan->u64OutPos;
+            u64History = pSpan->u64OutPos - pSpan->u64MemberOut;
+            buffer.next_out = &pSpan->pOut[pSpan->u64OutPos];
+            buffer.avail_out = (u64Left > ZT_MAX_PIECE) ? ZT_MAX_PIECE : (uint32_t)u64Left;
+            buffer.total_out = (u64History > ZT_MAX_WINDOW) ? ZT_MAX_WINDOW : (uint32_t)u64History; // all that matches can reach
+            rc = zt_inflate(state, &buffer, bEnd);
+            pSpan->u64InPos = (uint64_t)(buffer.next_in - pSpan->pIn);
+            pSpan->u64OutPos = (uint64_t)(buffer.next_out - pSpan->pOut);
+        } while ((rc == ZT_INPUT_INSUFFICIENT && !bEnd) || (rc == ZT_OUTPUT_INSUFFICIENT && pSpan->u64OutPos < pSpan->u64OutSize));
+        if (rc != ZT_SUCCESS) return rc;
+        pSpan->bInStream = 0;
+        if (pSpan->iFormat != ZT_FORMAT_GZIP) { // zt_inflate() checked the zlib trailer
+            pSpan->bDone = 1;
+            return ZT_SUCCESS;
+        }
+        // the gzip trailer starts with the whole bytes left in the bit accumulator
+        s = &pSpan->pIn[pSpan->u64InPos] - (state->ulBitCount >> 3);
+        if (pInEnd - s < 8) return ZT_INPUT_INSUFFICIENT;
+        u32Size = (uint32_t)(pSpan->u64OutPos - pSpan->u64MemberOut); // ISIZE is the size mod 2^32
+        if (pSpan->bVerify && (state->u32Check != (uint32_t)zt_get_le(s, 4) || u32Size != (uint32_t)zt_get_le(&s[4], 4))) {
+            return ZT_CHECKSUM_ERROR;
+        }
+        s += 8;
+        if (pInEnd - s < 18 || !zt_gzip_member_start(s)) { // no more members
+            pSpan->bDone = 1;
+            return ZT_SUCCESS;
+        }
+        pSpan->u64InPos = (uint64_t)(s - pSpan->pIn);
+    }
+} /* zt_inflate_span() */
+//
+// Decode gzip (including multi-member files), zlib or raw deflate data of
+// any size in one shot. The format is detected from the header. Unlike
+// zt_gunzip(), the sizes aren't limited to 32 bits. The number of bytes
+// written is returned in *pu64OutSize.
+//
+int zt_inflate_mem(uint8_t *pIn, uint64_t u64InSize, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify)
+{
+    zt_state state;
+    zt_span span;
+    int rc;
+
+    if (pu64OutSize == NULL || zt_init_span(&span, pIn, u64InSize, pOut, u64OutSize, bVerify) != ZT_SUCCESS) {
+        return ZT_INVALID_PARAMETER;
+    }
+    zt_init_temp(&state); // zt_reset() takes care of the rest
+    rc = zt_inflate_span(&state, &span);
+    *pu64OutSize = span.u64OutPos;
+    return rc;
+} /* zt_inflate_mem() */
+//
+// Prepare a decode of gzip/zlib/raw deflate data (detected from the
+// header) which can be done a piece at a time; see zt_inflate_partial()
+//
+int zt_init_span(zt_span *pSpan, uint8_t *pIn, uint64_t u64InSize, uint8_t *pOut, uint64_t u64OutSize, int bVerify)
+{
+    if (pSpan == NULL || pIn == NULL || pOut == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    memset(pSpan, 0, sizeof(zt_span));
+    pSpan->pIn = pIn;
+    pSpan->u64InSize = u64InSize;
+    pSpan->pOut = pOut;
+    pSpan->u64OutSize = u64OutSize;
+    pSpan->bVerify = bVerify;
+    return ZT_SUCCESS;
+} /* zt_init_span() */
+//
+// Decode only as much as the caller needs (e.g. to sniff the start of a
+// document) instead of all of it. Decoding stops once the total output
+// reaches u64Limit (0 = no limit), or when the callback, which is shown
+// all the output so far every ZT_PARTIAL_STEP bytes, returns 1 to say it
+// has enough. That returns ZT_OUTPUT_INSUFFICIENT with the amount decoded
+// in pSpan->u64OutPos, and the decode can be resumed later by calling
+// this again with a higher limit. ZT_SUCCESS means the data ended.
+// The decoder (set up with zt_init) must be kept in between calls.
+//
+int zt_inflate_partial(zt_state *state, zt_span *pSpan, uint64_t u64Limit, ZT_ENOUGH_CALLBACK *pfnEnough, void *pUser)
+{
+    uint64_t u64OutSize, u64Stop;
+    int rc;
+
+    if (state == NULL || pSpan == NULL || pSpan->pIn == NULL || pSpan->pOut == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    u64OutSize = pSpan->u64OutSize; // the real size of the output buffer
+    if (u64Limit == 0 || u64Limit > u64OutSize) u64Limit = u64OutSize;
+    while (pSpan->u64OutPos < u64Limit) {
+        u64Stop = (pfnEnough) ? pSpan->u64OutPos + ZT_PARTIAL_STEP : u64Limit;
+        if (u64Stop > u64Limit) u64Stop = u64Limit;
+        pSpan->u64OutSize = u64Stop; // zt_inflate_span() stops when it's "full"
+        rc = zt_inflate_span(state, pSpan);
+        pSpan->u64OutSize = u64OutSize;
+        if (rc != ZT_OUTPUT_INSUFFICIENT) {
+            return rc; // finished or an error
+        }
+        if (pfnEnough && (*pfnEnough)(pUser, pSpan->pOut, pSpan->u64OutPos)) {
+            break;
+        }
+    }
+    return ZT_OUTPUT_INSUFFICIENT;
+} /* zt_inflate_partial() */
+#ifdef ZT_FILES
+//
+// Map a whole file for reading. The decoder never reads past the end of
+// its input, so no padding is needed after the data (which could fault at
+// the end of the last page)
+//
+static uint8_t *zt_map_input(const char *szName, uint64_t *pu64Size)
+{
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = open(szName, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (p == MAP_FAILED) return NULL;
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL); // read ahead and drop pages behind us
+    *pu64Size = (uint64_t)st.st_size;
+    return (uint8_t *)p;
+} /* zt_map_input() */
+//
+// Set the size of the output file. On Linux the space is allocated too, so
+// a full disk is an error here instead of a SIGBUS when the mapped pages
+// get written.
+//
+static int zt_file_size(int fd, uint64_t u64Size)
+{
+#ifdef __linux__
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size < u64Size) {
+        return posix_fallocate(fd, 0, (off_t)u64Size);
+    }
+#endif
+    return ftruncate(fd, (off_t)u64Size);
+} /* zt_file_size() */
+//
+// Decode a gzip/zlib/raw deflate file into a caller-provided buffer (see
+// zt_inflate_mem). The input is memory mapped instead of being read into
+// memory first.
+//
+int zt_inflate_file_mem(const char *szIn, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify)
+{
+    uint8_t *pIn;
+    uint64_t u64InSize;
+    int rc;
+
+    if (szIn == NULL || pOut == NULL || pu64OutSize == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    pIn = zt_map_input(szIn, &u64InSize);
+    if (pIn == NULL) return ZT_INVALID_PARAMETER;
+    rc = zt_inflate_mem(pIn, u64InSize, pOut, u64OutSize, pu64OutSize, bVerify);
+    munmap(pIn, (size_t)u64InSize);
+    return rc;
+} /* zt_inflate_file_mem() */
+//
+// Decode a gzip/zlib/raw deflate file into another file, both memory
+// mapped, so neither is copied through a heap buffer. The output file is
+// mapped at a guess of its size and grown (remapped at twice the size) as
+// needed, then truncated to the real size. The output file is removed if
+// there's an error. The size is returned in *pu64OutSize if it's not NULL.
+//
+int zt_inflate_file(const char *szIn, const char *szOut, uint64_t *pu64OutSize, int bVerify)
+{
+    zt_state *state;
+    zt_span span;
+    uint64_t u64Size;
+    void *p;
+    int rc, fd;
+
+    if (szIn == NULL || szOut == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    memset(&span, 0, sizeof(span));
+    span.bVerify = bVerify;
+    span.pIn = zt_map_input(szIn, &span.u64InSize);
+    if (span.pIn == NULL) return ZT_INVALID_PARAMETER;
+    state = (zt_state *)malloc(sizeof(zt_state));
+    fd = open(szOut, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (state == NULL || fd < 0) {
+        free(state);
+        if (fd >= 0) close(fd);
+        munmap(span.pIn, (size_t)span.u64InSize);
+        return ZT_INVALID_PARAMETER;
+    }
+    zt_init_temp(state); // zt_reset() takes care of the rest
+    // A gzip trailer has the size (mod 2^32) of the last member, which is
+    // right for most files; otherwise start with 4x the input
+    u64Size = span.u64InSize * 4;
+    if (span.u64InSize >= 18 && span.pIn[0] == 0x1f && span.pIn[1] == 0x8b) {
+        u64Size = zt_get_le(&span.pIn[span.u64InSize - 4], 4);
+        if (u64Size < span.u64InSize) u64Size = span.u64InSize;
+    }
+    if (u64Size < 65536) u64Size = 65536;
+    rc = ZT_OUTPUT_INSUFFICIENT;
+    while (rc == ZT_OUTPUT_INSUFFICIENT) {
+        if (span.pOut) { // it didn't fit; grow it
+            munmap(span.pOut, (size_t)span.u64OutSize);
+            span.pOut = NULL;
+            u64Size = span.u64OutSize * 2;
+        }
+        if ((size_t)u64Size != u64Size || zt_file_size(fd, u64Size) != 0) {
+            rc = ZT_OUTPUT_INSUFFICIENT; // too large for this system or the disk is full
+            break;
+        }
+        p = mmap(NULL, (size_t)u64Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            rc = ZT_OUTPUT_INSUFFICIENT;
+            break;
+        }
+        madvise(p, (size_t)u64Size, MADV_SEQUENTIAL);
+        span.pOut = (uint8_t *)p;
+        span.u64OutSize = u64Size;
+        rc = zt_inflate_span(state, &span);
+    }
+    if (span.pOut) munmap(span.pOut, (size_t)span.u64OutSize);
+    munmap(span.pIn, (size_t)span.u64InSize);
+    free(state);
+    if (rc == ZT_SUCCESS && ftruncate(fd, (off_t)span.u64OutPos) != 0) {
+        rc = ZT_OUTPUT_INSUFFICIENT;
+    }
+    close(fd);
+    if (rc != ZT_SUCCESS) {
+        unlink(szOut);
+    } else if (pu64OutSize) {
+        *pu64OutSize = span.u64OutPos;
+    }
+    return rc;
+} /* zt_inflate_file() */
+#endif // ZT_FILES
+//
+// PNG decoder front end
+//
+// The IDAT chunks are fed straight to the inflater in streaming mode (a 32K
+// window and a ZT_PNG_CHUNK output buffer) and each row is unfiltered as
+// soon as it's complete, while it's still in the cache, instead of in a
+// second pass over the whole image. Rows go to the caller's image buffer,
+// or through a callback with only two of them kept in the work buffer.
+//
+typedef struct zt_png_tag {
+    zt_state *state;
+    zt_buffer buffer;
+    uint8_t *pChunk;            // inflater output
+    uint8_t *pStage;            // a filtered row which was split between two chunks
+    uint32_t u32Staged;
+    uint8_t *pRows[2];          // unfiltered rows in callback mode; pRows[1] starts as zeros
+    uint8_t *pOut;
+    size_t iPitch;
+    uint32_t u32Row, u32Height, u32RowLen;
+    int iBpp;
+    int iError;
+    ZT_ROW_CALLBACK *pfnRow;
+    void *pUser;
+} zt_png;
+
+static uint32_t zt_get_be32(const uint8_t *s)
+{
+    return ((uint32_t)s[0] << 24) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 8) | s[3];
+} /* zt_get_be32() */
+//
+// Read the image header (IHDR) of a PNG file
+// Returns ZT_HEADER_ERROR if it's not a valid PNG file
+//
+int zt_png_info(uint8_t *pPNG, size_t iSize, zt_png_header *pHeader)
+{
+    static const uint8_t u8Signature[8] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+    uint8_t *s;
+    int iChannels;
+
+    if (pPNG == NULL || pHeader == NULL) return ZT_INVALID_PARAMETER;
+    if (iSize < 33 || memcmp(pPNG, u8Signature, 8) != 0 || zt_get_be32(&pPNG[8]) != 13 || memcmp(&pPNG[12], "IHDR", 4) != 0) {
+        return ZT_HEADER_ERROR;
+    }
+    s = &pPNG[16];
+    pHeader->u32Width = zt_get_be32(s);
+    pHeader->u32Height = zt_get_be32(&s[4]);
+    pHeader->u8BitDepth = s[8];
+    pHeader->u8ColorType = s[9];
+    pHeader->u8Interlace = s[12];
+    switch (pHeader->u8ColorType) {
+        case ZT_PNG_GRAY:
+            iChannels = 1;
+            if (s[8] != 1 && s[8] != 2 && s[8] != 4 && s[8] != 8 && s[8] != 16) return ZT_HEADER_ERROR;
+            break;
+        case ZT_PNG_PALETTE:
+            iChannels = 1;
+            if (s[8] != 1 && s[8] != 2 && s[8] != 4 && s[8] != 8) return ZT_HEADER_ERROR;
+            break;
+        case ZT_PNG_RGB:
+        case ZT_PNG_GRAY_ALPHA:
+        case ZT_PNG_RGBA:
+            iChannels = (s[9] == ZT_PNG_RGB) ? 3 : (s[9] == ZT_PNG_RGBA) ? 4 : 2;
+            if (s[8] != 8 && s[8] != 16) return ZT_HEADER_ERROR;
+            break;
+        default:
+            return ZT_HEADER_ERROR;
+    }
+    if (pHeader->u32Width == 0 || pHeader->u32Height == 0 || pHeader->u32Width > 0x7fffffff || pHeader->u32Height > 0x7fffffff ||
+        s[10] != 0 || s[11] != 0 || s[12] > 1) {
+        return ZT_HEADER_ERROR;
+    }
+    if (((uint64_t)pHeader->u32Width * iChannels * s[8] + 7) / 8 >= 0x7fffffff) {
+        return ZT_HEADER_ERROR; // rows too long to handle
+    }
+    pHeader->u32Pitch = (uint32_t)(((uint64_t)pHeader->u32Width * iChannels * s[8] + 7) / 8);
+    pHeader->u8Bpp = (uint8_t)((iChannels * s[8] + 7) / 8);
+    return ZT_SUCCESS;
+} /* zt_png_info() */
+//
+// Size of the work buffer zt_png_decode() needs for an image; the decoder,
+// its window and output chunk (about 48K in all) + 3 rows
+//
+size_t zt_png_work_size(zt_png_header *pHeader)
+{
+    if (pHeader == NULL) return 0;
+    return sizeof(zt_state) + 8 + ZT_MAX_WINDOW + ZT_PNG_CHUNK + (size_t)pHeader->u32Pitch * 3 + 1;
+} /* zt_png_work_size() */
+//
+// The filters of one PNG pixel at a time for the wider formats (RGB/RGBA/
+// gray+alpha at 8 or 16 bits, 3-8 bytes per pixel). The pixel is held in
+// the low bytes of a vector register; the Paeth predictor works on 16-bit
+// lanes. Each of these is inlined with a constant iBpp.
+//
+#if defined(__SSE2__)
+static inline __m128i zt_pixel_load(const uint8_t *p, int iBpp)
+{
+    uint64_t u64 = 0;
+    memcpy(&u64, p, iBpp);
+    return _mm_loadl_epi64((const __m128i *)&u64);
+} /* zt_pixel_load() */
+
+static inline void zt_pixel_store(uint8_t *p, __m128i v, int iBpp)
+{
+    uint64_t u64;
+    _mm_storel_epi64((__m128i *)&u64, v);
+    memcpy(p, &u64, iBpp);
+} /* zt_pixel_store() */
+
+static inline void zt_unfilter_sub(uint8_t *pDst, const uint8_t *pSrc, uint32_t u32Len, int iBpp)
+{
+    __m128i a = _mm_setzero_si128();
+    uint32_t i;
+
+    for (i=0; i<u32Len; i+=iBpp) {
+        a = _mm_add_epi8(zt_pixel_load(&pSrc[i], iBpp), a);
+        zt_pixel_store(&pDst[i], a, iBpp);
+    }
+} /* zt_unfilter_sub() */
+
+static inline void zt_unfilter_avg(uint8_t *pDst, const uint8_t *pSrc, const uint8_t *pPrior, uint32_t u32Len, int iBpp)
+{
+    __m128i a = _mm_setzero_si128(), b, avg;
+    const __m128i one = _mm_set1_epi8(1);
+    uint32_t i;
+
+    for (i=0; i<u32Len; i+=iBpp) {
+        b = zt_pixel_load(&pPrior[i], iBpp);
+        avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one)); // pavgb rounds up
+        a = _mm_add_epi8(zt_pixel_load(&pSrc[i], iBpp), avg);
+        zt_pixel_store(&pDst[i], a, iBpp);
+    }
+} /* zt_unfilter_avg() */
+
+static inline void zt_unfilter_paeth(uint8_t *pDst, const uint8_t *pSrc, const uint8_t *pPrior, uint32_t u32Len, int iBpp)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero, b, c = zero, pa, pb, pc, smallest, nearest, mask;
+    uint32_t i;
+
+    for (i=0; i<u32Len; i+=iBpp) {
+        b = _mm_unpacklo_epi8(zt_pixel_load(&pPrior[i], iBpp), zero);
+        pa = _mm_sub_epi16(b, c); // |p-a| = |b-c|
+        pb = _mm_sub_epi16(a, c); // |p-b| = |a-c|
+        pc = _mm_add_epi16(pa, pb); // |p-c| = |a+b-2c|
+        pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+        pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+        pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+        smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+        mask = _mm_cmpeq_epi16(pb, smallest);
+        nearest = _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, c));
+        mask = _mm_cmpeq_epi16(pa, smallest); // a wins ties, then b
+        nearest = _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, nearest));
+        a = _mm_add_epi8(zt_pixel_load(&pSrc[i], iBpp), _mm_packus_epi16(nearest, nearest));
+        zt_pixel_store(&pDst[i], a, iBpp);
+        a = _mm_unpacklo_epi8(a, zero);
+        c = b;
+    }
+} /* zt_unfilter_paeth() */
+#define ZT_PIXEL_FILTERS
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+static inline uint8x8_t zt_pixel_load(const uint8_t *p, int iBpp)
+{
+    uint64_t u64 = 0;
+    memcpy(&u64, p, iBpp);
+    return vcreate_u8(u64);
+} /* zt_pixel_load() */
+
+static inline void zt_pixel_store(uint8_t *p, uint8x8_t v, int iBpp)
+{
+    uint64_t u64 = vget_lane_u64(vreinterpret_u64_u8(v), 0);
+    memcpy(p, &u64, iBpp);
+} /* zt_pixel_store() */
+
+static inline void zt_unfilter_sub(uint8_t *pDst, const uint8_t *pSrc, uint32_t u32Len, int iBpp)
+{
+    uint8x8_t a = vdup_n_u8(0);
+    uint32_t i;
+
+    for (i=0; i<u32Len; i+=iBpp) {
+        a = vadd_u8(zt_pixel_load(&pSrc[i], iBpp), a);
+        zt_pixel_store(&pDst[i], a, iBpp);
+    }
+} /* zt_unfilter_sub() */
+
+static inline void zt_unfilter_avg(uint8_t *pDst, const uint8_t *pSrc, const uint8_t *pPrior, uint32_t u32Len, int iBpp)
+{
+    uint8x8_t a = vdup_n_u8(0);
+    uint32_t i;
+
+    for (i=0; i<u32Len; i+=iBpp) {
+        a = vadd_u8(zt_pixel_load(&pSrc[i], iBpp), vhadd_u8(a, zt_pixel_load(&pPrior[i], iBpp)));
+        zt_pixel_store(&pDst[i], a, iBpp);
+    }
+} /* zt_unfilter_avg() */
+
+static inline void zt_unfilter_paeth(uint8_t *pDst, const uint8_t *pSrc, const uint8_t *pPrior, uint32_t u32Len, int iBpp)
+{
+    uint8x8_t a = vdup_n_u8(0), b, c = a, nearest;
+    uint16x8_t pa, pb, pc, smallest;
+    uint32_t i;
+
+    for (i=0; i<u32Len; i+=iBpp) {
+        b = zt_pixel_load(&pPrior[i], iBpp);
+        pa = vabdl_u8(b, c); // |p-a| = |b-c|
+        pb = vabdl_u8(a, c); // |p-b| = |a-c|
+        pc = vabdq_u16(vaddl_u8(a, b), vshll_n_u8(c, 1)); // |p-c| = |a+b-2c|
+        smallest = vminq_u16(pc, vminq_u16(pa, pb));
+        nearest = vbsl_u8(vmovn_u16(vceqq_u16(pb, smallest)), b, c);
+        nearest = vbsl_u8(vmovn_u16(vceqq_u16(pa, smallest)), a, nearest); // a wins ties, then b
+        a = vadd_u8(zt_pixel_load(&pSrc[i], iBpp), nearest);
+        zt_pixel_store(&pDst[i], a, iBpp);
+        c = b;
+    }
+} /* zt_unfilter_paeth() */
+#define ZT_PIXEL_FILTERS
+#endif
+//
+// Undo the filter of one row (None, Sub, Up, Average or Paeth). pPrior is
+// the previous unfiltered row (zeros for the first one)
+// Returns ZT_DECODE_ERROR for an unknown filter type
+//
+static int zt_png_unfilter(uint8_t *pDst, const uint8_t *pSrc, const uint8_t *pPrior, uint32_t u32Len, int iBpp, int iFilter)
+{
+    uint32_t i;
+    int a, b, c, pa, pb, pc;
+
+#ifdef ZT_PIXEL_FILTERS
+    if (iFilter == 1 || iFilter == 3 || iFilter == 4) {
+        // one vector register per pixel, with the size known at compile time
+        switch ((iFilter << 4) | iBpp) {
+            case 0x13: zt_unfilter_sub(pDst, pSrc, u32Len, 3); return ZT_SUCCESS;
+            case 0x14: zt_unfilter_sub(pDst, pSrc, u32Len, 4); return ZT_SUCCESS;
+            case 0x16: zt_unfilter_sub(pDst, pSrc, u32Len, 6); return ZT_SUCCESS;
+            case 0x18: zt_unfilter_sub(pDst, pSrc, u32Len, 8); return ZT_SUCCESS;
+            case 0x33: zt_unfilter_avg(pDst, pSrc, pPrior, u32Len, 3); return ZT_SUCCESS;
+            case 0x34: zt_unfilter_avg(pDst, pSrc, pPrior, u32Len, 4); return ZT_SUCCESS;
+            case 0x36: zt_unfilter_avg(pDst, pSrc, pPrior, u32Len, 6); return ZT_SUCCESS;
+            case 0x38: zt_unfilter_avg(pDst, pSrc, pPrior, u32Len, 8); return ZT_SUCCESS;
+            case 0x43: zt_unfilter_paeth(pDst, pSrc, pPrior, u32Len, 3); return ZT_SUCCESS;
+            case 0x44: zt_unfilter_paeth(pDst, pSrc, pPrior, u32Len, 4); return ZT_SUCCESS;
+            case 0x46: zt_unfilter_paeth(pDst, pSrc, pPrior, u32Len, 6); return ZT_SUCCESS;
+            case 0x48: zt_unfilter_paeth(pDst, pSrc, pPrior, u32Len, 8); return ZT_SUCCESS;
+            default: break; // 1 or 2 bytes per pixel
+        }
+    }
+#endif
+    switch (iFilter) {
+        case 0: // None
+            memcpy(pDst, pSrc, u32Len);
+            break;
+        case 1: // Sub
+            for (i=0; i<(uint32_t)iBpp; i++) {
+                pDst[i] = pSrc[i];
+            }
+            for (; i<u32Len; i++) {
+                pDst[i] = pSrc[i] + pDst[i - iBpp];
+            }
+            break;
+        case 2: // Up
+            i = 0;
+#if defined(__SSE2__)
+            for (; i+16<=u32Len; i+=16) {
+                _mm_storeu_si128((__m128i *)&pDst[i], _mm_add_epi8(_mm_loadu_si128((const __m128i *)&pSrc[i]), _mm_loadu_si128((const __m128i *)&pPrior[i])));
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            for (; i+16<=u32Len; i+=16) {
+                vst1q_u8(&pDst[i], vaddq_u8(vld1q_u8(&pSrc[i]), vld1q_u8(&pPrior[i])));
+            }
+#endif
+            for (; i<u32Len; i++) {
+                pDst[i] = pSrc[i] + pPrior[i];
+            }
+            break;
+        case 3: // Average
+            for (i=0; i<(uint32_t)iBpp; i++) {
+                pDst[i] = pSrc[i] + (pPrior[i] >> 1);
+            }
+            for (; i<u32Len; i++) {
+                pDst[i] = pSrc[i] + ((pDst[i - iBpp] + pPrior[i]) >> 1);
+            }
+            break;
+        case 4: // Paeth
+            for (i=0; i<(uint32_t)iBpp; i++) {
+                pDst[i] = pSrc[i] + pPrior[i]; // a = c = 0, so it predicts b
+            }
+            for (; i<u32Len; i++) {
+                a = pDst[i - iBpp];
+                b = pPrior[i];
+                c = pPrior[i - iBpp];
+                pa = abs(b - c);
+                pb = abs(a - c);
+                pc = abs(a + b - c - c);
+                if (pb < pa && pb <= pc) a = b;
+                else if (pc < pa && pc < pb) a = c;
+                pDst[i] = pSrc[i] + (uint8_t)a;
+            }
+            break;
+        default:
+            return ZT_DECODE_ERROR;
+    }
+    return ZT_SUCCESS;
+} /* zt_png_unfilter() */
+//
+// Unfilter a complete row into the image (or the next row buffer) and pass
+// it to the callback, if there is one
+// Returns 0 to stop decoding (an invalid filter or the callback said so)
+//
+static int zt_png_row(zt_png *png, const uint8_t *pRow)
+{
+    uint8_t *pDst, *pPrior;
+
+    if (png->pOut) {
+        pDst = &png->pOut[(size_t)png->u32Row * png->iPitch];
+        pPrior = (png->u32Row) ? pDst - png->iPitch : png->pRows[1];
+    } else { // the two row buffers take turns
+        pDst = png->pRows[png->u32Row & 1];
+        pPrior = png->pRows[(png->u32Row & 1) ^ 1];
+    }
+    if (zt_png_unfilter(pDst, &pRow[1], pPrior, png->u32RowLen - 1, png->iBpp, pRow[0]) != ZT_SUCCESS) {
+        png->iError = ZT_DECODE_ERROR;
+        return 0;
+    }
+    png->u32Row++;
+    if (png->pfnRow && !(*png->pfnRow)(png->pUser, (int)png->u32Row - 1, pDst, (int)png->u32RowLen - 1)) {
+        png->iError = ZT_OUTPUT_INSUFFICIENT; // the caller has what it needs
+        return 0;
+    }
+    return 1;
+} /* zt_png_row() */
+//
+// Streaming mode output callback; splits the inflated data into rows
+// (a filter type byte + the filtered pixels). Rows are unfiltered directly
+// from the output chunk unless they straddle two chunks.
+//
+static int zt_png_output(void *pUser, uint8_t *pData, int iLen)
+{
+    zt_png *png = (zt_png *)pUser;
+    const uint8_t *pRow;
+    uint32_t u32Copy;
+
+    while (iLen > 0 && png->u32Row < png->u32Height) { // anything after the last row is ignored
+        if (png->u32Staged == 0 && (uint32_t)iLen >= png->u32RowLen) { // all of it is here
+            pRow = pData;
+            pData += png->u32RowLen;
+            iLen -= (int)png->u32RowLen;
+        } else { // collect the pieces
+            u32Copy = png->u32RowLen - png->u32Staged;
+            if (u32Copy > (uint32_t)iLen) u32Copy = (uint32_t)iLen;
+            memcpy(&png->pStage[png->u32Staged], pData, u32Copy);
+            png->u32Staged += u32Copy;
+            pData += u32Copy;
+            iLen -= (int)u32Copy;
+            if (png->u32Staged < png->u32RowLen) break;
+            png->u32Staged = 0;
+            pRow = png->pStage;
+        }
+        if (!zt_png_row(png, pRow)) return 0;
+    }
+    return 1;
+} /* zt_png_output() */
+//
+// Decode a (non-interlaced) PNG image. The unfiltered rows are written to
+// pOut, iPitch bytes apart (0 = the width of a row), and/or passed to the
+// row callback as they're finished. With pOut = NULL, only two rows are
+// kept; the callback gets each one and the previous one is still valid.
+// pWork is the decoder's memory (see zt_png_work_size); nothing is
+// allocated. If bVerify is true, the IDAT chunk CRCs and the zlib Adler-32
+// are checked. The pixels are left in the file's format (palette indices,
+// big-endian 16-bit samples, etc).
+//
+int zt_png_decode(uint8_t *pPNG, size_t iSize, uint8_t *pOut, size_t iPitch, ZT_ROW_CALLBACK *pfnRow, void *pUser, uint8_t *pWork, size_t iWorkSize, int bVerify)
+{
+    zt_png_header hdr;
+    zt_png png;
+    uint8_t *s, *pEnd, *pNext, *d;
+    uint32_t u32Len;
+    int rc, bLast;
+
+    rc = zt_png_info(pPNG, iSize, &hdr);
+    if (rc != ZT_SUCCESS) return rc;
+    if (hdr.u8Interlace) return ZT_HEADER_ERROR; // Adam7 isn't supported
+    if ((pOut == NULL && pfnRow == NULL) || pWork == NULL || iWorkSize < zt_png_work_size(&hdr)) {
+        return ZT_INVALID_PARAMETER;
+    }
+    if (iPitch == 0) iPitch = hdr.u32Pitch;
+    if (pOut && iPitch < hdr.u32Pitch) return ZT_INVALID_PARAMETER;
+    memset(&png, 0, sizeof(png));
+    d = (uint8_t *)(((uintptr_t)pWork + 7) & ~(uintptr_t)7);
+    png.state = (zt_state *)d;
+    d += sizeof(zt_state);
+    zt_init(png.state);
+    zt_init_window(png.state, d, 15);
+    zt_init_carry(png.state); // the IDAT chunks can split the data anywhere
+    if (bVerify) {
+        zt_init_check(png.state, ZT_CHECK_ADLER32);
+    }
+    d += ZT_MAX_WINDOW;
+    png.pChunk = d;
+    d += ZT_PNG_CHUNK;
+    png.pStage = d;
+    d += hdr.u32Pitch + 1;
+    png.pRows[0] = d;
+    png.pRows[1] = d + hdr.u32Pitch;
+    memset(png.pRows[1], 0, hdr.u32Pitch); // the row "above" the first one
+    png.u32RowLen = hdr.u32Pitch + 1;
+    png.u32Height = hdr.u32Height;
+    png.iBpp = hdr.u8Bpp;
+    png.pOut = pOut;
+    png.iPitch = iPitch;
+    png.pfnRow = pfnRow;
+    png.pUser = pUser;
+    rc = ZT_INPUT_INSUFFICIENT;
+    s = &pPNG[33]; // first chunk after the IHDR
+    pEnd = &pPNG[iSize];
+    while (pEnd - s >= 12) {
+        u32Len = zt_get_be32(s);
+        if (u32Len > (size_t)(pEnd - s) - 12) break; // truncated
+        pNext = &s[12 + u32Len];
+        if (memcmp(&s[4], "IDAT", 4) == 0) {
+            if (bVerify && zt_crc32(0, &s[4], (int)u32Len + 4) != zt_get_be32(&s[8 + u32Len])) {
+                return ZT_CHECKSUM_ERROR;
+            }
+            bLast = (pEnd - pNext < 8 || memcmp(&pNext[4], "IDAT", 4) != 0);
+            png.buffer.next_in = &s[8];
+            png.buffer.avail_in = u32Len;
+            rc = zt_inflate_stream(png.state, &png.buffer, bLast, png.pChunk, ZT_PNG_CHUNK, zt_png_output, &png);
+            if (png.iError != ZT_SUCCESS) return png.iError;
+            if (rc != ZT_INPUT_INSUFFICIENT || bLast) break;
+        } else if (memcmp(&s[4], "IEND", 4) == 0) {
+            break;
         }
+        s = pNext;
     }
-next_block:
-    while (!bLastBlock && pBuf < pEndOfInput && pOut < pEndOfOutput) {
-        if (ulBitCount <= REGISTER_WIDTH/2) { // get more bits
-            GETMOREBITS;
+    if (rc == ZT_SUCCESS && png.u32Row < png.u32Height) {
+        rc = ZT_DECODE_ERROR; // the data ended too soon
+    }
+    return rc;
+} /* zt_png_decode() */
+//
+// Deflate compressor
+//
+// The whole input is in memory, so matches are found by looking back into
+// it directly instead of through a sliding window. The hash table and chains
+// hold 16-bit positions; an entry which is 64K or more bytes old points at
+// the wrong data, which the match check rejects, so they never need to be
+// adjusted as the input moves along. The literals and matches of each block
+// are buffered so that it can be written with whichever of dynamic Huffman,
+// fixed Huffman or stored coding is the smallest.
+//
+typedef struct zt_deflate_config_tag {
+    uint16_t good;      /* search less when the previous match is this long */
+    uint16_t lazy;      /* don't look for a better match after one this long (0 = greedy) */
+    uint16_t nice;      /* stop searching when a match is this long */
+    uint16_t chain;     /* most hash chain entries to check */
+} zt_deflate_config;
+
+static const zt_deflate_config zt_levels[10] = {
+    {0, 0, 0, 0},           /* 0 - stored blocks only */
+    {0, 0, 0, 1},           /* 1 - a single hash probe, greedy */
+    {4, 0, 16, 8},          /* 2 - greedy with hash chains */
+    {4, 0, 32, 32},         /* 3 */
+    {4, 4, 16, 16},         /* 4 - lazy matching */
+    {8, 16, 32, 32},        /* 5 */
+    {8, 16, 128, 128},      /* 6 */
+    {8, 32, 128, 256},      /* 7 */
+    {32, 128, 258, 1024},   /* 8 */
+    {32, 258, 258, 4096}};  /* 9 */
+static const uint16_t zt_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t zt_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t zt_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577};
+static const uint8_t zt_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Compressor state; it lives at the start of the caller's work buffer and is
+// followed by the symbol buffer, the hash table and the hash chains
+typedef struct zt_deflate_tag {
+    const uint8_t *pIn;         /* uncompressed data */
+    size_t iInSize;
+    size_t iBlockStart;         /* input offset of the current block */
+    size_t iBlockLen;           /* input bytes covered by the buffered symbols */
+    uint8_t *pOut;              /* next output byte */
+    uint8_t *pOutEnd;
+    BIGUINT ulBits;             /* output bit accumulator */
+    BIGUINT ulBitCount;         /* number of bits in ulBits */
+    int iLevel;
+    int iHashBits;
+    uint16_t *pHead;            /* latest position of each hash value */
+    uint16_t *pPrev;            /* previous position with the same hash (levels 2-9) */
+    uint32_t u32WindowMask;     /* farthest match distance - 1 */
+    uint32_t *pSyms;            /* a literal or (distance << 16) | length */
+    int iSymCount;
+    int iSymMax;
+    uint32_t u32LitFreq[288];   /* symbol counts of the current block */
+    uint32_t u32DistFreq[32];
+    uint32_t u32CodeFreq[19];   /* code length code counts */
+    uint8_t u8LitLen[288];      /* Huffman code lengths and (bit reversed) codes */
+    uint8_t u8DistLen[32];
+    uint8_t u8CodeLen[19];
+    uint16_t u16LitCode[288];
+    uint16_t u16DistCode[32];
+    uint16_t u16CodeCode[19];
+    uint8_t u8FixedLitLen[288];
+    uint8_t u8FixedDistLen[32];
+    uint16_t u16FixedLitCode[288];
+    uint16_t u16FixedDistCode[32];
+    uint8_t u8LenCode[256];     /* length - 3 -> length code */
+    uint8_t u8DistCode[512];    /* distance -> distance code (see zt_dist_code) */
+    uint8_t u8Rle[2*(286+30)];  /* run length coded code lengths and extra bits */
+    uint32_t u32Sort[288];      /* work area for zt_huff_build() */
+    uint32_t u32Tree[288];
+} zt_deflate_state;
+//
+// Work out the table sizes for a work buffer of iWorkSize bytes (0 = the
+// default sizes). The largest table is halved until they all fit, down to
+// 2048 symbols per block, a 1K hash table and a 1K window. Returns the
+// bytes needed or 0 if the buffer is too small for even those.
+//
+static size_t zt_deflate_layout(int iLevel, size_t iWorkSize, int *piHashBits, uint32_t *pu32Window, int *piSymMax)
+{
+    int iHashBits = ZT_DEFLATE_HASH_BITS, iSymMax = ZT_DEFLATE_SYMBOLS;
+    uint32_t u32Window = (iLevel >= 2) ? ZT_MAX_WINDOW : 0;
+    size_t iHash, iSyms, iNeed;
+
+    if (iLevel == 0) { // stored blocks don't need any tables
+        iHashBits = iSymMax = 0;
+    }
+    for (;;) {
+        iHash = (iHashBits) ? sizeof(uint16_t) << iHashBits : 0;
+        iSyms = iSymMax * sizeof(uint32_t);
+        iNeed = sizeof(zt_deflate_state) + 8 + iSyms + iHash + u32Window * sizeof(uint16_t); // +8 to align it
+        if (iWorkSize == 0 || iNeed <= iWorkSize) break;
+        if (iSymMax > 2048 && iSyms >= iHash && iSyms >= u32Window * sizeof(uint16_t)) {
+            iSymMax >>= 1;
+        } else if (iHashBits > 10 && iHash >= u32Window * sizeof(uint16_t)) {
+            iHashBits--;
+        } else if (u32Window > 1024) {
+            u32Window >>= 1;
+        } else if (iSymMax > 2048) {
+            iSymMax >>= 1;
+        } else if (iHashBits > 10) {
+            iHashBits--;
+        } else {
+            return 0;
         }
-        if (state->lenbits == 0) { // need to parse the block header
-            if ((pEndOfInput - pBuf) < 96) {
-                goto need_more_data; // don't risk running out of data while decoding the block header
+    }
+    *piHashBits = iHashBits;
+    *pu32Window = u32Window;
+    *piSymMax = iSymMax;
+    return iNeed;
+} /* zt_deflate_layout() */
+//
+// Assign canonical Huffman codes to a set of code lengths. Deflate sends the
+// codes starting from their most significant bit, so they're stored reversed
+// to go straight into the (LSB first) bit writer.
+//
+static void zt_huff_codes(const uint8_t *pLens, int iCount, uint16_t *pCodes)
+{
+    uint16_t count[MAXBITS+1], next[MAXBITS+1];
+    unsigned code, rev;
+    int i, len;
+
+    memset(count, 0, sizeof(count));
+    for (i=0; i<iCount; i++) {
+        count[pLens[i]]++;
+    }
+    count[0] = 0;
+    code = 0;
+    for (len=1; len<=MAXBITS; len++) {
+        code = (code + count[len-1]) << 1;
+        next[len] = (uint16_t)code;
+    }
+    for (i=0; i<iCount; i++) {
+        len = pLens[i];
+        if (len) {
+            code = next[len]++;
+            for (rev=0; len; len--) {
+                rev = (rev << 1) | (code & 1);
+                code >>= 1;
             }
-            bLastBlock = BITS(1);
-            DROPBITS(1);
-            u8 = BITS(2);
-            DROPBITS(2);
-            switch (u8) {
-                case 0: // stored
-                    NEXTBYTE(ulBitCount);
-                    u32 = ulBits & 0xffffffff;
-                    ulBitCount -= 32;
-                    if ((u32 & 0xffff) != ((u32 >> 16) ^ 0xffff)) {
-                        // bad length
-                        return -1;
-                    }
-                    iLen = u32 & 0xffff;
-                    pBuf += ((REGISTER_WIDTH-ulBitCount) >> 3);
-                    memcpy(pOut, pBuf, iLen);
-                    pBuf += iLen;
-                    pOut += iLen;
-                    ulBits = *(BIGUINT *)pBuf; // get more bits to work with
-                    ulBitCount = REGISTER_WIDTH;
-                    continue; // next block
-                    break;
-                case 1: // static Huffman table
-                    state->lencode = lenfix;
-                    state->lenbits = 9;
-                    state->distcode = distfix;
-                    state->distbits = 5;
-                    break;
-                case 2: // dynamic Huffman table
-                    nlen = BITS(5);
-                    nlen += 257;
-                    state->nlen = nlen;
-                    DROPBITS(5);
-                    ndist = BITS(5);
-                    ndist += 1;
-                    state->ndist = ndist;
-                    DROPBITS(5);
-                    ncode = BITS(4);
-                    ncode += 4;
-                    state->ncode = ncode;
-                    DROPBITS(4);
-                    // get the lengths of the lengths
-                    for (i=0; i<ncode; i++) {
-                        uint16_t codelen;
-                        if (ulBitCount <= REGISTER_WIDTH/2) { // get more bits
-                            GETMOREBITS;
-                        }
-                        codelen = BITS(3);
-                        state->lens[len_order[i]] = codelen;
-                        DROPBITS(3); // 3 bits per length
-                    }
-                    while (i < 19) {
-                        state->lens[len_order[i++]] = 0;
-                    }
-                    state->have = 19;
-                    state->next = state->codes;
-                    state->lencode = (const code *)(state->next);
-                    state->lenbits = 7;
-                    ret = zt_table(CODES,
-                                        state->lens,
-                                        19,
-                                        &(state->next),
-                                        &(state->lenbits),
-                                        state->work);
-                    if (ret) {
-                        //   strm->msg = (char *)"invalid code lengths set";
-                        state->iLastError = ZT_DECODE_ERROR;
-                        break;
-                    }
-                    state->have = 0;
-                    
-                    //state->mode = CODELENS;
-                    while (state->have < state->nlen + state->ndist) {
-                        if (ulBitCount <= REGISTER_WIDTH/2) { // get more bits
-                            GETMOREBITS;
-                        }
-                        here = state->lencode[BITS(state->lenbits)];
-                        if (here.val < 16) {
-                            DROPBITS(here.bits);
-                            state->lens[state->have++] = here.val;
-                        }
-                        else {
-                            if (here.val == 16) {
-                                if (ulBitCount <= REGISTER_WIDTH/2) GETMOREBITS
-                                    //NEEDBITS(here.bits + 2);
-                                    DROPBITS(here.bits);
-                                if (state->have == 0) {
-                                    state->iLastError = ZT_DECODE_ERROR;
-                                    break;
-                                }
-                                len = state->lens[state->have - 1];
-                                copy = 3 + BITS(2);
-                                DROPBITS(2);
-                            }
-                            else if (here.val == 17) {
-                                if (ulBitCount <= REGISTER_WIDTH/2) GETMOREBITS
-                                    //NEEDBITS(here.bits + 3);
-                                    DROPBITS(here.bits);
-                                len = 0;
-                                copy = 3 + BITS(3);
-                                DROPBITS(3);
-                            }
-                            else {
-                                if (ulBitCount <= REGISTER_WIDTH/2) GETMOREBITS
-                                    //NEEDBITS(here.bits + 7);
-                                    DROPBITS(here.bits);
-                                len = 0;
-                                copy = 11 + BITS(7);
-                                DROPBITS(7);
-                            }
-                            if (state->have + copy > state->nlen + state->ndist) {
-                                //strm->msg = (char *)"invalid bit length repeat";
-                                state->iLastError = ZT_DECODE_ERROR;
-                                break;
-                            }
-                            while (copy--)
-                                state->lens[state->have++] = (uint16_t)len;
-                        }
-                    }
-                    
-                    /* handle error breaks in while */
-                    // if (state->mode == BAD) break;
-                    
-                    /* check for end-of-block code (better have one) */
-                    if (state->lens[256] == 0) {
-                        // strm->msg = (char *)"invalid code -- missing end-of-block";
-                        state->iLastError = ZT_DECODE_ERROR;
-                        break;
-                    }
-                    
-                    /* build code tables -- note: do not change the lenbits or distbits
-                     values here (9 and 6) without reading the comments in inftrees.h
-                     concerning the ENOUGH constants, which depend on those values */
-                    state->next = state->codes;
-                    state->lencode = (const code *)(state->next);
-                    state->lenbits = 9;
-                    ret = zt_table(LENS, state->lens, state->nlen, &(state->next),
-                                        &(state->lenbits), state->work);
-                    if (ret) {
-                        // strm->msg = (char *)"invalid literal/lengths set";
-                        state->iLastError = ZT_DECODE_ERROR;
-                        break;
-                    }
-                    state->distcode = (const code *)(state->next);
-                    state->distbits = 6;
-                    ret = zt_table(DISTS, state->lens + state->nlen, state->ndist,
-                                        &(state->next), &(state->distbits), state->work);
-                    if (ret) {
-                        // strm->msg = (char *)"invalid distances set";
-                        state->iLastError = ZT_DECODE_ERROR;
-                        break;
-                    }
-                    break;
-                case 3: // reserved
-                    break;
-            } // switch on block type
-            } // need to parse block header
-                // Decode the block
-                lmask = (1U << state->lenbits) - 1;
-                dmask = (1U << state->distbits) - 1;
-                //whave = state->whave;
-                lcode = state->lencode;
-                dcode = state->distcode;
-                if (ulBitCount <= REGISTER_WIDTH/2) GETMOREBITS
-                    
-                while (pBuf < pEndOfInput && pOut < pEndOfOutput) {
-#if REGISTER_WIDTH == 32 // this check isn't needed on 64-bit machines
-                    if (ulBitCount <= REGISTER_WIDTH/2) {
-                        GETMOREBITS
-                    }
+            pCodes[i] = (uint16_t)rev;
+        }
+    }
+} /* zt_huff_codes() */
+//
+// Build a length limited Huffman code for the symbol counts in pFreq.
+// The code lengths come from Moffat and Katajainen's in-place algorithm on
+// the sorted counts. Any which are too long are cut to iMaxLen and then
+// shorter codes are lengthened until the code is complete again. There are
+// always at least 2 codes, because a lone code of 1 bit is an incomplete
+// code which some decoders refuse.
+//
+static void zt_huff_build(zt_deflate_state *s, const uint32_t *pFreq, int iCount, int iMaxLen, uint8_t *pLens, uint16_t *pCodes)
+{
+    uint32_t *pSort = s->u32Sort, *A = s->u32Tree;
+    uint32_t u32, total, count[MAXBITS+1];
+    int i, j, n, gap, root, leaf, next, avbl, used, dpth;
+    static const uint8_t gaps[] = {57, 23, 10, 4, 1};
+
+    memset(pLens, 0, iCount);
+    for (i=0, n=0; i<iCount; i++) {
+        if (pFreq[i]) pSort[n++] = (pFreq[i] << 9) | i; // counts are < 2^23
+    }
+    if (n < 2) { // give a second symbol a 1-bit code too
+        pLens[0] = pLens[1] = 1;
+        if (n == 1 && (pSort[0] & 511) > 1) {
+            pLens[pSort[0] & 511] = 1;
+            pLens[1] = 0;
+        }
+        zt_huff_codes(pLens, iCount, pCodes);
+        return;
+    }
+    for (gap=0; gap<(int)sizeof(gaps); gap++) { // Shell sort by count
+        for (i=gaps[gap]; i<n; i++) {
+            u32 = pSort[i];
+            for (j=i; j>=gaps[gap] && pSort[j-gaps[gap]] > u32; j -= gaps[gap]) {
+                pSort[j] = pSort[j-gaps[gap]];
+            }
+            pSort[j] = u32;
+        }
+    }
+    for (i=0; i<n; i++) {
+        A[i] = pSort[i] >> 9;
+    }
+    // build the tree in place, then turn the parent pointers into depths
+    A[0] += A[1];
+    root = 0;
+    leaf = 2;
+    for (next=1; next<n-1; next++) {
+        if (leaf >= n || A[root] < A[leaf]) {
+            A[next] = A[root];
+            A[root++] = next;
+        } else {
+            A[next] = A[leaf++];
+        }
+        if (leaf >= n || (root < next && A[root] < A[leaf])) {
+            A[next] += A[root];
+            A[root++] = next;
+        } else {
+            A[next] += A[leaf++];
+        }
+    }
+    A[n-2] = 0;
+    for (next=n-3; next>=0; next--) {
+        A[next] = A[A[next]] + 1;
+    }
+    avbl = 1;
+    used = dpth = 0;
+    root = n-2;
+    next = n-1;
+    while (avbl > 0) {
+        while (root >= 0 && (int)A[root] == dpth) {
+            used++;
+            root--;
+        }
+        while (avbl > used) {
+            A[next--] = dpth;
+            avbl--;
+        }
+        avbl = 2 * used;
+        dpth++;
+        used = 0;
+    }
+    // A[] now has the code lengths, longest first
+    memset(count, 0, sizeof(count));
+    for (i=0; i<n; i++) {
+        count[(A[i] > (uint32_t)iMaxLen) ? iMaxLen : A[i]]++;
+    }
+    for (total=0, i=1; i<=iMaxLen; i++) {
+        total += count[i] << (iMaxLen - i);
+    }
+    while (total != (1U << iMaxLen)) { // too long codes were cut; fix the Kraft sum
+        count[iMaxLen]--;
+        for (i=iMaxLen-1; i>0; i--) {
+            if (count[i]) {
+                count[i]--;
+                count[i+1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+    for (j=n, i=1; i<=iMaxLen; i++) { // the most frequent symbols get the shortest codes
+        for (u32=count[i]; u32>0; u32--) {
+            pLens[pSort[--j] & 511] = (uint8_t)i;
+        }
+    }
+    zt_huff_codes(pLens, iCount, pCodes);
+} /* zt_huff_build() */
+//
+// Prepare the compressor state in the caller's work buffer
+// Returns NULL if the buffer is too small
+//
+static zt_deflate_state *zt_deflate_init(uint8_t *pWork, size_t iWorkSize, int iLevel)
+{
+    zt_deflate_state *s;
+    uint8_t *p;
+    int i, j, iHashBits, iSymMax;
+    uint32_t u32Window;
+
+    if (pWork == NULL || zt_deflate_layout(iLevel, iWorkSize, &iHashBits, &u32Window, &iSymMax) == 0) {
+        return NULL;
+    }
+    p = (uint8_t *)(((uintptr_t)pWork + 7) & ~(uintptr_t)7);
+    s = (zt_deflate_state *)p;
+    memset(s, 0, sizeof(zt_deflate_state));
+    p += sizeof(zt_deflate_state);
+    s->iLevel = iLevel;
+    s->pSyms = (uint32_t *)p;
+    s->iSymMax = iSymMax;
+    p += iSymMax * sizeof(uint32_t);
+    s->iHashBits = iHashBits;
+    if (iHashBits) {
+        s->pHead = (uint16_t *)p;
+        memset(p, 0, sizeof(uint16_t) << iHashBits);
+        p += sizeof(uint16_t) << iHashBits;
+    }
+    s->u32WindowMask = ZT_MAX_WINDOW - 1;
+    if (u32Window) { // hash chains
+        s->pPrev = (uint16_t *)p;
+        memset(p, 0, u32Window * sizeof(uint16_t));
+        s->u32WindowMask = u32Window - 1;
+    }
+    for (i=0; i<28; i++) { // length and distance code lookup
+        for (j=0; j<(1 << zt_len_extra[i]); j++) {
+            s->u8LenCode[zt_len_base[i] - 3 + j] = (uint8_t)i;
+        }
+    }
+    s->u8LenCode[258-3] = 28;
+    for (i=0; i<30; i++) {
+        for (j=0; j<(1 << zt_dist_extra[i]); j++) {
+            if (zt_dist_base[i] + j <= 256) {
+                s->u8DistCode[zt_dist_base[i] + j - 1] = (uint8_t)i;
+            } else {
+                s->u8DistCode[256 + ((zt_dist_base[i] + j - 1) >> 7)] = (uint8_t)i;
+            }
+        }
+    }
+    memset(s->u8FixedLitLen, 8, 144); // fixed Huffman codes (block type 01)
+    memset(&s->u8FixedLitLen[144], 9, 112);
+    memset(&s->u8FixedLitLen[256], 7, 24);
+    memset(&s->u8FixedLitLen[280], 8, 8);
+    memset(s->u8FixedDistLen, 5, 30);
+    zt_huff_codes(s->u8FixedLitLen, 288, s->u16FixedLitCode);
+    zt_huff_codes(s->u8FixedDistLen, 30, s->u16FixedDistCode);
+    return s;
+} /* zt_deflate_init() */
+//
+// Distance code of a match distance; the first 256 distances have their own
+// entries, the rest share one for every 128 distances
+//
+static inline int zt_dist_code(zt_deflate_state *s, uint32_t u32Dist)
+{
+    return (u32Dist <= 256) ? s->u8DistCode[u32Dist - 1] : s->u8DistCode[256 + ((u32Dist - 1) >> 7)];
+} /* zt_dist_code() */
+//
+// Add a literal or a match to the current block
+//
+static inline void zt_emit_literal(zt_deflate_state *s, uint8_t u8)
+{
+    s->pSyms[s->iSymCount++] = u8;
+    s->u32LitFreq[u8]++;
+    s->iBlockLen++;
+} /* zt_emit_literal() */
+static inline void zt_emit_match(zt_deflate_state *s, uint32_t u32Len, uint32_t u32Dist)
+{
+    s->pSyms[s->iSymCount++] = u32Len | (u32Dist << 16);
+    s->u32LitFreq[257 + s->u8LenCode[u32Len - 3]]++;
+    s->u32DistFreq[zt_dist_code(s, u32Dist)]++;
+    s->iBlockLen += u32Len;
+} /* zt_emit_match() */
+//
+// Size in bits of the current block's symbols with a given set of codes
+//
+static size_t zt_block_bits(zt_deflate_state *s, const uint8_t *pLitLen, const uint8_t *pDistLen)
+{
+    size_t iBits = 0;
+    int i;
+
+    for (i=0; i<286; i++) {
+        iBits += (size_t)s->u32LitFreq[i] * pLitLen[i];
+    }
+    for (i=0; i<29; i++) {
+        iBits += (size_t)s->u32LitFreq[257+i] * zt_len_extra[i];
+    }
+    for (i=0; i<30; i++) {
+        iBits += (size_t)s->u32DistFreq[i] * (pDistLen[i] + zt_dist_extra[i]);
+    }
+    return iBits;
+} /* zt_block_bits() */
+//
+// Run length code the literal/length and distance code lengths for a
+// dynamic block header (codes 16-18) and count the code length codes.
+// Returns the number of bytes in u8Rle (code, extra bits pairs)
+//
+static int zt_rle_lengths(zt_deflate_state *s, int iLit, int iDist)
+{
+    uint8_t lens[286+30], *pRle = s->u8Rle, v;
+    int i, j, n, iRun, iLeft;
+
+    memcpy(lens, s->u8LitLen, iLit);
+    memcpy(&lens[iLit], s->u8DistLen, iDist);
+    n = iLit + iDist;
+    for (i=0, j=0; i<n; i += iRun) {
+        v = lens[i];
+        for (iRun=1; i+iRun < n && lens[i+iRun] == v; iRun++) {};
+        iLeft = iRun;
+        if (v == 0) {
+            while (iLeft >= 11) { // 11-138 zeros
+                pRle[j++] = 18;
+                pRle[j++] = (uint8_t)(((iLeft > 138) ? 138 : iLeft) - 11);
+                iLeft -= pRle[j-1] + 11;
+            }
+            if (iLeft >= 3) { // 3-10 zeros
+                pRle[j++] = 17;
+                pRle[j++] = (uint8_t)(iLeft - 3);
+                iLeft = 0;
+            }
+        } else {
+            pRle[j++] = v;
+            pRle[j++] = 0;
+            iLeft--;
+            while (iLeft >= 3) { // repeat the previous length 3-6 times
+                pRle[j++] = 16;
+                pRle[j++] = (uint8_t)(((iLeft > 6) ? 6 : iLeft) - 3);
+                iLeft -= pRle[j-1] + 3;
+            }
+        }
+        while (iLeft--) {
+            pRle[j++] = v;
+            pRle[j++] = 0;
+        }
+    }
+    memset(s->u32CodeFreq, 0, sizeof(s->u32CodeFreq));
+    for (i=0; i<j; i += 2) {
+        s->u32CodeFreq[pRle[i]]++;
+    }
+    return j;
+} /* zt_rle_lengths() */
+//
+// Write the buffered symbols as one block, using whichever of dynamic
+// Huffman, fixed Huffman or stored coding is the smallest. A block which
+// won't fit in the output buffer isn't written at all.
+//
+static int zt_deflate_block(zt_deflate_state *s, int bLast)
+{
+    BIGUINT ulBits = s->ulBits, ulBitCount = s->ulBitCount;
+    uint8_t *pOut = s->pOut;
+    const uint8_t *pLitLen, *pDistLen, *pData;
+    const uint16_t *pLitCode, *pDistCode;
+    static const uint8_t rle_extra[3] = {2, 3, 7};
+    size_t iDynamic, iFixed, iStored, iAvail, iLen, iPieces;
+    uint32_t u32, *pSyms = s->pSyms;
+    int i, j, iLit = 257, iDist = 1, iCodes = 4, iRle = 0;
+
+    iDynamic = iFixed = (size_t)-1;
+    if (s->iLevel) {
+        s->u32LitFreq[256] = 1; // end of block
+        zt_huff_build(s, s->u32LitFreq, 286, MAXBITS, s->u8LitLen, s->u16LitCode);
+        zt_huff_build(s, s->u32DistFreq, 30, MAXBITS, s->u8DistLen, s->u16DistCode);
+        for (iLit = 286; iLit > 257 && s->u8LitLen[iLit-1] == 0; iLit--) {};
+        for (iDist = 30; iDist > 1 && s->u8DistLen[iDist-1] == 0; iDist--) {};
+        iRle = zt_rle_lengths(s, iLit, iDist);
+        zt_huff_build(s, s->u32CodeFreq, 19, 7, s->u8CodeLen, s->u16CodeCode);
+        for (iCodes = 19; iCodes > 4 && s->u8CodeLen[len_order[iCodes-1]] == 0; iCodes--) {};
+        iDynamic = 3 + 14 + 3*iCodes + zt_block_bits(s, s->u8LitLen, s->u8DistLen);
+        for (i=0; i<19; i++) {
+            iDynamic += (size_t)s->u32CodeFreq[i] * (s->u8CodeLen[i] + ((i >= 16) ? rle_extra[i-16] : 0));
+        }
+        iFixed = 3 + zt_block_bits(s, s->u8FixedLitLen, s->u8FixedDistLen);
+    }
+    iLen = s->iBlockLen; // stored blocks hold up to 65535 bytes each
+    iPieces = (iLen) ? (iLen + 65534) / 65535 : 1;
+    iStored = ((8 - ((ulBitCount + 3) & 7)) & 7) + iPieces * 35 + (iPieces - 1) * 5 + iLen * 8;
+    iAvail = (size_t)(s->pOutEnd - pOut) * 8 - ulBitCount;
+    if (iStored <= iDynamic && iStored <= iFixed) {
+        if (iStored > iAvail) return ZT_OUTPUT_INSUFFICIENT;
+        pData = &s->pIn[s->iBlockStart];
+        do {
+            i = (int)((iLen > 65535) ? 65535 : iLen);
+            iLen -= i;
+            PUTBITS((bLast && iLen == 0), 3)
+            PUTBITS(0, (8 - (ulBitCount & 7)) & 7) // skip to a byte boundary
+            while (ulBitCount) {
+                *pOut++ = (uint8_t)ulBits;
+                ulBits >>= 8;
+                ulBitCount -= 8;
+            }
+            pOut[0] = (uint8_t)i; pOut[1] = (uint8_t)(i >> 8);
+            pOut[2] = (uint8_t)~i; pOut[3] = (uint8_t)(~i >> 8);
+            if (i) memcpy(&pOut[4], pData, i);
+            pOut += 4 + i;
+            pData += i;
+        } while (iLen);
+    } else {
+        if (((iDynamic < iFixed) ? iDynamic : iFixed) > iAvail) return ZT_OUTPUT_INSUFFICIENT;
+        if (iDynamic < iFixed) {
+            pLitLen = s->u8LitLen; pLitCode = s->u16LitCode;
+            pDistLen = s->u8DistLen; pDistCode = s->u16DistCode;
+            PUTBITS(bLast | (2 << 1), 3)
+            PUTBITS(iLit - 257, 5)
+            PUTBITS(iDist - 1, 5)
+            PUTBITS(iCodes - 4, 4)
+            for (i=0; i<iCodes; i++) {
+                PUTBITS(s->u8CodeLen[len_order[i]], 3)
+            }
+            for (i=0; i<iRle; i += 2) {
+                j = s->u8Rle[i];
+                PUTBITS(s->u16CodeCode[j], s->u8CodeLen[j])
+                if (j >= 16) PUTBITS(s->u8Rle[i+1], rle_extra[j-16])
+            }
+        } else {
+            pLitLen = s->u8FixedLitLen; pLitCode = s->u16FixedLitCode;
+            pDistLen = s->u8FixedDistLen; pDistCode = s->u16FixedDistCode;
+            PUTBITS(bLast | (1 << 1), 3)
+        }
+        for (i=0; i<s->iSymCount; i++) {
+            u32 = pSyms[i];
+            if (u32 < 256) { // literal
+                PUTBITS(pLitCode[u32], pLitLen[u32])
+            } else {
+                j = s->u8LenCode[(u32 & 0xffff) - 3];
+                PUTBITS2(pLitCode[257+j], pLitLen[257+j], (u32 & 0xffff) - zt_len_base[j], zt_len_extra[j])
+                u32 >>= 16;
+                j = zt_dist_code(s, u32);
+                PUTBITS2(pDistCode[j], pDistLen[j], u32 - zt_dist_base[j], zt_dist_extra[j])
+            }
+        }
+        PUTBITS(pLitCode[256], pLitLen[256])
+    }
+    s->ulBits = ulBits;
+    s->ulBitCount = ulBitCount;
+    s->pOut = pOut;
+    s->iBlockStart += s->iBlockLen;
+    s->iBlockLen = 0;
+    s->iSymCount = 0;
+    memset(s->u32LitFreq, 0, sizeof(s->u32LitFreq));
+    memset(s->u32DistFreq, 0, sizeof(s->u32DistFreq));
+    return ZT_SUCCESS;
+} /* zt_deflate_block() */
+//
+// Count the matching bytes at p and q, up to u32Max
+//
+static inline uint32_t zt_match_len(const uint8_t *p, const uint8_t *q, uint32_t u32Max)
+{
+    uint32_t u32Len = 0;
+#if defined(ALLOWS_UNALIGNED) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t u64;
+
+    while (u32Len + 8 <= u32Max) { // compare 8 bytes at a time
+        u64 = *(uint64_t *)&p[u32Len] ^ *(uint64_t *)&q[u32Len];
+        if (u64) return u32Len + (__builtin_ctzll(u64) >> 3);
+        u32Len += 8;
+    }
 #endif
+    while (u32Len < u32Max && p[u32Len] == q[u32Len]) {
+        u32Len++;
+    }
+    return u32Len;
+} /* zt_match_len() */
+#define ZT_HASH(u32) (((u32) * 0x9e3779b1) >> iShift)
+//
+// Level 1: check a single earlier position with the same hash as the next
+// 4 bytes and take any match found there (greedy parsing)
+//
+static int zt_deflate_fast(zt_deflate_state *s)
+{
+    const uint8_t *pIn = s->pIn;
+    uint16_t *pHead = s->pHead;
+    size_t iPos = 0, iEnd = s->iInSize, iLimit = (iEnd > 3) ? iEnd - 3 : 0;
+    uint32_t u32, h, u32Dist, u32Len;
+    int iShift = 32 - s->iHashBits, rc;
+
+    while (iPos < iEnd) {
+        if (s->iSymCount >= s->iSymMax) {
+            rc = zt_deflate_block(s, 0);
+            if (rc != ZT_SUCCESS) return rc;
+        }
+        if (iPos < iLimit) {
+            u32 = LOAD32(&pIn[iPos]);
+            h = ZT_HASH(u32);
+            u32Dist = (uint16_t)(iPos - pHead[h]);
+            pHead[h] = (uint16_t)iPos;
+            if (u32Dist - 1 < ZT_MAX_WINDOW && u32Dist <= iPos && LOAD32(&pIn[iPos - u32Dist]) == u32) {
+                u32Len = (iEnd - iPos > 258) ? 258 : (uint32_t)(iEnd - iPos);
+                u32Len = 4 + zt_match_len(&pIn[iPos + 4], &pIn[iPos - u32Dist + 4], u32Len - 4);
+                zt_emit_match(s, u32Len, u32Dist);
+                iPos += u32Len;
+                if (iPos - 2 < iLimit) { // hash a position near the end of the match too
+                    pHead[ZT_HASH(LOAD32(&pIn[iPos - 2]))] = (uint16_t)(iPos - 2);
+                }
+                continue;
+            }
+        }
+        zt_emit_literal(s, pIn[iPos++]);
+    }
+    return ZT_SUCCESS;
+} /* zt_deflate_fast() */
+//
+// Find the longest match for the data at iPos along its hash chain which is
+// longer than u32Best. Returns its length (0 if there isn't one)
+//
+static uint32_t zt_longest_match(zt_deflate_state *s, size_t iPos, uint32_t u32Cand, uint32_t u32Chain, uint32_t u32Nice, uint32_t u32Best, uint32_t *pu32Dist)
+{
+    const uint8_t *p = &s->pIn[iPos], *q;
+    uint32_t u32First, u32Max, u32Dist, u32Len, u32LastDist = 0, u32Found = 0;
+
+    u32Max = (s->iInSize - iPos > 258) ? 258 : (uint32_t)(s->iInSize - iPos);
+    if (u32Best >= u32Max) return 0;
+    if (u32Nice > u32Max) u32Nice = u32Max;
+    u32First = LOAD32(p);
+    for (;;) {
+        u32Dist = (uint16_t)(iPos - u32Cand);
+        // the distances must keep growing; anything else is a stale entry
+        if (u32Dist <= u32LastDist || u32Dist > s->u32WindowMask + 1 || u32Dist > iPos) break;
+        q = p - u32Dist;
+        if (q[u32Best] == p[u32Best] && LOAD32(q) == u32First) {
+            u32Len = 4 + zt_match_len(p + 4, q + 4, u32Max - 4);
+            if (u32Len > u32Best) {
+                u32Best = u32Found = u32Len;
+                *pu32Dist = u32Dist;
+                if (u32Len >= u32Nice) break;
+            }
+        }
+        if (--u32Chain == 0) break;
+        u32LastDist = u32Dist;
+        u32Cand = s->pPrev[u32Cand & s->u32WindowMask];
+    }
+    return u32Found;
+} /* zt_longest_match() */
+//
+// Levels 2-9: search the hash chains. Levels 2 and 3 take the first match
+// found (greedy); from level 4 on a match is only used if the next position
+// doesn't have a longer one (lazy matching, as zlib does).
+//
+static int zt_deflate_slow(zt_deflate_state *s)
+{
+    const zt_deflate_config *pConfig = &zt_levels[s->iLevel];
+    const uint8_t *pIn = s->pIn;
+    uint16_t *pHead = s->pHead, *pPrev = s->pPrev;
+    size_t iPos = 0, iEnd = s->iInSize, iLimit = (iEnd > 3) ? iEnd - 3 : 0, iStop;
+    uint32_t h, u32Mask = s->u32WindowMask, u32Cand, u32Len, u32Dist = 0, u32PrevLen = 0, u32PrevDist = 0;
+    int iShift = 32 - s->iHashBits, bPending = 0, rc;
+
+    while (iPos < iEnd) {
+        if (s->iSymCount + 2 > s->iSymMax) {
+            rc = zt_deflate_block(s, 0);
+            if (rc != ZT_SUCCESS) return rc;
+        }
+        u32Len = 0;
+        if (iPos < iLimit) {
+            h = ZT_HASH(LOAD32(&pIn[iPos]));
+            u32Cand = pHead[h];
+            pPrev[iPos & u32Mask] = (uint16_t)u32Cand;
+            pHead[h] = (uint16_t)iPos;
+            if (pConfig->lazy == 0) {
+                u32Len = zt_longest_match(s, iPos, u32Cand, pConfig->chain, pConfig->nice, 3, &u32Dist);
+            } else if (u32PrevLen < pConfig->lazy) {
+                u32Len = zt_longest_match(s, iPos, u32Cand, (u32PrevLen >= pConfig->good) ? pConfig->chain >> 2 : pConfig->chain,
+                                          pConfig->nice, (u32PrevLen > 3) ? u32PrevLen : 3, &u32Dist);
+            }
+        }
+        if (pConfig->lazy == 0) { // greedy
+            if (u32Len) {
+                zt_emit_match(s, u32Len, u32Dist);
+                for (iStop = iPos + u32Len, iPos++; iPos < iStop; iPos++) {
+                    if (iPos < iLimit) {
+                        h = ZT_HASH(LOAD32(&pIn[iPos]));
+                        pPrev[iPos & u32Mask] = pHead[h];
+                        pHead[h] = (uint16_t)iPos;
+                    }
+                }
+            } else {
+                zt_emit_literal(s, pIn[iPos++]);
+            }
+        } else if (u32PrevLen && u32Len <= u32PrevLen) {
+            // the match which starts at the previous byte is at least as long
+            zt_emit_match(s, u32PrevLen, u32PrevDist);
+            for (iStop = iPos - 1 + u32PrevLen, iPos++; iPos < iStop; iPos++) {
+                if (iPos < iLimit) {
+                    h = ZT_HASH(LOAD32(&pIn[iPos]));
+                    pPrev[iPos & u32Mask] = pHead[h];
+                    pHead[h] = (uint16_t)iPos;
+                }
+            }
+            bPending = 0;
+            u32PrevLen = 0;
+        } else {
+            if (bPending) zt_emit_literal(s, pIn[iPos-1]);
+            bPending = 1;
+            u32PrevLen = u32Len;
+            u32PrevDist = u32Dist;
+            iPos++;
+        }
+    }
+    if (bPending) zt_emit_literal(s, pIn[iPos-1]);
+    return ZT_SUCCESS;
+} /* zt_deflate_slow() */
+//
+// Bytes of work memory needed by zt_deflate() for the default table sizes.
+// Less can be given to it (down to about 16K); the hash table, window and
+// block size are then reduced to fit, which costs some compression.
+//
+size_t zt_deflate_work_size(int iLevel)
+{
+    int iHashBits, iSymMax;
+    uint32_t u32Window;
+
+    if (iLevel < 0 || iLevel > 9) return 0;
+    return zt_deflate_layout(iLevel, 0, &iHashBits, &u32Window, &iSymMax);
+} /* zt_deflate_work_size() */
+//
+// Largest possible compressed size of iInSize bytes, including the zlib or
+// gzip header and trailer
+//
+size_t zt_deflate_bound(size_t iInSize, int iFormat)
+{
+    size_t iSize = iInSize + (iInSize >> 8) + 16; // stored blocks for incompressible data
+    if (iFormat == ZT_FORMAT_ZLIB) iSize += 6;
+    else if (iFormat == ZT_FORMAT_GZIP) iSize += 18;
+    return iSize;
+} /* zt_deflate_bound() */
+//
+// Compress data in one shot as raw deflate, zlib or gzip (iFormat).
+// iLevel goes from 0 (stored) and 1 (fastest) to 9 (smallest output).
+// pWork is the compressor's working memory (see zt_deflate_work_size);
+// nothing is allocated. Returns ZT_OUTPUT_INSUFFICIENT if the output doesn't
+// fit in iOutSize bytes (zt_deflate_bound() bytes are always enough).
+//
+int zt_deflate(uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, uint8_t *pWork, size_t iWorkSize, int iLevel, int iFormat)
+{
+    zt_deflate_state *s;
+    uint8_t *d;
+    uint32_t u32Check;
+    size_t i;
+    int rc, iWindowBits;
+
+    if (piOutSize) *piOutSize = 0;
+    if (iLevel < 0 || iLevel > 9 || iFormat < ZT_FORMAT_RAW || iFormat > ZT_FORMAT_GZIP || pOut == NULL || (pIn == NULL && iInSize)) {
+        return ZT_INVALID_PARAMETER;
+    }
+    s = zt_deflate_init(pWork, iWorkSize, iLevel);
+    if (s == NULL) return ZT_INVALID_PARAMETER;
+    d = pOut;
+    if (iFormat == ZT_FORMAT_GZIP) {
+        if (iOutSize < 10) return ZT_OUTPUT_INSUFFICIENT;
+        d[0] = 0x1f; d[1] = 0x8b; d[2] = 8; // deflate
+        memset(&d[3], 0, 5); // no flags or time stamp
+        d[8] = (iLevel == 9) ? 2 : ((iLevel == 1) ? 4 : 0); // XFL
+        d[9] = 255; // unknown OS
+        d += 10;
+    } else if (iFormat == ZT_FORMAT_ZLIB) {
+        if (iOutSize < 2) return ZT_OUTPUT_INSUFFICIENT;
+        for (iWindowBits = 15; iWindowBits > 8 && (1U << iWindowBits) > s->u32WindowMask + 1; iWindowBits--) {};
+        d[0] = (uint8_t)(8 | ((iWindowBits - 8) << 4));
+        d[1] = (uint8_t)(((iLevel < 2) ? 0 : ((iLevel < 6) ? 1 : ((iLevel == 6) ? 2 : 3))) << 6);
+        d[1] |= 31 - ((d[0] << 8) | d[1]) % 31; // FCHECK
+        d += 2;
+    }
+    s->pIn = pIn;
+    s->iInSize = iInSize;
+    s->pOut = d;
+    s->pOutEnd = &pOut[iOutSize];
+    rc = ZT_SUCCESS;
+    if (iLevel == 0) {
+        s->iBlockLen = iInSize;
+    } else if (iLevel == 1) {
+        rc = zt_deflate_fast(s);
+    } else {
+        rc = zt_deflate_slow(s);
+    }
+    if (rc == ZT_SUCCESS) rc = zt_deflate_block(s, 1);
+    if (rc != ZT_SUCCESS) return rc;
+    d = s->pOut;
+    while (s->ulBitCount) { // the last partial byte (the block size check made room for it)
+        *d++ = (uint8_t)s->ulBits;
+        s->ulBits >>= 8;
+        s->ulBitCount = (s->ulBitCount > 8) ? s->ulBitCount - 8 : 0;
+    }
+    if (iFormat != ZT_FORMAT_RAW) {
+        if ((size_t)(&pOut[iOutSize] - d) < ((iFormat == ZT_FORMAT_GZIP) ? 8U : 4U)) return ZT_OUTPUT_INSUFFICIENT;
+        u32Check = (iFormat == ZT_FORMAT_GZIP) ? 0 : 1;
+        for (i = 0; i < iInSize; i += 0x40000000) { // the checksum functions take an int length
+            rc = (int)((iInSize - i > 0x40000000) ? 0x40000000 : iInSize - i);
+            u32Check = (iFormat == ZT_FORMAT_GZIP) ? zt_crc32(u32Check, &pIn[i], rc) : zt_adler32(u32Check, &pIn[i], rc);
+        }
+        if (iFormat == ZT_FORMAT_GZIP) {
+            d = zt_put_le(d, u32Check, 4);
+            d = zt_put_le(d, (uint32_t)iInSize, 4);
+        } else { // Adler-32 is big-endian
+            d[0] = (uint8_t)(u32Check >> 24); d[1] = (uint8_t)(u32Check >> 16);
+            d[2] = (uint8_t)(u32Check >> 8); d[3] = (uint8_t)u32Check;
+            d += 4;
+        }
+    }
+    if (piOutSize) *piOutSize = (size_t)(d - pOut);
+    return ZT_SUCCESS;
+} /* zt_deflate() */
+
+#ifdef ZT_THREADS
+//
+// Parallel decoding of a single deflate stream
+//
+// The compressed data is split into chunks of ZT_PARALLEL_CHUNK bytes. Each
+// chunk (after the first) is searched for something which looks like the
+// start of a block and decoded from there before the data which precedes it
+// is known. A match which reaches back before the start of the chunk can't
+// be copied yet, so the output is kept as 16-bit symbols; 0-255 are bytes and
+// 256 + n refers to byte n of the 32K window which precedes the chunk. As soon
+// as the last 32K symbols are all bytes, nothing later can refer to the window
+// and the rest of the chunk is decoded into bytes by zt_inflate(). Once all of
+// the chunks are decoded, they're checked to follow on from each other (a
+// chunk which started in the wrong place is decoded again from where the
+// previous one ended) and the window references are filled in.
+//
+typedef struct zt_chunk_tag {
+    uint64_t u64Start;      /* bit offset of the first block */
+    uint64_t u64End;        /* bit offset just past the last block */
+    uint16_t *pSymbols;     /* decoded bytes (0-255) and window references (256+) */
+    size_t iLen;            /* number of symbols */
+    size_t iMax;            /* allocated size of pSymbols */
+    uint8_t *pBytes;        /* the output which follows the symbols (after a 32K window) */
+    size_t iBytes;          /* number of bytes */
+    size_t iWindow;         /* size of the window at the start of pBytes */
+    size_t iOutOffset;      /* offset of the chunk's data in the output */
+    uint8_t bStored;        /* the first block is a stored block */
+    uint8_t bLast;          /* the final block is in this chunk */
+    int iResult;
+} zt_chunk;
+
+typedef struct zt_parallel_tag {
+    uint8_t *pData;         /* the deflate data */
+    size_t iSize;
+    uint8_t *pOut;
+    size_t iOutSize;
+    zt_chunk *pChunks;
+    int iChunkCount;
+    std::atomic<int> iNext; /* next chunk to work on */
+} zt_parallel;
+//
+// Make room for at least iNeed more symbols after pOut
+//
+static int zt_chunk_grow(zt_chunk *pChunk, uint16_t **ppOut, uint16_t **ppOutEnd, size_t iNeed, size_t iLimit)
+{
+    size_t iLen = (size_t)(*ppOut - pChunk->pSymbols);
+    size_t iMax = pChunk->iMax * 2;
+    uint16_t *pNew;
+
+    if (iLen > iLimit) {
+        return ZT_OUTPUT_INSUFFICIENT; // more than the whole output can hold
+    }
+    if (iMax < iLen + iNeed) iMax = iLen + iNeed;
+    if (iMax < 65536) iMax = 65536;
+    pNew = (uint16_t *)realloc(pChunk->pSymbols, iMax * sizeof(uint16_t));
+    if (pNew == NULL) {
+        return ZT_INVALID_PARAMETER; // out of memory
+    }
+    pChunk->pSymbols = pNew;
+    pChunk->iMax = iMax;
+    *ppOut = &pNew[iLen];
+    *ppOutEnd = &pNew[iMax];
+    return ZT_SUCCESS;
+} /* zt_chunk_grow() */
+//
+// Check that a window's worth of symbols has no references to the window
+// which precedes the chunk
+//
+static int zt_no_refs(uint16_t *pSymbols)
+{
+    unsigned u = 0;
+    int i;
+
+    for (i=0; i<ZT_MAX_WINDOW; i++) {
+        u |= pSymbols[i];
+    }
+    return (u < 256);
+} /* zt_no_refs() */
+//
+// Decode the rest of a chunk (from bit offset u64Pos) into bytes. The last
+// 32K symbols go in front of it as the window, so zt_inflate() can decode
+// it like any other data which is all in memory.
+//
+static int zt_decode_bytes(zt_state *state, zt_chunk *pChunk, uint8_t *pData, size_t iSize, uint64_t u64Pos, uint64_t u64Stop, size_t iLimit)
+{
+    zt_buffer buffer;
+    uint8_t *pNew;
+    size_t i, iMax, iLeft;
+    int rc, bEnd;
+
+    pChunk->iWindow = (pChunk->iLen > ZT_MAX_WINDOW) ? ZT_MAX_WINDOW : pChunk->iLen;
+    iMax = pChunk->iWindow + ((iLimit < 4 * ZT_PARALLEL_CHUNK) ? iLimit : 4 * ZT_PARALLEL_CHUNK) + 1024;
+    pNew = (uint8_t *)realloc(pChunk->pBytes, iMax);
+    if (pNew == NULL) {
+        return ZT_INVALID_PARAMETER; // out of memory
+    }
+    pChunk->pBytes = pNew;
+    for (i=0; i<pChunk->iWindow; i++) {
+        pNew[i] = (uint8_t)pChunk->pSymbols[pChunk->iLen - pChunk->iWindow + i];
+    }
+    zt_init(state);
+    state->wbits = 15; // no zlib header
+    state->bBlockStop = 1;
+    state->ulBits = pData[u64Pos >> 3] >> (u64Pos & 7);
+    state->ulBitCount = 8 - (u64Pos & 7);
+    buffer.next_in = &pData[(u64Pos >> 3) + 1];
+    buffer.total_in = 0;
+    buffer.total_out = (uint32_t)pChunk->iWindow;
+    for (;;) {
+        iLeft = (size_t)(&pData[iSize] - buffer.next_in);
+        buffer.avail_in = (iLeft > 0x40000000) ? 0x40000000 : (uint32_t)iLeft;
+        bEnd = (buffer.avail_in == iLeft);
+        buffer.next_out = &pChunk->pBytes[buffer.total_out];
+        buffer.avail_out = (uint32_t)(iMax - buffer.total_out);
+        rc = zt_inflate(state, &buffer, bEnd);
+        u64Pos = (uint64_t)(buffer.next_in - pData) * 8 - state->ulBitCount;
+        if (rc == ZT_BLOCK_END) {
+            if (u64Pos < u64Stop) continue;
+            rc = ZT_SUCCESS;
+        } else if (rc == ZT_SUCCESS) { // that was the final block
+            pChunk->bLast = 1;
+        } else if (rc == ZT_OUTPUT_INSUFFICIENT) {
+            if (buffer.total_out - pChunk->iWindow > iLimit || iMax >= 0x40000000) {
+                break; // more than the output can hold
+            }
+            iMax *= 2;
+            pNew = (uint8_t *)realloc(pChunk->pBytes, iMax);
+            if (pNew == NULL) {
+                rc = ZT_INVALID_PARAMETER;
+                break;
+            }
+            pChunk->pBytes = pNew;
+            continue;
+        } else if (rc == ZT_INPUT_INSUFFICIENT && !bEnd) {
+            continue;
+        }
+        break;
+    }
+    pChunk->iBytes = buffer.total_out - pChunk->iWindow;
+    pChunk->u64End = u64Pos;
+    return rc;
+} /* zt_decode_bytes() */
+//
+// Decode blocks into 16-bit symbols from bit offset u64Start until the
+// first block boundary at or after u64Stop (or the end of the final block).
+// bWindow is false when decoding from the start of the stream; there is
+// no earlier data to refer to.
+//
+static int zt_decode_chunk(zt_state *state, zt_chunk *pChunk, uint8_t *pData, size_t iSize, uint64_t u64Start, uint64_t u64Stop, int bWindow, size_t iLimit)
+{
+    BIGUINT ulBits, ulBitCount, lmask, dmask;
+    uint8_t *pBuf, *pInEnd, *pFastInEnd, *s;
+    uint16_t *pOut, *pOutEnd, *from;
+    code here;
+    code const *lcode;
+    code const *dcode;
+    unsigned op, len, dist;
+    size_t iHave;
+    int ret, bLast = 0, iBlocks = 0;
+
+    pChunk->u64Start = u64Start;
+    pChunk->iLen = 0;
+    pChunk->iBytes = 0;
+    pChunk->iWindow = 0;
+    pChunk->bLast = 0;
+    pOut = pChunk->pSymbols;
+    pOutEnd = pOut + pChunk->iMax;
+    pInEnd = &pData[iSize];
+    pFastInEnd = (iSize > FAST_INPUT_MARGIN) ? pInEnd - FAST_INPUT_MARGIN : pData;
+    pBuf = &pData[u64Start >> 3];
+    ulBits = ulBitCount = 0;
+    GETMOREBITS_SAFE
+    op = (unsigned)(u64Start & 7);
+    DROPBITS(op);
+    ret = ZT_SUCCESS;
+    while (!bLast && (iBlocks == 0 || (uint64_t)(pBuf - pData) * 8 - ulBitCount < u64Stop)) {
+        iHave = (size_t)(pOut - pChunk->pSymbols);
+        if (!bWindow || (iHave >= ZT_MAX_WINDOW && zt_no_refs(pOut - ZT_MAX_WINDOW))) {
+            // nothing from here on can refer to the unknown window
+            pChunk->iLen = iHave;
+            return zt_decode_bytes(state, pChunk, pData, iSize, (uint64_t)(pBuf - pData) * 8 - ulBitCount, u64Stop, iLimit);
+        }
+        iBlocks++;
+        if (ulBitCount < REGISTER_WIDTH/2) {
+            GETMOREBITS_SAFE
+        }
+        bLast = BITS(1);
+        DROPBITS(1);
+        op = BITS(2);
+        DROPBITS(2);
+        if (op == 0) { // stored; copy it straight from the input
+            op = (unsigned)(ulBitCount & 7);
+            DROPBITS(op);
+            s = pBuf - (ulBitCount >> 3);
+            if (pInEnd - s < 4 || (s[0] ^ s[2]) != 0xff || (s[1] ^ s[3]) != 0xff) { // NLEN = ~LEN
+                ret = ZT_DECODE_ERROR;
+                break;
+            }
+            len = s[0] | (s[1] << 8);
+            s += 4;
+            if ((size_t)(pInEnd - s) < len) {
+                ret = ZT_DECODE_ERROR;
+                break;
+            }
+            if ((size_t)(pOutEnd - pOut) < len && (ret = zt_chunk_grow(pChunk, &pOut, &pOutEnd, len, iLimit)) != ZT_SUCCESS) {
+                break;
+            }
+            while (len--) {
+                *pOut++ = *s++;
+            }
+            pBuf = s;
+            ulBits = ulBitCount = 0;
+            continue;
+        } else if (op == 1) { // fixed Huffman table
+            state->lencode = lenfix;
+            state->lenbits = 9;
+            state->distcode = distfix;
+            state->distbits = 5;
+        } else if (op == 2) { // dynamic Huffman table
+            if (zt_dynamic_tables(state, &ulBits, &ulBitCount, &pBuf, pInEnd, 1) != ZT_SUCCESS) {
+                ret = ZT_DECODE_ERROR;
+                break;
+            }
+        } else { // reserved
+            ret = ZT_DECODE_ERROR;
+            break;
+        }
+        lmask = (1U << state->lenbits) - 1;
+        dmask = (1U << state->distbits) - 1;
+        lcode = state->lencode;
+        dcode = state->distcode;
+        for (;;) { // decode the symbols of the block
+            if (pBuf < pFastInEnd) {
+                GETMOREBITS_FAST
+            } else if (ulBitCount < REGISTER_WIDTH/2) {
+                GETMOREBITS_SAFE
+                if (pBuf > pInEnd && (BIGUINT)(pBuf - pInEnd) * 8 > ulBitCount) { // ran past the end
+                    ret = ZT_DECODE_ERROR;
+                    break;
+                }
+            }
+            if (pOutEnd - pOut < 258 + 8 && (ret = zt_chunk_grow(pChunk, &pOut, &pOutEnd, 258 + 8, iLimit)) != ZT_SUCCESS) {
+                break;
+            }
+            here = lcode[ulBits & lmask];
+        chunk_length:
+            DROPBITS(here.bits);
+            op = (unsigned)(here.op);
+            if ((op & 0x7f) == 0) {                 /* 1 or 2 literals */
+                // writing both covers either case (see zt_pack_literals)
+                pOut[0] = here.val & 0xff;
+                pOut[1] = here.val >> 8;
+                pOut += 1 + (op >> 7);
+#if REGISTER_WIDTH == 64
+                // after a refill there are enough bits for 2 more literal entries
+                if (pOut < pOutEnd - 258) {
                     here = lcode[ulBits & lmask];
-                get_length:
-                    if (ulBitCount <= REGISTER_WIDTH/2) {
-                        GETMOREBITS
-                    }
-                    DROPBITS(here.bits);
-                    op = (unsigned)(here.op);
-                    if (op == 0) {                          /* literal */
-                       // Tracevv((stderr, here->val >= 0x20 && here->val < 0x7f ?
-                       //         "inflate:         literal '%c'\n" :
-                       //         "inflate:         literal 0x%02x\n", here->val));
-                        *pOut++ = (unsigned char)(here.val);
+                    if ((here.op & 0x7f) == 0 && here.bits <= ulBitCount) {
+                        DROPBITS(here.bits);
+                        pOut[0] = here.val & 0xff;
+                        pOut[1] = here.val >> 8;
+                        pOut += 1 + (here.op >> 7);
                     }
-                    else if (op & 16) {                     /* length base */
-                        len = (unsigned)(here.val);
-                        op &= 15;                           /* number of extra bits */
-                        len += (unsigned)BITS(op);
-                        DROPBITS(op);
-                        //Tracevv((stderr, "inflate:         length %u\n", len));
-#if REGISTER_WIDTH == 32 // this check isn't needed on 64-bit machines
-                        if (ulBitCount <= REGISTER_WIDTH/2) {
-                            GETMOREBITS
-                        }
+                }
 #endif
-                    here = dcode[ulBits & dmask];
-                get_distance:
-                    if (ulBitCount <= REGISTER_WIDTH/2) {
-                        GETMOREBITS
-                    }
-                    DROPBITS(here.bits);
-                    op = (unsigned)(here.op);
-                    if (op & 16) {                      /* distance base */
-                        uint8_t *pEnd;
-                        unsigned overlap;
-                        dist = (unsigned)(here.val);
-                        op &= 15;                       /* number of extra bits */
-#if REGISTER_WIDTH == 32 // this check isn't needed on 64-bit machines
-                        if (ulBitCount <= REGISTER_WIDTH/2) {
-                            GETMOREBITS
-                        }
+            }
+            else if (op & 16) {                     /* length base */
+                len = (unsigned)(here.val);
+                op &= 15;                           /* number of extra bits */
+#if REGISTER_WIDTH == 32
+                if (ulBitCount < REGISTER_WIDTH/2) {
+                    GETMOREBITS_SAFE
+                }
 #endif
-                        dist += BITS(op);
-                        DROPBITS(op);
-                        from = pOut - dist;
-                        pEnd = pOut+len;
-                        overlap = (unsigned)(pOut-from);
-                        // Check for a repeating pattern (source overlapping destination). This optimization can speed up
-                        // decompression because we're only writing data instead of reading, then writing.
-                        // For 1-byte patterns we create a register-sized set of bytes to blast them out faster
-                        // for 2-8 byte patterns, we just write the pattern and increment the destination pointer by the pattern size
-                        if (overlap < len && overlap <= sizeof(BIGUINT)) { // repeating pattern
-                            BIGUINT pattern;
-                            if (overlap == 1) { // special case, do it faster
-                                pattern = *from;
-                                pattern = pattern | (pattern << 8);
-                                pattern = pattern | (pattern << 16);
-#if REGISTER_WIDTH == 64
-                                pattern = pattern | (pattern << 32);
+                len += (unsigned)BITS(op);
+                DROPBITS(op);
+                if (ulBitCount < REGISTER_WIDTH/2) {
+                    GETMOREBITS_SAFE
+                }
+                here = dcode[ulBits & dmask];
+            chunk_distance:
+                DROPBITS(here.bits);
+                op = (unsigned)(here.op);
+                if (op & 16) {                      /* distance base */
+                    dist = (unsigned)(here.val);
+                    op &= 15;                       /* number of extra bits */
+#if REGISTER_WIDTH == 32
+                    if (ulBitCount < REGISTER_WIDTH/2) {
+                        GETMOREBITS_SAFE
+                    }
 #endif
-                                while (pOut < pEnd) { // 2-8 byte pattern
-                                    *(BIGUINT *)pOut = pattern;
-                                    pOut += sizeof(BIGUINT);
-                                }
-                            } else { // 2-8 byte pattern
-                                pattern = *(BIGUINT *)from; // use 2-8 bytes of pattern
-                                while (pOut < pEnd) {
-                                    *(BIGUINT *)pOut = pattern;
-                                    pOut += overlap;
-                                }
-                            }
-                        } else { // regular copy (source and dest don't overlap by <= 8 bytes)
-                            while (pOut < pEnd) {
-                                *(BIGUINT *)pOut = *(BIGUINT *)from;
-                                pOut += sizeof(BIGUINT);
-                                from += sizeof(BIGUINT);
-                            }
+                    dist += (unsigned)BITS(op);
+                    DROPBITS(op);
+                    iHave = (size_t)(pOut - pChunk->pSymbols);
+                    if (dist > iHave) { // reaches into the window which isn't known yet
+                        if (!bWindow || dist > iHave + ZT_MAX_WINDOW) {
+                            ret = ZT_DECODE_ERROR;
+                            break;
                         }
-                        // correct for possible overshoot of destination ptr
-                        pOut = pEnd;
-                    } // op & 16
-                    else if ((op & 64) == 0) {          /* 2nd level distance code */
-                        if (ulBitCount <= REGISTER_WIDTH/2) {
-                            GETMOREBITS
+                        op = 256 + ZT_MAX_WINDOW - (unsigned)(dist - iHave);
+                        while (len && op < 256 + ZT_MAX_WINDOW) {
+                            *pOut++ = (uint16_t)op++;
+                            len--;
                         }
-                        here = dcode[here.val + BITS(op)];
-                        goto get_distance;
                     }
-                    else {
-                        //strm->msg = (char *)"invalid distance code";
-                        state->iLastError = ZT_DECODE_ERROR;
-                        break;
-                    }
-                }
-                else if ((op & 64) == 0) {     /* 2nd level length code */
-                    if (ulBitCount <= REGISTER_WIDTH/2) {
-                        GETMOREBITS
+                    from = pOut - dist;
+                    if (dist >= 8) { // 8 symbols at a time; it can write up to 7 past the end
+                        uint16_t *pEnd = pOut + len;
+                        while (pOut < pEnd) {
+                            memcpy(pOut, from, 8 * sizeof(uint16_t));
+                            pOut += 8;
+                            from += 8;
+                        }
+                        pOut = pEnd;
+                    } else {
+                        while (len--) {
+                            *pOut++ = *from++;
+                        }
                     }
-                    here = lcode[here.val + BITS(op)];
-                    goto get_length;
                 }
-                else if (op & 32) {                     /* end-of-block */
-                   // Tracevv((stderr, "inflate:         end of block\n"));
-                   // state->mode = TYPE;
-                   // break;
-                    state->lenbits = 0; // mark that we completed the current block
-                    goto next_block;
+                else if ((op & 64) == 0) {          /* 2nd level distance code */
+                    here = dcode[here.val + BITS(op)];
+                    goto chunk_distance;
                 }
                 else {
-                    //strm->msg = (char *)"invalid literal/length code";
-                    state->iLastError = ZT_DECODE_ERROR;
+                    ret = ZT_DECODE_ERROR;
                     break;
                 }
-                } // while decoding the current block
-    } // while !bLastBlock
-need_more_data:
-    if (state->iLastError == ZT_SUCCESS && !bLastBlock) {
-        state->iLastError = ZT_INPUT_INSUFFICIENT; // need more data
+            }
+            else if ((op & 64) == 0) {              /* 2nd level length code */
+                here = lcode[here.val + BITS(op)];
+                goto chunk_length;
+            }
+            else if (op & 32) {                     /* end-of-block */
+                break;
+            }
+            else {
+                ret = ZT_DECODE_ERROR;
+                break;
+            }
+        }
+        if (ret != ZT_SUCCESS) break;
     }
-    state->ulBits = ulBits;
-    state->ulBitCount = ulBitCount;
-    buffer->total_in += (int)(pBuf - buffer->next_in);
-    buffer->avail_in -= (int)(pBuf - buffer->next_in);
-    buffer->next_in = pBuf;
-    state->bLastBlock = bLastBlock;
-    buffer->total_out += (int)(intptr_t)(pOut - buffer->next_out);
-    buffer->next_out = pOut;
-    if (buffer->total_out == buffer->avail_out) {
-        state->iLastError = ZT_SUCCESS; // we produced the full output, we're done
+    if (ret == ZT_SUCCESS && pBuf > pInEnd && (BIGUINT)(pBuf - pInEnd) * 8 > ulBitCount) {
+        ret = ZT_DECODE_ERROR; // the last block ran past the end of the data
     }
-    return state->iLastError;
-} /* zt_inflate() */
+    pChunk->u64End = (uint64_t)(pBuf - pData) * 8 - ulBitCount;
+    pChunk->iLen = (size_t)(pOut - pChunk->pSymbols);
+    pChunk->bLast = (uint8_t)bLast;
+    return ret;
+} /* zt_decode_chunk() */
+//
+// Search bit offsets u64From to u64To-1 for the first one which looks like
+// the start of a dynamic or stored block and return it (or u64To). Dynamic
+// blocks need a complete code length code and valid tables; stored blocks
+// need zero padding and NLEN = ~LEN. Only non-final blocks are considered,
+// and fixed Huffman blocks aren't, since any bits could be the start of one.
+//
+static uint64_t zt_find_block(zt_state *state, uint8_t *pData, size_t iSize, uint64_t u64From, uint64_t u64To, int *pbStored)
+{
+    uint64_t u64, u64Lens, b;
+    BIGUINT ulBits, ulBitCount;
+    uint8_t *pBuf, *s;
+    unsigned i, ncode, pad, u32Kraft;
+
+    u64 = 0;
+    for (b = u64From; b < u64To && (b >> 3) + 24 <= iSize; b++) {
+        if (b == u64From || (b & 7) == 0) {
+            u64 = zt_get_le(&pData[b >> 3], 8) >> (b & 7);
+        } else {
+            u64 >>= 1;
+        }
+        if ((u64 & 7) == 4 && ((u64 >> 3) & 31) <= 29 && ((u64 >> 8) & 31) <= 29) { // dynamic, HLIT and HDIST in range
+            ncode = (unsigned)((u64 >> 13) & 15) + 4;
+            u64Lens = zt_get_le(&pData[(b + 17) >> 3], 8) >> ((b + 17) & 7);
+            u32Kraft = 0;
+            for (i=0; i<ncode; i++) { // the code length code must be complete
+                if (u64Lens & 7) u32Kraft += 128 >> (u64Lens & 7);
+                u64Lens >>= 3;
+            }
+            if (u32Kraft == 128) {
+                pBuf = &pData[(b + 3) >> 3];
+                ulBits = ulBitCount = 0;
+                GETMOREBITS
+                i = (unsigned)((b + 3) & 7);
+                DROPBITS(i);
+                if (zt_dynamic_tables(state, &ulBits, &ulBitCount, &pBuf, &pData[iSize], 0) == ZT_SUCCESS) { // just a validity check
+                    *pbStored = 0;
+                    return b;
+                }
+            }
+        }
+        pad = (unsigned)(((b + 10) & ~(uint64_t)7) - b); // header + padding to the next byte
+        if ((u64 & ((1U << pad) - 1)) == 0) { // stored (and zero padded)
+            s = &pData[(b + 10) >> 3];
+            if ((s[0] ^ s[2]) == 0xff && (s[1] ^ s[3]) == 0xff) {
+                *pbStored = 1;
+                return b;
+            }
+        }
+    }
+    return u64To;
+} /* zt_find_block() */
+//
+// Work on the chunks handed out by the atomic counter; decode each one from
+// the first block which starts in it to the first block boundary after it
+//
+static void zt_decode_chunks(zt_parallel *pPar)
+{
+    zt_state *state = (zt_state *)malloc(sizeof(zt_state));
+    zt_chunk *pChunk;
+    uint64_t u64From, u64To, b;
+    int k, bStored;
+
+    while ((k = pPar->iNext++) < pPar->iChunkCount) {
+        pChunk = &pPar->pChunks[k];
+        pChunk->iResult = ZT_DECODE_ERROR;
+        if (state == NULL) continue;
+        zt_init(state);
+        u64From = (uint64_t)k * ZT_PARALLEL_CHUNK * 8;
+        u64To = (k == pPar->iChunkCount-1) ? (uint64_t)pPar->iSize * 8 : u64From + (uint64_t)ZT_PARALLEL_CHUNK * 8;
+        if (k == 0) { // the first one starts at the start
+            pChunk->iResult = zt_decode_chunk(state, pChunk, pPar->pData, pPar->iSize, 0, u64To, 0, pPar->iOutSize);
+            continue;
+        }
+        while ((b = zt_find_block(state, pPar->pData, pPar->iSize, u64From, u64To, &bStored)) < u64To) {
+            pChunk->iResult = zt_decode_chunk(state, pChunk, pPar->pData, pPar->iSize, b, u64To, 1, pPar->iOutSize);
+            pChunk->bStored = (uint8_t)bStored;
+            if (pChunk->iResult == ZT_SUCCESS) break;
+            u64From = b + 1; // false alarm; keep looking
+        }
+    }
+    free(state);
+} /* zt_decode_chunks() */
+//
+// Write bytes iFrom to iTo-1 of a chunk's output to its place in the output
+// buffer; the window references are to the output which precedes the chunk
+//
+static int zt_resolve_chunk(zt_chunk *pChunk, uint8_t *pOut, size_t iFrom, size_t iTo)
+{
+    uint8_t *d = &pOut[pChunk->iOutOffset];
+    uint16_t *s = pChunk->pSymbols;
+    uint8_t ucTable[256 + ZT_MAX_WINDOW]; // symbol -> byte
+    size_t i;
+    unsigned u;
+
+    if (iTo > pChunk->iLen) { // the part which was decoded as bytes
+        i = (iFrom > pChunk->iLen) ? iFrom : pChunk->iLen;
+        memcpy(&d[i], &pChunk->pBytes[pChunk->iWindow + i - pChunk->iLen], iTo - i);
+        iTo = pChunk->iLen;
+    }
+    if (iFrom >= iTo) {
+        return ZT_SUCCESS;
+    }
+    if (pChunk->iOutOffset < ZT_MAX_WINDOW) { // the window isn't all there; check each reference
+        for (i=iFrom; i<iTo; i++) {
+            u = s[i];
+            if (u >= 256) {
+                if (pChunk->iOutOffset + (u - 256) < ZT_MAX_WINDOW) { // before the start of the output
+                    return ZT_DECODE_ERROR;
+                }
+                u = pOut[pChunk->iOutOffset + (u - 256) - ZT_MAX_WINDOW];
+            }
+            d[i] = (uint8_t)u;
+        }
+        return ZT_SUCCESS;
+    }
+    // a lookup table avoids a branch per symbol
+    for (u=0; u<256; u++) {
+        ucTable[u] = (uint8_t)u;
+    }
+    memcpy(&ucTable[256], d - ZT_MAX_WINDOW, ZT_MAX_WINDOW);
+    for (i=iFrom; i<iTo; i++) {
+        d[i] = ucTable[s[i]];
+    }
+    return ZT_SUCCESS;
+} /* zt_resolve_chunk() */
+//
+// Fill in the bulk of each chunk's output (everything but the last 32K,
+// which was already done in order)
+//
+static void zt_resolve_chunks(zt_parallel *pPar)
+{
+    zt_chunk *pChunk;
+    size_t iLen;
+    int k;
+
+    while ((k = pPar->iNext++) < pPar->iChunkCount) {
+        pChunk = &pPar->pChunks[k];
+        iLen = pChunk->iLen + pChunk->iBytes;
+        if (iLen > ZT_MAX_WINDOW) {
+            pChunk->iResult = zt_resolve_chunk(pChunk, pPar->pOut, 0, iLen - ZT_MAX_WINDOW);
+        }
+        free(pChunk->pSymbols);
+        pChunk->pSymbols = NULL;
+        free(pChunk->pBytes);
+        pChunk->pBytes = NULL;
+    }
+} /* zt_resolve_chunks() */
+//
+// Run pfnWork on iThreads threads (including the calling one)
+//
+static void zt_run_threads(int iThreads, void (*pfnWork)(zt_parallel *), zt_parallel *pPar)
+{
+    std::thread *pThreads;
+    int i;
+
+    pPar->iNext = 0;
+    pThreads = new std::thread[iThreads > 1 ? iThreads - 1 : 1];
+    for (i=0; i<iThreads-1; i++) {
+        pThreads[i] = std::thread(pfnWork, pPar);
+    }
+    pfnWork(pPar); // the calling thread works too
+    for (i=0; i<iThreads-1; i++) {
+        pThreads[i].join();
+    }
+    delete[] pThreads;
+} /* zt_run_threads() */
+//
+// Inflate a single gzip, zlib or raw deflate stream using multiple threads
+// (0 = one per CPU core). Unlike zt_gunzip_parallel(), this doesn't need a
+// file made of independent members; any stream large enough to span a few
+// chunks (ZT_PARALLEL_CHUNK bytes) is split up speculatively. Streams made
+// of fixed Huffman blocks only have no boundaries which can be found, so
+// they end up being decoded serially. While decoding, up to 2 bytes of memory
+// are needed for each byte of output.
+// The uncompressed size is returned in *piOutSize. If bVerify is true, the
+// gzip CRC-32 and size or the zlib Adler-32 are checked. *ppNext is set to
+// the gzip member which follows the stream or NULL if there isn't one.
+//
+static int zt_inflate_parallel_stream(uint8_t *pCompressed, size_t iSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int iThreads, int bVerify, uint8_t **ppNext)
+{
+    zt_parallel par;
+    zt_chunk *pChunk;
+    zt_state *state;
+    uint8_t *s;
+    uint64_t u64Pos, u64Stop;
+    size_t iTotal, iLen, iTail;
+    uint32_t u32Check;
+    int rc, k, iFormat, bDone;
+
+    *piOutSize = 0;
+    *ppNext = NULL;
+    s = zt_stream_start(pCompressed, iSize, &iFormat);
+    if (s == NULL) {
+        return ZT_HEADER_ERROR;
+    }
+    par.pData = s;
+    par.iSize = (size_t)(&pCompressed[iSize] - s);
+    par.pOut = pOut;
+    par.iOutSize = iOutSize;
+    par.iChunkCount = (int)((par.iSize + ZT_PARALLEL_CHUNK - 1) / ZT_PARALLEL_CHUNK);
+    if (par.iChunkCount == 0) {
+        return ZT_INPUT_INSUFFICIENT;
+    }
+    par.pChunks = (zt_chunk *)calloc(par.iChunkCount, sizeof(zt_chunk));
+    state = (zt_state *)malloc(sizeof(zt_state));
+    if (par.pChunks == NULL || state == NULL) {
+        free(par.pChunks);
+        free(state);
+        return ZT_INVALID_PARAMETER;
+    }
+    if (iThreads <= 0) {
+        iThreads = (int)std::thread::hardware_concurrency();
+    }
+    if (iThreads > par.iChunkCount) iThreads = par.iChunkCount;
+    zt_run_threads(iThreads, zt_decode_chunks, &par);
+    // Each chunk has to start where the one before it ended; decode the
+    // ones which don't again from there
+    rc = ZT_SUCCESS;
+    u64Pos = 0;
+    iTotal = 0;
+    bDone = 0;
+    for (k=0; k<par.iChunkCount && rc == ZT_SUCCESS; k++) {
+        pChunk = &par.pChunks[k];
+        u64Stop = (k == par.iChunkCount-1) ? (uint64_t)par.iSize * 8 : (uint64_t)(k+1) * ZT_PARALLEL_CHUNK * 8;
+        if (bDone || u64Pos >= u64Stop) { // nothing starts in this one
+            pChunk->iLen = pChunk->iBytes = 0;
+            pChunk->iOutOffset = iTotal;
+            continue;
+        }
+        if (pChunk->iResult != ZT_SUCCESS || (pChunk->u64Start != u64Pos &&
+            // a stored block header can be found a few bits early if the
+            // previous block ended with zero bits; the block is the same
+            !(pChunk->bStored && pChunk->u64Start < u64Pos && ((pChunk->u64Start + 10) >> 3) == ((u64Pos + 10) >> 3)))) {
+            zt_init(state);
+            rc = zt_decode_chunk(state, pChunk, par.pData, par.iSize, u64Pos, u64Stop, (k != 0), iOutSize - iTotal);
+            if (rc != ZT_SUCCESS) break;
+        }
+        u64Pos = pChunk->u64End;
+        bDone = pChunk->bLast;
+        pChunk->iOutOffset = iTotal;
+        iLen = pChunk->iLen + pChunk->iBytes;
+        if (iLen > iOutSize - iTotal) {
+            rc = ZT_OUTPUT_INSUFFICIENT;
+            break;
+        }
+        iTotal += iLen;
+        // the end of each chunk is the window of the next; fill it in now
+        rc = zt_resolve_chunk(pChunk, pOut, (iLen > ZT_MAX_WINDOW) ? iLen - ZT_MAX_WINDOW : 0, iLen);
+    }
+    if (rc == ZT_SUCCESS && !bDone) {
+        rc = ZT_INPUT_INSUFFICIENT; // the final block is missing
+    }
+    if (rc == ZT_SUCCESS) {
+        for (k=0; k<par.iChunkCount; k++) {
+            par.pChunks[k].iResult = ZT_SUCCESS;
+        }
+        zt_run_threads(iThreads, zt_resolve_chunks, &par);
+        for (k=0; k<par.iChunkCount && rc == ZT_SUCCESS; k++) {
+            rc = par.pChunks[k].iResult;
+        }
+    }
+    for (k=0; k<par.iChunkCount; k++) {
+        free(par.pChunks[k].pSymbols);
+        free(par.pChunks[k].pBytes);
+    }
+    free(par.pChunks);
+    free(state);
+    if (rc != ZT_SUCCESS) {
+        return rc;
+    }
+    *piOutSize = iTotal;
+    s = &par.pData[(u64Pos + 7) >> 3]; // the trailer starts at the next byte
+    if (iFormat == ZT_FORMAT_GZIP && &pCompressed[iSize] - s >= 8 + 18 && zt_gzip_member_start(&s[8])) {
+        *ppNext = &s[8];
+    }
+    if (bVerify && iFormat != ZT_FORMAT_RAW) {
+        if (iFormat == ZT_FORMAT_GZIP) {
+            if (&pCompressed[iSize] - s < 8) return ZT_INPUT_INSUFFICIENT;
+            u32Check = 0;
+            for (iTail = 0; iTail < iTotal; iTail += 0x40000000) { // zt_crc32() takes an int length
+                u32Check = zt_crc32(u32Check, &pOut[iTail], (int)((iTotal - iTail > 0x40000000) ? 0x40000000 : iTotal - iTail));
+            }
+            if (u32Check != (uint32_t)zt_get_le(s, 4) || (uint32_t)iTotal != (uint32_t)zt_get_le(&s[4], 4)) {
+                return ZT_CHECKSUM_ERROR;
+            }
+        } else { // zlib
+            if (&pCompressed[iSize] - s < 4) return ZT_INPUT_INSUFFICIENT;
+            u32Check = 1;
+            for (iTail = 0; iTail < iTotal; iTail += 0x40000000) {
+                u32Check = zt_adler32(u32Check, &pOut[iTail], (int)((iTotal - iTail > 0x40000000) ? 0x40000000 : iTotal - iTail));
+            }
+            if (u32Check != (uint32_t)((s[0] << 24) | (s[1] << 16) | (s[2] << 8) | s[3])) {
+                return ZT_CHECKSUM_ERROR;
+            }
+        }
+    }
+    return ZT_SUCCESS;
+} /* zt_inflate_parallel_stream() */
+//
+// Inflate a gzip, zlib or raw deflate stream using multiple threads (see
+// zt_inflate_parallel_stream above). The members of a multi-member gzip
+// file are decoded one after the other, each of them in parallel.
+//
+int zt_inflate_parallel(uint8_t *pCompressed, size_t iSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int iThreads, int bVerify)
+{
+    uint8_t *s, *pEnd;
+    size_t iTotal, iLen;
+    int rc;
+
+    if (pCompressed == NULL || pOut == NULL || piOutSize == NULL) {
+        return ZT_INVALID_PARAMETER;
+    }
+    *piOutSize = 0;
+    pEnd = &pCompressed[iSize];
+    s = pCompressed;
+    iTotal = 0;
+    do {
+        rc = zt_inflate_parallel_stream(s, (size_t)(pEnd - s), &pOut[iTotal], iOutSize - iTotal, &iLen, iThreads, bVerify, &s);
+        iTotal += iLen;
+    } while (rc == ZT_SUCCESS && s != NULL);
+    if (rc == ZT_SUCCESS) {
+        *piOutSize = iTotal;
+    }
+    return rc;
+} /* zt_inflate_parallel() */
+#endif // ZT_THREADS
+
 #ifdef __cplusplus
 }
 #endif
 //
 // C++ Wrapper Class methods
 //
-// Initialize the structures to inflate raw deflated data
+zlib_turbo::zlib_turbo()
+{
+    zt_init(&_state);
+    _pCache = NULL;
+} /* zlib_turbo() */
+//
+// Give the object a table cache (ZT_TABLE_CACHE entries of about 6K) to
+// reuse the decoding tables of repeated dynamic block headers in
+// gunzip() and inflate(); pass NULL to stop using it
+//
+void zlib_turbo::set_cache(zt_table_cache *pCache)
+{
+    _pCache = pCache;
+    zt_init_cache(&_state, pCache);
+} /* set_cache() */
+//
+// Register preset dictionaries for zlib streams which ask for one by its
+// DICTID (see zt_init_dicts); they stay registered through inflate_init()
+//
+int zlib_turbo::set_dictionaries(zt_dict *pDicts, int iCount)
+{
+    return zt_init_dicts(&_state, pDicts, iCount);
+} /* set_dictionaries() */
+//
+// Use a preset dictionary for the stream started by the last inflate_init()
+// (raw deflate, or after inflate() returned ZT_NEED_DICT)
+//
+int zlib_turbo::set_dictionary(const uint8_t *pDict, int iSize)
+{
+    return zt_init_dict(&_state, pDict, iSize);
+} /* set_dictionary() */
+// Initialize the structures to inflate gzip, zlib or raw deflate data
 // Provide the output buffer and its capacity
 //
-void zlib_turbo::inflate_init(uint8_t *pOut, int iOutSize)
+void zlib_turbo::inflate_init(uint8_t *pOut, int iOutSize, int bVerify)
 {
-    zt_init(&_state);
+    zt_reset(&_state);
+    zt_init_carry(&_state); // inflate() can be given the input in any size pieces
+    zt_init_format(&_state, ZT_FORMAT_AUTO); // gzip, zlib or raw deflate
+    if (bVerify) { // check the CRC-32 or Adler-32 in the trailer
+        zt_init_check(&_state, ZT_CHECK_ADLER32);
+    }
+    _buffer.next_out = pOut;
+    _buffer.avail_out = iOutSize;
+    _buffer.total_out = 0;
+    _buffer.total_in = 0;
+} /* inflate_init() */
+//
+// Initialize the structures to inflate gzip, zlib or raw deflate data in streaming mode
+// The output is decoded into pChunk (iChunkSize bytes) and passed to the
+// callback function as each chunk fills; pWindow must hold (1<<iWindowBits)
+// bytes of history (32K for the general case)
+//
+void zlib_turbo::inflate_init(uint8_t *pWindow, int iWindowBits, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser, int bVerify)
+{
+    zt_reset(&_state);
+    zt_init_window(&_state, pWindow, iWindowBits);
+    zt_init_carry(&_state);
+    zt_init_format(&_state, ZT_FORMAT_AUTO);
+    if (bVerify) {
+        zt_init_check(&_state, ZT_CHECK_ADLER32);
+    }
+    _pChunk = pChunk;
+    _iChunkSize = iChunkSize;
+    _pfnOutput = pfnOutput;
+    _pUser = pUser;
+    _buffer.total_out = 0;
+    _buffer.total_in = 0;
+} /* inflate_init() */
+//
+// Initialize the structures to inflate gzip, zlib or raw deflate data into a list of
+// output segments (e.g. pooled buffers) instead of one contiguous buffer.
+// The segments are filled in order and must stay valid until it's done
+//
+void zlib_turbo::inflate_init(zt_segment *pSegs, int iSegCount, int bVerify)
+{
+    zt_reset(&_state);
+    zt_init_segments(&_state, pSegs, iSegCount);
+    zt_init_carry(&_state);
+    zt_init_format(&_state, ZT_FORMAT_AUTO);
+    if (bVerify) {
+        zt_init_check(&_state, ZT_CHECK_ADLER32);
+    }
+    _buffer.total_out = 0;
+    _buffer.total_in = 0;
+} /* inflate_init() */
+//
+// Initialize the structures to inflate gzip, zlib or raw deflate data of
+// unknown size into a buffer which grows as needed. pOut/iOutSize is the
+// starting buffer from the reallocation hook (NULL/0 to have inflate()
+// allocate the first one); pfnRealloc can be zt_realloc for the heap.
+// When it's done, the output is at outBuffer() and the caller owns it
+//
+void zlib_turbo::inflate_init(uint8_t *pOut, int iOutSize, ZT_REALLOC_CALLBACK *pfnRealloc, void *pUser, int bVerify)
+{
+    zt_reset(&_state);
+    zt_init_grow(&_state, pfnRealloc, pUser);
+    zt_init_carry(&_state);
+    zt_init_format(&_state, ZT_FORMAT_AUTO);
+    if (bVerify) {
+        zt_init_check(&_state, ZT_CHECK_ADLER32);
+    }
     _buffer.next_out = pOut;
     _buffer.avail_out = iOutSize;
     _buffer.total_out = 0;
+    _buffer.total_in = 0;
 } /* inflate_init() */
 //
 // Inflate a block of deflated data
-// You can feed the inflater incrementally, but the output buffer must be able to
-// handle the full sized output from the first call
+// You can feed the inflater incrementally in pieces of any size (whatever it
+// can't use yet is kept for the next call); all of the members of a
+// multi-member gzip file are decoded. The output buffer must be able
+// to handle the full sized output from the first call (except in streaming mode
+// and with a growable buffer)
 // The bLast flag tells the inflater that you've passed it the complete data (last chunk)
 //
-int zlib_turbo::inflate(uint8_t *pIn, int iInSize)
+int zlib_turbo::inflate(uint8_t *pIn, int iInSize, int bLast)
 {
     _buffer.next_in = pIn;
     _buffer.avail_in = iInSize;
-    return zt_inflate(&_state, &_buffer, 1);
+    if (_state.pWindow) { // streaming mode
+        return zt_inflate_stream(&_state, &_buffer, bLast, _pChunk, _iChunkSize, _pfnOutput, _pUser);
+    }
+    if (_state.pSegs) { // scatter/gather mode
+        return zt_inflate_segments(&_state, &_buffer, bLast);
+    }
+    if (_state.pfnRealloc) { // growable output
+        return zt_inflate_grow(&_state, &_buffer, bLast);
+    }
+    return zt_inflate(&_state, &_buffer, bLast);
 } /* inflate() */
 //
 // Returns the amount of data decompressed from the gzip file
@@ -922,6 +6295,14 @@ int zlib_turbo::outSize(void)
     return _buffer.total_out;
 } /* outSize() */
 //
+// Returns the start of the output; with a growable buffer it's wherever the
+// output ended up after the last reallocation
+//
+uint8_t *zlib_turbo::outBuffer(void)
+{
+    return _buffer.next_out - _buffer.total_out;
+} /* outBuffer() */
+//
 // Return size, name and date/time info for a gzip file
 // This is necessary to call first to know how large an output buffer will be needed
 //
@@ -930,9 +6311,184 @@ uint32_t zlib_turbo::gzip_info(uint8_t *pCompressed, int iSize, char *szName, ui
     return zt_gzip_info(pCompressed, iSize, szName, pu32Time);
 } /* gzip_info() */
 //
-// Unzip a gzip file in one shot
+// Tell whether data is gzip, zlib or raw deflate (ZT_FORMAT_xxx, or -1)
+//
+int zlib_turbo::detect_format(const uint8_t *pData, size_t iSize)
+{
+    return zt_detect_format(pData, iSize);
+} /* detect_format() */
+//
+// Decode gzip, zlib or raw deflate data in one shot, whichever it is
+//
+int zlib_turbo::inflate_auto(uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int bVerify)
+{
+    return zt_inflate_auto(&_state, pIn, iInSize, pOut, iOutSize, piOutSize, bVerify);
+} /* inflate_auto() */
+//
+// Unzip a gzip file in one shot, reusing this object's decoder (and table cache)
+//
+int zlib_turbo::gunzip(uint8_t *pCompressed, int iInSize, uint8_t *pUncompressed, int bVerify)
+{
+    return zt_gunzip_reuse(&_state, pCompressed, iInSize, pUncompressed, bVerify);
+} /* gunzip() */
+//
+// Unzip a gzip file in streaming mode
+// The output is passed to the callback function in chunks of up to iChunkSize bytes
+// pWindow must point to ZT_MAX_WINDOW (32K) bytes
+//
+int zlib_turbo::gunzip(uint8_t *pCompressed, int iInSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser, int bVerify)
+{
+    return zt_gunzip_stream(pCompressed, iInSize, pWindow, pChunk, iChunkSize, pfnOutput, pUser, bVerify);
+} /* gunzip() */
+//
+// Unzip a gzip file in streaming mode with the output passed to a row
+// callback iRowSize bytes at a time (see zt_init_rows)
+//
+int zlib_turbo::gunzip(uint8_t *pCompressed, int iInSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, zt_rows *pRows, int bVerify)
+{
+    return zt_gunzip_rows(pCompressed, iInSize, pWindow, pChunk, iChunkSize, pRows, bVerify);
+} /* gunzip() */
+//
+// Unzip a gzip file into a list of output segments instead of one buffer
+// The total output size is returned in *piOutSize
 //
-int zlib_turbo::gunzip(uint8_t *pCompressed, int iInSize, uint8_t *pUncompressed)
+int zlib_turbo::gunzip(uint8_t *pCompressed, int iInSize, zt_segment *pSegs, int iSegCount, size_t *piOutSize, int bVerify)
 {
-    return zt_gunzip(pCompressed, iInSize, pUncompressed);
+    return zt_gunzip_segments(pCompressed, iInSize, pSegs, iSegCount, piOutSize, bVerify);
 } /* gunzip() */
+//
+// Decode a batch of small gzip/zlib/raw streams with this object's decoder
+// (and table cache); see zt_inflate_batch
+//
+int zlib_turbo::inflate_batch(zt_batch_item *pItems, int iCount, int bVerify)
+{
+    return zt_inflate_batch(&_state, pItems, iCount, bVerify);
+} /* inflate_batch() */
+//
+// Decode gzip/zlib/raw deflate data with 64-bit sizes (see zt_inflate_mem)
+//
+int zlib_turbo::inflate_mem(uint8_t *pIn, uint64_t u64InSize, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify)
+{
+    return zt_inflate_mem(pIn, u64InSize, pOut, u64OutSize, pu64OutSize, bVerify);
+} /* inflate_mem() */
+//
+// Decode the start of gzip/zlib/raw deflate data (prepared with
+// zt_init_span) up to u64Limit bytes, or until the callback says it has
+// enough; call it again with a higher limit to resume (see zt_inflate_partial)
+//
+int zlib_turbo::inflate_partial(zt_span *pSpan, uint64_t u64Limit, ZT_ENOUGH_CALLBACK *pfnEnough, void *pUser)
+{
+    return zt_inflate_partial(&_state, pSpan, u64Limit, pfnEnough, pUser);
+} /* inflate_partial() */
+#ifdef ZT_FILES
+//
+// Decode a compressed file into another file (see zt_inflate_file)
+//
+int zlib_turbo::inflate_file(const char *szIn, const char *szOut, uint64_t *pu64OutSize, int bVerify)
+{
+    return zt_inflate_file(szIn, szOut, pu64OutSize, bVerify);
+} /* inflate_file() */
+//
+// Decode a compressed file into memory (see zt_inflate_file_mem)
+//
+int zlib_turbo::inflate_file(const char *szIn, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify)
+{
+    return zt_inflate_file_mem(szIn, pOut, u64OutSize, pu64OutSize, bVerify);
+} /* inflate_file() */
+#endif // ZT_FILES
+//
+// Find the members of a multi-member gzip file (see zt_gzip_members)
+//
+int zlib_turbo::gzip_members(uint8_t *pCompressed, size_t iSize, zt_member *pMembers, int iMaxMembers)
+{
+    return zt_gzip_members(pCompressed, iSize, pMembers, iMaxMembers);
+} /* gzip_members() */
+//
+// Read the image header of a PNG file
+//
+int zlib_turbo::png_info(uint8_t *pPNG, size_t iSize, zt_png_header *pHeader)
+{
+    return zt_png_info(pPNG, iSize, pHeader);
+} /* png_info() */
+//
+// Size of the work buffer png_decode() needs for an image
+//
+size_t zlib_turbo::png_work_size(zt_png_header *pHeader)
+{
+    return zt_png_work_size(pHeader);
+} /* png_work_size() */
+//
+// Decode a PNG image into pOut and/or pass its rows to a callback as
+// they're unfiltered (see zt_png_decode)
+//
+int zlib_turbo::png_decode(uint8_t *pPNG, size_t iSize, uint8_t *pOut, size_t iPitch, ZT_ROW_CALLBACK *pfnRow, void *pUser, uint8_t *pWork, size_t iWorkSize, int bVerify)
+{
+    return zt_png_decode(pPNG, iSize, pOut, iPitch, pfnRow, pUser, pWork, iWorkSize, bVerify);
+} /* png_decode() */
+#ifdef ZT_THREADS
+//
+// Unzip the members of a multi-member gzip file on multiple threads
+//
+int zlib_turbo::gunzip_parallel(uint8_t *pCompressed, zt_member *pMembers, int iMemberCount, uint8_t *pUncompressed, int iThreads, int bVerify)
+{
+    return zt_gunzip_parallel(pCompressed, pMembers, iMemberCount, pUncompressed, iThreads, bVerify);
+} /* gunzip_parallel() */
+//
+// Inflate a single gzip, zlib or raw deflate stream with multiple threads
+//
+int zlib_turbo::inflate_parallel(uint8_t *pCompressed, size_t iSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int iThreads, int bVerify)
+{
+    return zt_inflate_parallel(pCompressed, iSize, pOut, iOutSize, piOutSize, iThreads, bVerify);
+} /* inflate_parallel() */
+#endif // ZT_THREADS
+//
+// Work memory needed by deflate() (see zt_deflate_work_size)
+//
+size_t zlib_turbo::deflate_work_size(int iLevel)
+{
+    return zt_deflate_work_size(iLevel);
+} /* deflate_work_size() */
+//
+// Largest possible compressed size of iInSize bytes
+//
+size_t zlib_turbo::deflate_bound(size_t iInSize, int iFormat)
+{
+    return zt_deflate_bound(iInSize, iFormat);
+} /* deflate_bound() */
+//
+// Compress data in one shot as gzip (default), zlib or raw deflate
+//
+int zlib_turbo::deflate(uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, uint8_t *pWork, size_t iWorkSize, int iLevel, int iFormat)
+{
+    return zt_deflate(pIn, iInSize, pOut, iOutSize, piOutSize, pWork, iWorkSize, iLevel, iFormat);
+} /* deflate() */
+#ifdef ZT_STATS
+//
+// Statistics of the decoder (see ZT_STATS); they add up until zt_init()
+//
+zt_stats * zlib_turbo::stats(void)
+{
+    return &_state.stats;
+} /* stats() */
+#endif
+//
+// Build a random access index for compressed data (see zt_index_build)
+//
+int zlib_turbo::index_build(uint8_t *pCompressed, size_t iSize, uint32_t u32Span, zt_index **ppIndex)
+{
+    return zt_index_build(pCompressed, iSize, u32Span, ppIndex);
+} /* index_build() */
+//
+// Read uncompressed data from any offset using an index
+//
+int zlib_turbo::index_extract(zt_index *pIndex, uint8_t *pCompressed, size_t iSize, uint64_t u64Offset, uint8_t *pOut, int iLen)
+{
+    return zt_index_extract(pIndex, pCompressed, iSize, u64Offset, pOut, iLen);
+} /* index_extract() */
+//
+// Free an index from index_build()
+//
+void zlib_turbo::index_free(zt_index *pIndex)
+{
+    zt_index_free(pIndex);
+} /* index_free() */
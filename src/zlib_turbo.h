@@ -36,14 +36,113 @@
 #define zlib_turbo_h
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define MAXBITS 15
+// Root table bits for the dynamic block length/literal and distance codes.
+// Longer codes take a 2nd table lookup, so bigger roots mean fewer of those
+// (and more literal pairs), at the cost of more memory in zt_state and the
+// table cache and more time to fill the tables for each block. Define
+// ZT_BIG_TABLES for 11/8 bit roots (or set ZT_LENBITS/ZT_DISTBITS) on hosts
+// with a big L1 cache; zlib's 9/6 is the default since it was as fast or
+// faster on the corpora we tried, where the blocks aren't long enough to
+// pay for building the bigger tables
+#ifdef ZT_BIG_TABLES
+#ifndef ZT_LENBITS
+#define ZT_LENBITS 11
+#endif
+#ifndef ZT_DISTBITS
+#define ZT_DISTBITS 8
+#endif
+#endif
+#ifndef ZT_LENBITS
+#define ZT_LENBITS 9
+#endif
+#ifndef ZT_DISTBITS
+#define ZT_DISTBITS 6
+#endif
+// Largest possible tables for those roots (from zlib's examples/enough.c)
+#if ZT_LENBITS == 9
 #define ENOUGH_LENS 852
+#elif ZT_LENBITS == 10
+#define ENOUGH_LENS 1332
+#elif ZT_LENBITS == 11
+#define ENOUGH_LENS 2340
+#elif ZT_LENBITS == 12
+#define ENOUGH_LENS 4380
+#else
+#error "ZT_LENBITS must be 9-12"
+#endif
+#if ZT_DISTBITS == 6 || ZT_DISTBITS == 9
 #define ENOUGH_DISTS 592
+#elif ZT_DISTBITS == 7 || ZT_DISTBITS == 8
+#define ENOUGH_DISTS 400
+#else
+#error "ZT_DISTBITS must be 6-9"
+#endif
 #define ENOUGH (ENOUGH_LENS+ENOUGH_DISTS)
+#define ZT_MAX_WINDOW 32768 // largest sliding window needed by any deflate stream
+// Pack pairs of short literal codes into single table entries
+// (see zt_pack_literals); comment this out to use plain zlib tables
+#define PAIR_LITERALS
+// Pairing takes a pass over the root table, so it's skipped when there's
+// less than this much room left for the output of the block
+#define ZT_PAIR_MIN_OUTPUT 4096
+// Multi-threaded decoding (zt_gunzip_parallel) needs an OS with std::thread;
+// it's only on by default for hosted platforms (define ZT_THREADS to turn it
+// on elsewhere or ZT_NO_THREADS to leave it out)
+#if !defined(ZT_THREADS) && !defined(ARDUINO) && !defined(ZT_NO_THREADS) && (defined(__unix__) || defined(__APPLE__) || defined(_WIN32))
+#define ZT_THREADS
+#endif
+// On x86-64, a second copy of the decoder built for BMI2 is picked at run
+// time on CPUs which have it, unless the compiler already targets BMI2
+// (e.g. -march=haswell); define ZT_NO_DISPATCH to leave it out
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__BMI2__) && !defined(ARDUINO) && !defined(ZT_NO_DISPATCH)
+#define ZT_DISPATCH
+#endif
+// Memory mapped file decoding (zt_inflate_file) needs mmap()
+#if !defined(ARDUINO) && !defined(ZT_NO_FILES) && (defined(__unix__) || defined(__APPLE__))
+#define ZT_FILES
+#endif
+// Output between calls to the callback of a partial decode (zt_inflate_partial)
+#ifndef ZT_PARTIAL_STEP
+#define ZT_PARTIAL_STEP 4096
+#endif
+// PNG decoding (zt_png_decode) inflates this much at a time and unfilters the
+// rows while they're still in the cache
+#ifndef ZT_PNG_CHUNK
+#define ZT_PNG_CHUNK 8192
+#endif
+// Input kept between calls in incremental input mode (see zt_init_carry);
+// it must hold the longest possible dynamic block header (286 bytes) plus
+// a little room for new input
+#ifndef ZT_INPUT_CARRY
+#define ZT_INPUT_CARRY 320
+#endif
+// Smallest output buffer allocated in growable output mode (see zt_init_grow)
+#ifndef ZT_GROW_MIN
+#define ZT_GROW_MIN 4096
+#endif
+// Compressed bytes given to each thread by zt_inflate_parallel
+#ifndef ZT_PARALLEL_CHUNK
+#define ZT_PARALLEL_CHUNK (4*1024*1024)
+#endif
+// Dynamic block headers remembered by a table cache (see zt_init_cache);
+// each one takes about 6K
+#ifndef ZT_TABLE_CACHE
+#define ZT_TABLE_CACHE 4
+#endif
+// Compressor (zt_deflate) table sizes for the default work buffer (see
+// zt_deflate_work_size); a smaller work buffer scales them down
+#define ZT_DEFLATE_HASH_BITS 15   // log2 of the number of hash table entries
+#define ZT_DEFLATE_SYMBOLS 16384  // literals + matches buffered for each block
+// Define ZT_STATS to have zt_inflate() count what it decodes and which code
+// paths it takes (see zt_stats). Without it, none of the counting code is
+// compiled in.
+//#define ZT_STATS
 
 // Error / success codes
 enum {
@@ -52,7 +151,34 @@ enum {
     ZT_DECODE_ERROR,
     ZT_OUTPUT_INSUFFICIENT,
     ZT_INPUT_INSUFFICIENT,
-    ZT_INVALID_PARAMETER
+    ZT_INVALID_PARAMETER,
+    ZT_CHECKSUM_ERROR,
+    ZT_BLOCK_END,       // stopped at a block boundary (see bBlockStop)
+    ZT_NEED_DICT        // the zlib header asks for a dictionary we don't have (see zt_init_dict)
+};
+
+// Compressed data formats
+enum {
+    ZT_FORMAT_RAW,      // raw deflate
+    ZT_FORMAT_ZLIB,
+    ZT_FORMAT_GZIP,
+    ZT_FORMAT_AUTO      // detect gzip, zlib or raw deflate from the header
+};
+
+// PNG color types (see zt_png_header)
+enum {
+    ZT_PNG_GRAY = 0,
+    ZT_PNG_RGB = 2,
+    ZT_PNG_PALETTE = 3,
+    ZT_PNG_GRAY_ALPHA = 4,
+    ZT_PNG_RGBA = 6
+};
+
+// Checksum types (see zt_init_check)
+enum {
+    ZT_CHECK_NONE,
+    ZT_CHECK_CRC32,   // gzip
+    ZT_CHECK_ADLER32  // zlib
 };
 
 /* Type of code to build for inflate_table() */
@@ -63,8 +189,8 @@ typedef enum {
 } codetype;
 
 typedef struct code_tag {
-    uint8_t bits;         /* bits in this part of the code */
     uint8_t op;           /* operation, extra bits, table bits */
+    uint8_t bits;         /* bits in this part of the code */
     uint16_t val;         /* offset in table or code value */
 } code;
 /* op values as set by inflate_table():
@@ -73,6 +199,7 @@ typedef struct code_tag {
     0001eeee - length or distance, eeee is the number of extra bits
     01100000 - end of block
     01000000 - invalid code
+    10000000 - 2 literals, packed into val (see zt_pack_literals)
  */
 
 typedef struct zt_buffer_tag {
@@ -96,6 +223,9 @@ typedef struct zt_buffer_tag {
 #define BIGINT int64_t
 #define BIGUINT uint64_t
 #define GETMOREBITS {uint64_t u64; u64 = *(uint32_t *)pBuf; pBuf += 4; ulBits |= (u64 << ulBitCount); ulBitCount += 32;}
+// Branchless refill for the fast loop; tops up the accumulator to 56-63 bits
+// (enough for a complete length + distance symbol) with a single 8-byte read
+#define GETMOREBITS_FAST {ulBits |= (*(uint64_t *)pBuf << ulBitCount); pBuf += (63 - ulBitCount) >> 3; ulBitCount |= 56;}
 #else
 #define REGISTER_WIDTH 32
 // This generates the fewest masking instructions (at least on arm)
@@ -107,12 +237,148 @@ typedef struct zt_buffer_tag {
 #else
 #define GETMOREBITS {uint32_t u32; u32 = (pBuf[0] | (pBuf[1] << 8)); pBuf += 2; ulBits |= (u32 << ulBitCount); ulBitCount += 16;}
 #endif // ALLOWS_UNALIGNED
+#define GETMOREBITS_FAST {if (ulBitCount < REGISTER_WIDTH/2) GETMOREBITS}
 #endif // 64-bit
 
 #define NEXTBYTE(u) {BIGUINT c = u & 7; if (c) u += (8-c);}
+// true while there is still unread input to decode; on the final call the
+// bits already in the accumulator can be used up to the last byte
+#define INPUT_LEFT (((BIGINT)(pInEnd - pBuf) * 8 + (BIGINT)ulBitCount) > iMinBits)
+// Careful refill which never reads past the end of the input. Past the end,
+// zero bytes are shifted in; they're given back when zt_inflate() returns
+#define GETMOREBITS_SAFE {if (pInEnd - pBuf >= (int)sizeof(BIGUINT)) GETMOREBITS else { while (ulBitCount < REGISTER_WIDTH-8) { ulBits |= (BIGUINT)((pBuf < pInEnd) ? *pBuf : 0) << ulBitCount; pBuf++; ulBitCount += 8; } } }
+#define MAX_SYMBOL_BITS 48 // 15-bit length code + 5 extra + 15-bit distance code + 13 extra
+#define FAST_INPUT_MARGIN 16 // input needed to run the fast loop without checks
+// Widest register the fast loop uses to copy matches (see zt_copy_fast)
+#if defined(__AVX2__)
+#define COPY_WIDTH 32
+#elif defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+#define COPY_WIDTH 16
+#else
+#define COPY_WIDTH REGISTER_WIDTH/8
+#endif
+#define FAST_OUTPUT_MARGIN (258 + 2*COPY_WIDTH) // longest match + wide write overshoot
+// The fast loop updates the checksum every CHECK_CHUNK bytes of output so the
+// data is still in the cache when it gets read again
+#define CHECK_CHUNK 16384
+#if REGISTER_WIDTH == 64
+#define CRC_SLICES 8 // slicing-by-8 CRC tables (8K)
+#else
+#define CRC_SLICES 1 // a single 1K table to save FLASH on MCUs
+#endif
+// Bit writer for the compressor. Whole 16/32-bit words are stored as soon as
+// they're complete, so it never writes past the last bit it was given.
+// PUTBITS takes up to 16 bits at a time on 32-bit CPUs (32 on 64-bit)
+#if REGISTER_WIDTH == 64
+#define PUTWORD {*(uint32_t *)pOut = (uint32_t)ulBits; pOut += 4; ulBits >>= 32; ulBitCount -= 32;}
+#define PUTBITS2(v1, l1, v2, l2) PUTBITS((v1) | ((BIGUINT)(v2) << (l1)), (l1) + (l2))
+#define LOAD32(p) (*(uint32_t *)(p))
+#else
+#define PUTWORD {pOut[0] = (uint8_t)ulBits; pOut[1] = (uint8_t)(ulBits >> 8); pOut += 2; ulBits >>= 16; ulBitCount -= 16;}
+#define PUTBITS2(v1, l1, v2, l2) {PUTBITS(v1, l1) PUTBITS(v2, l2)}
+#define LOAD32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+#endif
+#define PUTBITS(val, len) {ulBits |= (BIGUINT)(val) << ulBitCount; ulBitCount += (len); if (ulBitCount >= REGISTER_WIDTH/2) PUTWORD}
+
+// Output callback for streaming mode; it receives each decoded chunk and
+// returns 1 to continue decoding or 0 to stop
+typedef int (ZT_OUTPUT_CALLBACK)(void *pUser, uint8_t *pData, int iLen);
+// Row callback for row output (zt_init_rows) and PNG decoding (zt_png_decode);
+// it receives each complete row and returns 1 to continue decoding or 0 to stop
+typedef int (ZT_ROW_CALLBACK)(void *pUser, int iRow, uint8_t *pRow, int iLen);
+// Transform applied in place to each row before the row callback sees it
+// (e.g. zt_swap16 to make RGB565 pixels big-endian for an LCD)
+typedef void (ZT_ROW_TRANSFORM)(uint8_t *pData, int iLen);
+// Callback for a partial decode (zt_inflate_partial); it's shown all of the
+// output so far and returns 1 when that's enough or 0 to keep going
+typedef int (ZT_ENOUGH_CALLBACK)(void *pUser, uint8_t *pOut, uint64_t u64Size);
+// Reallocation hook for growable output (zt_init_grow); it returns a buffer of
+// iNewSize bytes which starts with the iOldSize bytes at pOld (pOld can be NULL
+// when iOldSize is 0), like realloc(), or NULL if it can't
+typedef uint8_t *(ZT_REALLOC_CALLBACK)(void *pUser, uint8_t *pOld, size_t iOldSize, size_t iNewSize);
+
+// Decoding tables built for one dynamic block header (see zt_init_cache)
+typedef struct zt_table_entry_tag {
+    uint16_t nlen;              /* number of length code lengths (0 = unused) */
+    uint16_t ndist;             /* number of distance code lengths */
+    uint8_t lenbits;            /* index bits for the length/literal table */
+    uint8_t distbits;           /* index bits for the distance table */
+    uint16_t distoffset;        /* start of the distance table in codes[] */
+    uint8_t bPaired;            /* literal pairs are packed in (zt_pack_literals) */
+    uint8_t lens[286+30];       /* the code lengths they were built from */
+    code codes[ENOUGH];
+} zt_table_entry;
+
+// Tables of the last few dynamic block headers. Streams made by the same
+// encoder often repeat the same header, which can then reuse the tables
+// instead of building them again. A cache can only serve one zt_state.
+typedef struct zt_table_cache_tag {
+    uint32_t u32Next;           /* entry to replace next */
+    zt_table_entry entries[ZT_TABLE_CACHE];
+} zt_table_cache;
+
+// A preset dictionary (see zt_init_dicts). zlib streams made with one name
+// it in their header by its Adler-32 (DICTID)
+typedef struct zt_dict_tag {
+    const uint8_t *pData;
+    uint32_t u32Size;
+    uint32_t u32Id;             /* DICTID; set by zt_init_dicts() */
+} zt_dict;
+
+#ifdef ZT_STATS
+// How zt_inflate() copied each match (zt_stats.u64Copies)
+enum {
+    ZT_COPY_WIDE,       // plain copy with wide registers
+    ZT_COPY_PATTERN,    // source overlaps the destination; a short repeating pattern
+    ZT_COPY_HISTORY,    // reaches before the output buffer or was split across calls
+    ZT_COPY_BYTES,      // one byte at a time, too close to the end of the output
+    ZT_COPY_COUNT
+};
+
+// Decoder statistics (see ZT_STATS). zt_init() clears them and zt_reset()
+// doesn't, so they add up over all the streams a decoder is used for
+typedef struct zt_stats_tag {
+    uint64_t u64Blocks[3];      /* stored, fixed and dynamic blocks */
+    uint64_t u64StoredBytes;    /* bytes in stored blocks */
+    uint64_t u64Literals;
+    uint64_t u64Matches;
+    uint64_t u64MatchBytes;
+    uint64_t u64LenHist[9];     /* [n] counts matches of length 2^n to 2^(n+1)-1 */
+    uint64_t u64DistHist[16];   /* [n] counts matches of distance 2^n to 2^(n+1)-1 */
+    uint64_t u64LenLinks;       /* length/literal codes which needed a 2nd level table */
+    uint64_t u64DistLinks;      /* distance codes which needed a 2nd level table */
+    uint64_t u64Copies[ZT_COPY_COUNT]; /* matches copied by each path */
+    uint64_t u64Refills;        /* bit accumulator refills in the decode loops */
+    uint64_t u64TablesBuilt;    /* dynamic headers decoded into new tables */
+    uint64_t u64TableHits;      /* dynamic headers found in the table cache */
+    uint64_t u64TableTicks;     /* time spent on dynamic headers (see ZT_TICKS) */
+} zt_stats;
+#define ZT_COUNT(field, n) {state->stats.field += (n);}
+#else
+#define ZT_COUNT(field, n)
+#endif
 
-/* State maintained between inflate() calls -- approximately 7K bytes, not
-   including the allocated sliding window, which is up to 32K bytes. */
+// One piece of a scatter/gather output list (see zt_init_segments)
+typedef struct zt_segment_tag {
+    uint8_t *pData;
+    uint32_t u32Size;
+} zt_segment;
+
+// Row output for streaming mode (see zt_init_rows). Pass zt_rows_output as
+// the output callback with a pointer to this as its pUser
+typedef struct zt_rows_tag {
+    uint8_t *pRow;              /* caller-supplied buffer for rows split between two chunks */
+    uint32_t u32RowSize;        /* bytes per row */
+    uint32_t u32Have;           /* bytes of the current row in pRow */
+    uint32_t u32Row;            /* rows passed to the callback so far */
+    ZT_ROW_CALLBACK *pfnRow;
+    ZT_ROW_TRANSFORM *pfnTransform; /* NULL for none */
+    void *pUser;
+} zt_rows;
+
+/* State maintained between inflate() calls -- approximately 7K bytes (12K
+   with ZT_BIG_TABLES), not including the allocated sliding window, which
+   is up to 32K bytes. */
 typedef struct zt_state_tag {
     uint8_t iLastError;             /* last error */
     uint8_t bLastBlock;                   /* true if processing last block */
@@ -129,11 +395,117 @@ typedef struct zt_state_tag {
     uint16_t ndist;             /* number of distance code lengths */
     uint16_t have;              /* number of code lengths in lens[] */
     code *next;             /* next available space in codes[] */
+        /* streaming mode */
+    uint8_t *pWindow;           /* caller-supplied circular window or NULL */
+    uint32_t u32WindowSize;     /* window size in bytes (power of 2) */
+    uint32_t u32WindowPos;      /* next write position in the window */
+    uint32_t u32WindowHave;     /* number of valid bytes in the window */
+    uint32_t u32CopyLen;        /* match bytes left over from the last call */
+    uint32_t u32CopyDist;       /* distance of the left over match */
+    uint32_t u32StoredLen;      /* bytes left to copy in a stored block */
+        /* scatter/gather output */
+    zt_segment *pSegs;          /* caller-supplied list of output segments or NULL */
+    uint32_t u32SegCount;       /* number of segments in the list */
+    uint32_t u32Seg;            /* segment being written */
+    uint32_t u32SegPos;         /* bytes written to it so far */
+        /* growable output */
+    ZT_REALLOC_CALLBACK *pfnRealloc; /* grows the output buffer (see zt_init_grow) or NULL */
+    void *pReallocUser;
+        /* incremental input */
+    uint8_t bCarry;             /* keep unused input in carry[] (see zt_init_carry) */
+    uint16_t u16NeedIn;         /* input needed to retry a dynamic block header */
+    uint32_t u32Carry;          /* bytes in carry[] which come before buffer->next_in */
+        /* stream format (see zt_init_format) */
+    uint8_t u8Format;           /* ZT_FORMAT_xxx; GZIP/AUTO until the header is parsed */
+    uint8_t bTrailer;           /* the gzip trailer has been read */
+    uint32_t u32MemberOut;      /* output before the current gzip member */
+        /* preset dictionary */
+    const uint8_t *pDict;       /* history before the start of the output or NULL */
+    uint32_t u32DictSize;
+    uint32_t u32DictId;         /* its Adler-32, or the DICTID asked for (ZT_NEED_DICT) */
+        /* checksum verification */
+    uint8_t u8CheckType;        /* ZT_CHECK_NONE/CRC32/ADLER32 */
+    uint32_t u32Check;          /* running checksum of the output */
+    uint8_t bBlockStop;         /* return ZT_BLOCK_END at each block boundary */
+    zt_table_cache *pCache;     /* tables of recent dynamic headers or NULL */
+    zt_dict *pDicts;            /* registered dictionaries (kept through zt_reset) */
+    uint32_t u32DictCount;
+        /* table building space; zt_reset() leaves these alone */
     uint8_t lens[320];   /* temporary storage for code lengths */
     uint16_t work[288];   /* work area for code table building */
     code codes[ENOUGH];         /* space for code tables */
+    uint8_t carry[ZT_INPUT_CARRY + 8]; /* input left over from the last call (+ the bit accumulator at the end) */
+#ifdef ZT_STATS
+    zt_stats stats;             /* kept through zt_reset() */
+#endif
 } zt_state;
 
+// One member of a (possibly) multi-member gzip file (see zt_gzip_members)
+typedef struct zt_member_tag {
+    size_t iInOffset;       /* offset of the member's gzip header in the input */
+    size_t iInSize;         /* compressed size, including the header and trailer */
+    size_t iOutOffset;      /* offset of its uncompressed data in the output */
+    uint32_t u32OutSize;    /* uncompressed size (ISIZE from the trailer) */
+    int iResult;            /* result of decoding it in zt_gunzip_parallel() */
+} zt_member;
+
+// One of a batch of independent streams (see zt_inflate_batch)
+typedef struct zt_batch_item_tag {
+    uint8_t *pIn;           /* compressed data */
+    size_t iInSize;
+    uint8_t *pOut;          /* output buffer */
+    size_t iOutSize;        /* its size */
+    size_t iOutLen;         /* bytes decoded (set by zt_inflate_batch) */
+    uint8_t u8Format;       /* ZT_FORMAT_xxx (AUTO to detect it) */
+    int iResult;            /* ZT_SUCCESS or this stream's error */
+} zt_batch_item;
+
+// Progress of a 64-bit or partial decode (zt_inflate_mem, zt_inflate_partial
+// and the file functions). Positions are offsets rather than pointers, so
+// the output can be moved (e.g. remapped at a larger size) in between calls
+typedef struct zt_span_tag {
+    uint8_t *pIn;
+    uint64_t u64InSize, u64InPos;
+    uint8_t *pOut;
+    uint64_t u64OutSize, u64OutPos; /* u64OutPos = bytes decoded so far */
+    uint64_t u64MemberOut;      /* output offset where the current stream/member started */
+    int iFormat;                /* ZT_FORMAT_xxx (detected from the header) */
+    int bVerify;
+    int bInStream;              /* in the middle of a stream */
+    int bStarted;               /* the first header was parsed */
+    int bDone;                  /* all of the data was decoded */
+} zt_span;
+
+// Image header of a PNG file (see zt_png_info)
+typedef struct zt_png_header_tag {
+    uint32_t u32Width;
+    uint32_t u32Height;
+    uint32_t u32Pitch;          /* bytes per unfiltered row */
+    uint8_t u8BitDepth;         /* bits per sample (1, 2, 4, 8 or 16) */
+    uint8_t u8ColorType;        /* ZT_PNG_xxx */
+    uint8_t u8Interlace;        /* 1 = Adam7, which zt_png_decode doesn't support */
+    uint8_t u8Bpp;              /* bytes per pixel for the filters (at least 1) */
+} zt_png_header;
+
+// A place to resume decoding from (see zt_index_build)
+typedef struct zt_point_tag {
+    uint64_t u64InBits;     /* bit offset of the block in the compressed data */
+    uint64_t u64OutOffset;  /* offset of the block's data in the output */
+    uint32_t u32WindowHave; /* bytes of history in pWindow */
+    uint8_t *pWindow;       /* the output which precedes the block (up to 32K) */
+} zt_point;
+
+// Random access index of a deflate, zlib or gzip stream
+typedef struct zt_index_tag {
+    uint8_t u8Format;       /* ZT_FORMAT_xxx */
+    uint32_t u32Span;       /* minimum output between access points */
+    uint64_t u64OutSize;    /* total uncompressed size */
+    int iCount;             /* number of access points */
+    int iMax;               /* allocated size of pPoints */
+    zt_point *pPoints;
+    uint8_t *pWork;         /* window + chunk used by zt_index_extract() */
+} zt_index;
+
 #ifdef __cplusplus
 //
 // The UNZIP class wraps portable C code which does the actual work
@@ -141,15 +513,57 @@ typedef struct zt_state_tag {
 class zlib_turbo
 {
   public:
-    void inflate_init(uint8_t *pOut, int iOutSize);
-    int inflate(uint8_t *pIn, int iInSize);
+    zlib_turbo();
+    void set_cache(zt_table_cache *pCache);
+    int set_dictionaries(zt_dict *pDicts, int iCount);
+    int set_dictionary(const uint8_t *pDict, int iSize);
+    void inflate_init(uint8_t *pOut, int iOutSize, int bVerify = 0);
+    void inflate_init(uint8_t *pWindow, int iWindowBits, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser = NULL, int bVerify = 0);
+    void inflate_init(zt_segment *pSegs, int iSegCount, int bVerify = 0);
+    void inflate_init(uint8_t *pOut, int iOutSize, ZT_REALLOC_CALLBACK *pfnRealloc, void *pUser = NULL, int bVerify = 0);
+    int inflate(uint8_t *pIn, int iInSize, int bLast = 1);
     int outSize(void);
+    uint8_t *outBuffer(void);
     uint32_t gzip_info(uint8_t *pCompressed, int iSize, char *szName = NULL, uint32_t *pu32Time = NULL);
-    int gunzip(uint8_t *pCompressed, int iSize, uint8_t *pUncompressed);
-    
+    int detect_format(const uint8_t *pData, size_t iSize);
+    int inflate_auto(uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize = NULL, int bVerify = 0);
+    int gunzip(uint8_t *pCompressed, int iSize, uint8_t *pUncompressed, int bVerify = 0);
+    int gunzip(uint8_t *pCompressed, int iSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser = NULL, int bVerify = 0);
+    int gunzip(uint8_t *pCompressed, int iSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, zt_rows *pRows, int bVerify = 0);
+    int gunzip(uint8_t *pCompressed, int iSize, zt_segment *pSegs, int iSegCount, size_t *piOutSize, int bVerify = 0);
+    int inflate_batch(zt_batch_item *pItems, int iCount, int bVerify = 0);
+    int inflate_mem(uint8_t *pIn, uint64_t u64InSize, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify = 0);
+    int inflate_partial(zt_span *pSpan, uint64_t u64Limit, ZT_ENOUGH_CALLBACK *pfnEnough = NULL, void *pUser = NULL);
+#ifdef ZT_FILES
+    int inflate_file(const char *szIn, const char *szOut, uint64_t *pu64OutSize = NULL, int bVerify = 0);
+    int inflate_file(const char *szIn, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify = 0);
+#endif
+    int gzip_members(uint8_t *pCompressed, size_t iSize, zt_member *pMembers, int iMaxMembers);
+    int png_info(uint8_t *pPNG, size_t iSize, zt_png_header *pHeader);
+    size_t png_work_size(zt_png_header *pHeader);
+    int png_decode(uint8_t *pPNG, size_t iSize, uint8_t *pOut, size_t iPitch, ZT_ROW_CALLBACK *pfnRow, void *pUser, uint8_t *pWork, size_t iWorkSize, int bVerify = 0);
+#ifdef ZT_THREADS
+    int gunzip_parallel(uint8_t *pCompressed, zt_member *pMembers, int iMemberCount, uint8_t *pUncompressed, int iThreads = 0, int bVerify = 0);
+    int inflate_parallel(uint8_t *pCompressed, size_t iSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int iThreads = 0, int bVerify = 0);
+#endif
+    int index_build(uint8_t *pCompressed, size_t iSize, uint32_t u32Span, zt_index **ppIndex);
+    int index_extract(zt_index *pIndex, uint8_t *pCompressed, size_t iSize, uint64_t u64Offset, uint8_t *pOut, int iLen);
+    void index_free(zt_index *pIndex);
+    size_t deflate_work_size(int iLevel);
+    size_t deflate_bound(size_t iInSize, int iFormat);
+    int deflate(uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, uint8_t *pWork, size_t iWorkSize, int iLevel = 6, int iFormat = ZT_FORMAT_GZIP);
+#ifdef ZT_STATS
+    zt_stats *stats(void);
+#endif
+
   private:
     zt_state _state;
     zt_buffer _buffer;
+    uint8_t *_pChunk;
+    int _iChunkSize;
+    ZT_OUTPUT_CALLBACK *_pfnOutput;
+    void *_pUser;
+    zt_table_cache *_pCache;
 }; // zlib_turbo class
 // C interface here
 #endif
@@ -159,8 +573,60 @@ extern "C" {
 #endif
 int zt_inflate(zt_state *state, zt_buffer *buffer, int bEnd);
 int zt_init(zt_state *state);
+int zt_init_window(zt_state *state, uint8_t *pWindow, int iWindowBits);
+int zt_init_segments(zt_state *state, zt_segment *pSegs, int iSegCount);
+int zt_init_grow(zt_state *state, ZT_REALLOC_CALLBACK *pfnRealloc, void *pUser);
+int zt_init_carry(zt_state *state);
+int zt_init_check(zt_state *state, int iCheckType);
+int zt_init_format(zt_state *state, int iFormat);
+int zt_init_cache(zt_state *state, zt_table_cache *pCache);
+int zt_init_dicts(zt_state *state, zt_dict *pDicts, int iCount);
+int zt_init_dict(zt_state *state, const uint8_t *pDict, int iSize);
+int zt_reset(zt_state *state);
+uint32_t zt_crc32(uint32_t u32CRC, const uint8_t *pData, int iLen);
+uint32_t zt_adler32(uint32_t u32Adler, const uint8_t *pData, int iLen);
+int zt_inflate_stream(zt_state *state, zt_buffer *buffer, int bEnd, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser);
+int zt_inflate_segments(zt_state *state, zt_buffer *buffer, int bEnd);
+int zt_inflate_grow(zt_state *state, zt_buffer *buffer, int bEnd);
+uint8_t *zt_realloc(void *pUser, uint8_t *pOld, size_t iOldSize, size_t iNewSize);
 uint32_t zt_gzip_info(uint8_t *pCompressed, int iSize, char *szName, uint32_t *pu32Time);
+int zt_detect_format(const uint8_t *pData, size_t iSize);
+int zt_inflate_auto(zt_state *state, uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int bVerify);
 int zt_gunzip(uint8_t *pCompressed, int iInSize, uint8_t *pUncompressed);
+int zt_gunzip_verify(uint8_t *pCompressed, int iInSize, uint8_t *pUncompressed);
+int zt_gunzip_reuse(zt_state *state, uint8_t *pCompressed, int iInSize, uint8_t *pUncompressed, int bVerify);
+int zt_inflate_batch(zt_state *state, zt_batch_item *pItems, int iCount, int bVerify);
+int zt_inflate_mem(uint8_t *pIn, uint64_t u64InSize, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify);
+int zt_init_span(zt_span *pSpan, uint8_t *pIn, uint64_t u64InSize, uint8_t *pOut, uint64_t u64OutSize, int bVerify);
+int zt_inflate_partial(zt_state *state, zt_span *pSpan, uint64_t u64Limit, ZT_ENOUGH_CALLBACK *pfnEnough, void *pUser);
+#ifdef ZT_FILES
+int zt_inflate_file(const char *szIn, const char *szOut, uint64_t *pu64OutSize, int bVerify);
+int zt_inflate_file_mem(const char *szIn, uint8_t *pOut, uint64_t u64OutSize, uint64_t *pu64OutSize, int bVerify);
+#endif
+int zt_gunzip_stream(uint8_t *pCompressed, int iInSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, ZT_OUTPUT_CALLBACK *pfnOutput, void *pUser, int bVerify);
+int zt_init_rows(zt_rows *pRows, uint8_t *pRow, int iRowSize, ZT_ROW_CALLBACK *pfnRow, ZT_ROW_TRANSFORM *pfnTransform, void *pUser);
+int zt_rows_output(void *pUser, uint8_t *pData, int iLen);
+int zt_rows_flush(zt_rows *pRows);
+void zt_swap16(uint8_t *pData, int iLen);
+int zt_gunzip_rows(uint8_t *pCompressed, int iInSize, uint8_t *pWindow, uint8_t *pChunk, int iChunkSize, zt_rows *pRows, int bVerify);
+int zt_gunzip_segments(uint8_t *pCompressed, int iInSize, zt_segment *pSegs, int iSegCount, size_t *piOutSize, int bVerify);
+int zt_gzip_members(uint8_t *pCompressed, size_t iSize, zt_member *pMembers, int iMaxMembers);
+int zt_png_info(uint8_t *pPNG, size_t iSize, zt_png_header *pHeader);
+size_t zt_png_work_size(zt_png_header *pHeader);
+int zt_png_decode(uint8_t *pPNG, size_t iSize, uint8_t *pOut, size_t iPitch, ZT_ROW_CALLBACK *pfnRow, void *pUser, uint8_t *pWork, size_t iWorkSize, int bVerify);
+int zt_index_build(uint8_t *pCompressed, size_t iSize, uint32_t u32Span, zt_index **ppIndex);
+int zt_index_extract(zt_index *pIndex, uint8_t *pCompressed, size_t iSize, uint64_t u64Offset, uint8_t *pOut, int iLen);
+size_t zt_index_size(zt_index *pIndex);
+size_t zt_index_write(zt_index *pIndex, uint8_t *pData);
+int zt_index_read(uint8_t *pData, size_t iSize, zt_index **ppIndex);
+void zt_index_free(zt_index *pIndex);
+size_t zt_deflate_work_size(int iLevel);
+size_t zt_deflate_bound(size_t iInSize, int iFormat);
+int zt_deflate(uint8_t *pIn, size_t iInSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, uint8_t *pWork, size_t iWorkSize, int iLevel, int iFormat);
+#ifdef ZT_THREADS
+int zt_gunzip_parallel(uint8_t *pCompressed, zt_member *pMembers, int iMemberCount, uint8_t *pUncompressed, int iThreads, int bVerify);
+int zt_inflate_parallel(uint8_t *pCompressed, size_t iSize, uint8_t *pOut, size_t iOutSize, size_t *piOutSize, int iThreads, int bVerify);
+#endif
 #ifdef __cplusplus
 }
 #endif